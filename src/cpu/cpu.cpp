@@ -68,6 +68,11 @@ Uint32 g_expected_elapsed_ms = 0;	// how many ms we expect to have elapsed since
 Uint8 g_active = 0;	// which cpu is currently active
 unsigned int g_uInterleavePerMs = 1; // number of times the cpus switch in 1 ms 
 
+// nothing mapped, so everything goes to the game
+static Uint8 *g_no_pages[PAGE_COUNT] = { NULL };
+Uint8 *const *g_read_page = g_no_pages;
+Uint8 *const *g_write_page = g_no_pages;
+
 // How many milliseconds the CPU emulation is lagging behind.
 // So that OpenGL mode knows when to drop frames to get back up to speed (vsync-enabled only)
 unsigned int g_uCPUMsBehind = 0;
@@ -90,6 +95,35 @@ unsigned int g_uCPUMsBehind = 0;
 
 //////////////////////////////////////////////////////////////////////////////////
 
+// makes 'cpu' the one that is running
+static inline void activate(struct def *cpu)
+{
+	g_active = cpu->id;
+	g_read_page = cpu->read_page;
+	g_write_page = cpu->write_page;
+}
+
+static void map_ranges(struct def *cpu, const struct mem_range *range)
+{
+	for (; range && (range->access != MAP_END); range++)
+	{
+		Uint8 *base = range->base ? range->base : (cpu->mem + range->start);
+
+		for (Uint32 addr = range->start; addr <= range->end; addr += (1 << PAGE_SHIFT))
+		{
+			unsigned int page = (addr >> PAGE_SHIFT) & (PAGE_COUNT - 1);
+			Uint8 *mem = base + (addr - range->start);
+
+			if (range->access == MAP_HANDLER)
+			{
+				cpu->read_page[page] = cpu->write_page[page] = NULL;
+			}
+			if (range->access & MAP_READ) cpu->read_page[page] = mem;
+			if (range->access & MAP_WRITE) cpu->write_page[page] = mem;
+		}
+	}
+}
+
 // adds a cpu to our linked list.  The data is copied, so you can clobber the original data after this call.
 void add (struct def *candidate)
 {
@@ -120,11 +154,20 @@ void add (struct def *candidate)
 	memcpy(cur, candidate, sizeof(struct def));	// copy entire thing over
 	cur->id = g_count;
 	g_count++;
+	memset(cur->read_page, 0, sizeof(cur->read_page));
+	memset(cur->write_page, 0, sizeof(cur->write_page));
+	map_ranges(cur, cur->mem_map);
+	cur->mem_map = NULL;	// the caller's list needn't outlive this call
+	cur->uTimerCount = 0;
+	cur->uPendingInts = 0;
+	cur->pending_nmi_count = 0;
+	memset(cur->pending_irq_count, 0, sizeof(cur->pending_irq_count));
 
 	// DEFAULT VALUES
 	cur->ascii_info_callback = generic_ascii_info_stub;
 	cur->elapsedcycles_callback = generic_elapsedcycles_stub;
 	cur->getpc_callback = NULL;
+	cur->bindcontext_callback = NULL;
 	cur->dasm_callback = generic_dasm_stub;
 	// END DEFAULT VALUES
 
@@ -139,6 +182,7 @@ void add (struct def *candidate)
 		cur->execute_callback = m80_execute;
 		cur->getcontext_callback = m80_get_context;
 		cur->setcontext_callback = m80_set_context;
+		cur->bindcontext_callback = m80_bind_context;
 		cur->getpc_callback = m80_get_pc;
 		cur->setpc_callback = m80_set_pc;
 		cur->elapsedcycles_callback = m80_get_cycles_executed;
@@ -185,6 +229,7 @@ void add (struct def *candidate)
 		cur->execute_callback = nes6502_execute;
 		cur->getcontext_callback = generic_6502_getcontext;
 		cur->setcontext_callback = generic_6502_setcontext;
+		cur->bindcontext_callback = generic_6502_bindcontext;
 		cur->setpc_callback = NULL;
 		cur->getpc_callback = nes6502_get_pc;
 		cur->elapsedcycles_callback = nes6502_getcycles_sofar;
@@ -222,12 +267,27 @@ void add (struct def *candidate)
 	}
 }
 
+// cores that were bound to a cpu's context are still running on it,
+// so move them back onto their own context before it goes away
+static void unbind_all()
+{
+	for (struct def *cur = g_head; cur; cur = cur->next)
+	{
+		if (cur->must_copy_context && cur->bindcontext_callback && g_initialized[cur->type])
+		{
+			(cur->setcontext_callback)(cur->context);
+		}
+	}
+}
+
 // de-allocate all cpu's that have been allocated
 void del_all()
 {
 	struct def *cur = g_head;
 	struct def *tmp = NULL;
 	
+	unbind_all();
+
 	// while we have cpu's left to delete
 	while (cur)
 	{
@@ -237,7 +297,7 @@ void del_all()
 	}
 	g_head = NULL;
 	g_count = 0;
-
+	g_read_page = g_write_page = g_no_pages;
 }
 
 // recalculations all expensive calculations
@@ -268,7 +328,7 @@ void init()
 	
 	while (cur)
 	{
-		g_active = cur->id;
+		activate(cur);
 #ifdef CPU_DIAG
 		cd_old_time[g_active] = refresh_ms_time();
 #endif
@@ -329,6 +389,8 @@ void init()
 void shutdown()
 {
 	struct def *cur = g_head;
+
+	unbind_all();
 	
 	// go through each cpu and shut it down
 	while (cur)
@@ -352,30 +414,249 @@ void shutdown()
 
 
 
+// THE SCHEDULER
+// Every ms is split into g_uInterleavePerMs slices, and every cpu runs up to the end of
+//  the current slice in turn.  The NMI/IRQ timers only tick on ms boundaries, so instead
+//  of testing every timer of every cpu after every slice, each cpu keeps a tiny min-heap
+//  of the slice that its timers next need looking at.  A timer that is behind (period
+//  shorter than a slice) is looked at again on the very next slice, same as before.
+// The slices and the ms boundaries themselves have to stay: cpu's only see each other's
+//  writes, and interrupts raised by generate_nmi/generate_irq, at the end of a slice, and
+//  the ldp/sound clocks (pre_think/update_buffer) advance exactly once per ms.
+
+Uint64 g_now = 0;	// the slice the cpus are running, (ms << 32) | slice (both 1-based)
+
+static inline Uint64 slice_key(Uint32 ms, Uint32 slice)
+{
+	return (((Uint64) ms) << 32) | slice;
+}
+
+static inline bool timer_before(const struct def::timer_event &a, const struct def::timer_event &b)
+{
+	return (a.when < b.when) || ((a.when == b.when) && (a.which < b.which));
+}
+
+static void timer_push(struct def *cpu, Uint64 when, unsigned int which)
+{
+	unsigned int i = cpu->uTimerCount++;
+	struct def::timer_event ev = { when, which };
+
+	// sift up
+	while (i > 0)
+	{
+		unsigned int parent = (i - 1) >> 1;
+		if (!timer_before(ev, cpu->timers[parent])) break;
+		cpu->timers[i] = cpu->timers[parent];
+		i = parent;
+	}
+	cpu->timers[i] = ev;
+}
+
+static unsigned int timer_pop(struct def *cpu)
+{
+	unsigned int which = cpu->timers[0].which;
+	struct def::timer_event last = cpu->timers[--cpu->uTimerCount];
+	unsigned int i = 0;
+
+	// sift down
+	for (;;)
+	{
+		unsigned int child = (i << 1) + 1;
+		if (child >= cpu->uTimerCount) break;
+		if ((child + 1 < cpu->uTimerCount) && timer_before(cpu->timers[child + 1], cpu->timers[child])) child++;
+		if (!timer_before(cpu->timers[child], last)) break;
+		cpu->timers[i] = cpu->timers[child];
+		i = child;
+	}
+	cpu->timers[i] = last;
+
+	return which;
+}
+
+// queues a timer to be looked at once 'uBoundaryMs' has passed, but no sooner than 'earliest'
+static void timer_schedule(struct def *cpu, unsigned int which, Uint32 uBoundaryMs, Uint64 earliest)
+{
+	Uint64 when = slice_key(uBoundaryMs + 1, 1);
+
+	if (when < earliest) when = earliest;
+
+	cpu->bTimerQueued[which] = true;
+	timer_push(cpu, when, which);
+}
+
+// the slice after the current one
+static inline Uint64 next_slice()
+{
+	Uint32 ms = (Uint32) (g_now >> 32);
+	Uint32 slice = (Uint32) g_now;
+
+	return (slice < g_uInterleavePerMs) ? slice_key(ms, slice + 1) : slice_key(ms + 1, 1);
+}
+
+// a timer's period was changed, make sure it is queued if it is ticking
+static void timer_changed(struct def *cpu, unsigned int which)
+{
+	unsigned int uMicroPeriod = which ? cpu->uIRQMicroPeriod[which - 1] : cpu->uNMIMicroPeriod;
+	Uint32 uBoundaryMs = which ? cpu->uIRQTickBoundaryMs[which - 1] : cpu->uNMITickBoundaryMs;
+
+	// if it's already queued, the queued entry will pick up the new period when it ticks
+	if (uMicroPeriod && !cpu->bTimerQueued[which])
+	{
+		timer_schedule(cpu, which, uBoundaryMs, g_now);
+	}
+}
+
+// ticks the timers in 'due' (bit 0 = NMI, bit 1+i = IRQ i) and asserts whatever is pending
+static void service_interrupts(struct def *cpu, unsigned int due)
+{
+	bool nmi_asserted = false;
+
+	// NOW WE CHECK TO SEE IF IT'S TIME TO DO AN NMI
+	if (due & 1)
+	{
+		due &= ~1;
+		cpu->bTimerQueued[0] = false;
+
+		// if NMI's are (still) enabled
+		if (cpu->uNMIMicroPeriod)
+		{
+			++cpu->pending_nmi_count;
+			++cpu->uPendingInts;
+			++cpu->uNMITickCount;
+			cpu->uNMITickBoundaryMs = (Uint32) (( ((Uint64) (cpu->uNMITickCount + 1)) * cpu->uNMIMicroPeriod) / 1000);
+			timer_schedule(cpu, 0, cpu->uNMITickBoundaryMs, next_slice());
+#ifdef CPU_DIAG
+			++cd_nmi_count[cpu->id];
+#endif
+		}
+	}
+
+	// if we have an NMI waiting
+	// (this can be created either by a timer, or by calling generate_nmi)
+	if (cpu->pending_nmi_count != 0)
+	{
+		g_game->do_nmi();
+		nmi_asserted = true;
+		--cpu->pending_nmi_count;
+		--cpu->uPendingInts;
+
+		// the NMI handler may have started an IRQ timer, which still gets looked at below
+		while (cpu->uTimerCount && (cpu->timers[0].when <= g_now))
+		{
+			due |= 1 << timer_pop(cpu);
+		}
+
+		// but the NMI timer has had its turn this slice
+		if (due & 1)
+		{
+			due &= ~1;
+			timer_push(cpu, next_slice(), 0);
+		}
+	}
+
+	// NOW WE CHECK TO SEE IF IT'S TIME TO DO AN IRQ
+
+	// go through each IRQ
+	for (int i = 0; i < MAX_IRQS; i++)
+	{
+		unsigned int bit = 2 << i;
+
+		// if it's time to do an IRQ
+		if (due & bit)
+		{
+			due &= ~bit;
+			cpu->bTimerQueued[i + 1] = false;
+
+			// if IRQ (still) exists
+			if (cpu->uIRQMicroPeriod[i])
+			{
+				++cpu->pending_irq_count[i];
+				++cpu->uPendingInts;
+				++cpu->uIRQTickCount[i];
+				cpu->uIRQTickBoundaryMs[i] = (Uint32) (( ((Uint64) (cpu->uIRQTickCount[i] + 1)) *
+					cpu->uIRQMicroPeriod[i]) / 1000);
+				timer_schedule(cpu, i + 1, cpu->uIRQTickBoundaryMs[i], next_slice());
+#ifdef CPU_DIAG
+				++cd_irq_count[cpu->id][i];
+#endif
+			}
+		}
+
+		// if we have an IRQ waiting
+		// (this can be created either by a timer or by calling generate_irq)
+		if (cpu->pending_irq_count[i] != 0)
+		{
+			// we don't want to do IRQ's and NMI's at the same time
+			if (!nmi_asserted)
+			{
+				g_game->do_irq(i);
+#ifdef DEBUG
+				assert(cpu->pending_irq_count[i] > 0);
+#endif
+				--cpu->pending_irq_count[i];
+				--cpu->uPendingInts;
+				break;	// break out of for loop because we only want to assert 1 IRQ per loop
+			}
+#ifdef DEBUG
+			// make sure NMI's aren't smothering IRQ's
+			else if (cpu->pending_irq_count[i] > 5)
+			{
+				printline("cpu.cpp WARNING : IRQ's are piling up and not having a chance to get used");
+			}
+			// else nothing ...
+#endif
+		}
+	} // end for loop
+
+	// the timers we didn't get to (because an IRQ was asserted) are looked at next slice
+	for (int i = 0; due; i++)
+	{
+		if (due & (2 << i))
+		{
+			due &= ~(2 << i);
+			timer_push(cpu, next_slice(), i + 1);
+		}
+	}
+}
+
 // executes all cpu cores "simultaneously".  this function only returns when the game exits
 void execute()
 {
-	int i = 0;
 	Uint32 last_inputcheck = 0; //time we last polled for input events
 	struct def *cpu = g_head;
 
 	// flush the cpu timers one time so we don't begin with the cpu's running too quickly
 	g_expected_elapsed_ms = 0;
 	g_timer = refresh_ms_time();	// so the cpu doesn't run too quickly when we first start
+	g_now = 0;
 
 	// clear each cpu
 	while (cpu)
 	{
+		cpu->uTimerCount = 0;
+
 		for (int i = 0; i < MAX_IRQS; i++)
 		{
 			cpu->uIRQTickCount[i] = 0;
 			cpu->uIRQTickBoundaryMs[i] = cpu->uIRQMicroPeriod[i] / 1000;	// when the 1st IRQ will tick
-		//	cpu->irq_cycle_count[i] = 0;
+			cpu->bTimerQueued[i + 1] = false;
+			timer_changed(cpu, i + 1);
 		}
 		cpu->uNMITickCount = 0;
 		cpu->uNMITickBoundaryMs = cpu->uNMIMicroPeriod / 1000;	// when the 1st NMI will tick
-		//cpu->nmi_cycle_count = 0;
-		cpu->total_cycles_executed = 0;		
+		cpu->bTimerQueued[0] = false;
+		timer_changed(cpu, 0);
+
+		cpu->uPendingInts = cpu->pending_nmi_count;
+		for (int i = 0; i < MAX_IRQS; i++)
+		{
+			cpu->uPendingInts += cpu->pending_irq_count[i];
+		}
+
+		cpu->uMsCycleBase = 0;
+		cpu->uMsCycleRem = 0;
+		cpu->uMsCycleHz = cpu->hz;
+		cpu->total_cycles_executed = 0;
 		cpu = cpu->next;
 	}
 	// end flushing the cpu timers
@@ -384,35 +665,67 @@ void execute()
 	while (!get_quitflag())
 	{
 		unsigned int actual_elapsed_ms = 0;
-		bool nmi_asserted = false;
 		Uint32 elapsed_cycles = 0;
 		Uint32 cycles_to_execute = 0;	// how many cycles to execute this time around
 
 		// we want to execute enough cycles to reach our expectation for # of elapsed ms
 		g_expected_elapsed_ms++;
 
+		// where each cpu should be at the start of this ms, ((g_expected_elapsed_ms - 1) * hz) / 1000
+		//  kept up to date without a 64-bit multiply and divide per ms
+		for (cpu = g_head; cpu; cpu = cpu->next)
+		{
+			if (g_expected_elapsed_ms == 1) continue;
+
+			if (cpu->uMsCycleHz == cpu->hz)
+			{
+				cpu->uMsCycleBase += cpu->hz / 1000;
+				cpu->uMsCycleRem += cpu->hz % 1000;
+				if (cpu->uMsCycleRem >= 1000)
+				{
+					cpu->uMsCycleRem -= 1000;
+					cpu->uMsCycleBase++;
+				}
+			}
+			// the cpu's speed was changed, so start over
+			else
+			{
+				Uint64 u64Cycles = ((Uint64) (g_expected_elapsed_ms - 1)) * cpu->hz;
+				cpu->uMsCycleBase = u64Cycles / 1000;
+				cpu->uMsCycleRem = (unsigned int) (u64Cycles % 1000);
+				cpu->uMsCycleHz = cpu->hz;
+			}
+		}
+
 		// run all cpu's for 1 ms's worth of cycles, interleaving them according to
 		//  the value of g_uInterlavePerMs.
 		for (unsigned int uInterleaveCount = 1; uInterleaveCount <= g_uInterleavePerMs; uInterleaveCount++)
 		{
+			g_now = slice_key(g_expected_elapsed_ms, uInterleaveCount);
+
 			cpu = g_head;
-			// go through each cpu and execute 1 ms worth of cycles
+			// go through each cpu and execute 1 slice worth of cycles
 			while (cpu)
 			{
 				// if we are required to copy the cpu context, then set the context for the current cpu
 				if (cpu->must_copy_context)
 				{
-					(cpu->setcontext_callback)(cpu->context);	// restore registers
-					(cpu->setmemory_callback)(cpu->mem);	// restore memory we're working with
+					// if the core can run on our copy of the context, just point it there
+					if (cpu->bindcontext_callback)
+					{
+						(cpu->bindcontext_callback)(cpu->context);
+					}
+					else
+					{
+						(cpu->setcontext_callback)(cpu->context);	// restore registers
+						(cpu->setmemory_callback)(cpu->mem);	// restore memory we're working with
+					}
 				}
-				g_active = cpu->id;
-
-				nmi_asserted = false;
+				activate(cpu);
 
-				// NOTE: if g_uInterleavePerMs is 1, then this calculation is the same as
+				// NOTE: if g_uInterleavePerMs is 1, then this is the same as
 				//  (g_expected_elapsed_ms * cpu->hz) / 1000
-				Uint64 u64ExpectedCycles = (( ((Uint64) (g_expected_elapsed_ms - 1)) * cpu->hz) / 1000) +
-					(cpu->uCyclesPerInterleave * uInterleaveCount);
+				Uint64 u64ExpectedCycles = cpu->uMsCycleBase + (cpu->uCyclesPerInterleave * uInterleaveCount);
 
 				if (u64ExpectedCycles > cpu->total_cycles_executed)
 				{
@@ -492,78 +805,19 @@ void execute()
 				cd_avg_mhz[g_active] = (cpu->total_cycles_executed * 0.001) / elapsed_ms_time(g_timer);
 #endif
 
-				// NOW WE CHECK TO SEE IF IT'S TIME TO DO AN NMI
-
-				// if NMI's are enabled
-				if (cpu->uNMIMicroPeriod)
+				// pull off the timers that are due this slice
+				unsigned int due = 0;
+				while (cpu->uTimerCount && (cpu->timers[0].when <= g_now))
 				{
-					if (g_expected_elapsed_ms > cpu->uNMITickBoundaryMs)
-					{
-						++cpu->pending_nmi_count;
-						++cpu->uNMITickCount;
-						cpu->uNMITickBoundaryMs = (Uint32) (( ((Uint64) (cpu->uNMITickCount + 1)) * cpu->uNMIMicroPeriod) / 1000);
-#ifdef CPU_DIAG
-						++cd_nmi_count[cpu->id];
-#endif
-					}
+					due |= 1 << timer_pop(cpu);
 				}
 
-				// if we have an NMI waiting
-				// (this can be created either by a timer, or by calling generate_nmi)
-				if (cpu->pending_nmi_count != 0)
+				// most slices have nothing to do
+				if (due || cpu->uPendingInts)
 				{
-					g_game->do_nmi();
-					nmi_asserted = true;
-					--cpu->pending_nmi_count;
+					service_interrupts(cpu, due);
 				}
 
-				// NOW WE CHECK TO SEE IF IT'S TIME TO DO AN IRQ
-
-				// go through each IRQ
-				for (i = 0; i < MAX_IRQS; i++)
-				{
-					// if IRQ exists
-					if (cpu->uIRQMicroPeriod[i])
-					{
-						// if it's time to do an IRQ
-						if (g_expected_elapsed_ms > cpu->uIRQTickBoundaryMs[i])
-						{
-							++cpu->pending_irq_count[i];
-							++cpu->uIRQTickCount[i];
-							cpu->uIRQTickBoundaryMs[i] = (Uint32) (( ((Uint64) (cpu->uIRQTickCount[i] + 1)) *
-								cpu->uIRQMicroPeriod[i]) / 1000);
-#ifdef CPU_DIAG
-							++cd_irq_count[cpu->id][i];
-#endif
-						}
-					} // end if there is an IRQ timer
-
-					// if we have an IRQ waiting
-					// (this can be created either by a timer or by calling generate_irq)
-					if (cpu->pending_irq_count[i] != 0)
-					{
-						// we don't want to do IRQ's and NMI's at the same time
-						if (!nmi_asserted)
-						{
-							g_game->do_irq(i);
-#ifdef DEBUG
-							assert(cpu->pending_irq_count[i] > 0);
-#endif
-							--cpu->pending_irq_count[i];
-							break;	// break out of for loop because we only want to assert 1 IRQ per loop
-						}
-#ifdef DEBUG
-						// make sure NMI's aren't smothering IRQ's
-						else if (cpu->pending_irq_count[i] > 5)
-						{
-							printline("cpu.cpp WARNING : IRQ's are piling up and not having a chance to get used");
-						}
-						// else nothing ...
-#endif
-					}
-				} // end for loop
-				// END CHECK FOR IRQ
-
 				// this chunk of code tests to make sure the CPU is running
 				// at the proper speed.  It should be undef'd unless we are debugging cpu stuff
 
@@ -608,7 +862,7 @@ void execute()
 
 
 				// if we are required to copy the cpu context, then preserve the context for the next time around
-				if (cpu->must_copy_context)
+				if (cpu->must_copy_context && !cpu->bindcontext_callback)
 				{
 					(cpu->getcontext_callback)(cpu->context);	// preserve registers
 				}
@@ -871,6 +1125,20 @@ Uint32 get_hz(Uint8 id)
 	return result;
 }
 
+void map_memory(Uint8 id, const struct mem_range *ranges)
+{
+	struct def *cpu = get_struct(id);
+
+	if (cpu)
+	{
+		map_ranges(cpu, ranges);
+	}
+	else
+	{
+		fprintf(stderr, "ERROR : Attempted to map memory for cpu %d which does not exist\n", id);
+	}
+}
+
 void change_nmi(Uint8 id, double new_period)
 {
 	struct def *cpu = get_struct(id);
@@ -879,6 +1147,7 @@ void change_nmi(Uint8 id, double new_period)
 	{
 		cpu->nmi_period = new_period;
 		recalc();
+		timer_changed(cpu, 0);
 	}
 	else
 	{
@@ -895,6 +1164,7 @@ void generate_nmi(Uint8 id)
 #endif
 
 	cpu->pending_nmi_count++;
+	cpu->uPendingInts++;
 }
 
 void change_irq(Uint8 id, unsigned int which_irq, double new_period)
@@ -911,6 +1181,7 @@ void change_irq(Uint8 id, unsigned int which_irq, double new_period)
 
 	cpu->irq_period[which_irq] = new_period;
 	recalc();
+	timer_changed(cpu, which_irq + 1);
 //	cpu->cycles_per_irq[which_irq] = (Uint32) (cpu->cycles_per_ms * cpu->irq_period[which_irq]);
 //	cpu->irq_cycle_count[which_irq] = 0;
 
@@ -929,6 +1200,7 @@ void generate_irq(Uint8 id, unsigned int which_irq)
 #endif
 
 	cpu->pending_irq_count[which_irq]++;
+	cpu->uPendingInts++;
 }
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -987,6 +1259,12 @@ void generic_6502_setcontext(void *context_buf)
 	g_6502->SetContext( (NES_6502::Context *) context_buf);
 }
 
+// the memory pages and handlers are part of the context, so nothing else needs restoring
+void generic_6502_bindcontext(void *context_buf)
+{
+	nes6502_bindcontext((NES_6502::Context *) context_buf);
+}
+
 // returns an ASCII string giving info about registers and other stuff ...
 const char *generic_6502_info(void *unused, int regnum)
 {
@@ -1063,6 +1341,7 @@ void reset_globals()
 		g_initialized[i] = false;
 	g_expected_elapsed_ms = 0;
 	g_active = 0;
+	g_read_page = g_write_page = g_no_pages;
 }
 
 void change_interleave(unsigned int uInterleave)
@@ -39,6 +39,31 @@ static const int MAX_CONTEXT_SIZE = 128;
 /* how many IRQs we will support per CPU */
 static const int MAX_IRQS = 4;
 
+/* the 16-bit address space is mapped in pages of this many bytes (see mem_range) */
+static const int PAGE_SHIFT = 8;
+static const int PAGE_COUNT = 0x10000 >> PAGE_SHIFT;
+
+// what a mem_range does
+enum
+{
+	MAP_END,	// ends a list of ranges
+	MAP_READ,	// reads come straight from memory
+	MAP_WRITE,	// writes go straight to memory
+	MAP_RAM,	// both
+	MAP_HANDLER	// back to the game's cpu_mem_read/cpu_mem_write
+};
+
+// A range of a 16-bit address space that is plain memory, so the core can read/write it
+//  directly instead of calling game::cpu_mem_read/cpu_mem_write for every byte.
+// start and end+1 must be on page boundaries.  Anything not mapped goes to the game.
+struct mem_range
+{
+	Uint32 start;
+	Uint32 end;	// last address of the range
+	int access;	// MAP_READ etc
+	Uint8 *base;	// where 'start' lives, NULL for def::mem + start
+};
+
 struct def;
 
 // structure that defines parameters for each cpu hypseus uses
@@ -52,6 +77,7 @@ struct def
 	double nmi_period;	// how often the NMI ticks (in milliseconds, not seconds)
 	double irq_period[MAX_IRQS];	// how often the IRQs tick (in milliseconds, not seconds)
 	Uint8 *mem;	// where the cpu's memory begins
+	const struct mem_range *mem_map;	// optional, plain memory ranges ended by MAP_END (only used by add)
 
 	// these should not be modified externally
 	Uint8 id;	// which we are adding
@@ -61,6 +87,7 @@ struct def
 	Uint32 (*execute_callback)(Uint32);	// callback to execute cycles for this particular cpu
 	Uint32 (*getcontext_callback)(void *);	// callback to get a cpu's context
 	void (*setcontext_callback)(void *);	// callback to set a cpu's context
+	void (*bindcontext_callback)(void *);	// optional, makes the core run straight on a context from getcontext_callback (no copying)
 	Uint32 (*getpc_callback)();	// callback to get the program counter
 	void (*setpc_callback)(Uint32);	// callback to set the program counter
 	Uint32 (*elapsedcycles_callback)();	// callback to get the # of elapsed cycles
@@ -83,7 +110,23 @@ struct def
 	unsigned int uEventCyclesEnd;	// when event tracking ends and optional event fires (0 if no event)
 	void (*event_callback)(void *data);	// callback we call when optional event fires
 	void *event_data;	// whatever data we are supposed to pass back to the event callback
-	Uint8 context[MAX_CONTEXT_SIZE];	// the cpu's context (in case we were forced to copy it out)
+
+	// scheduler state (see execute()), these should not be modified externally either
+	Uint64 uMsCycleBase;	// cycles that should have run by the start of the current ms
+	unsigned int uMsCycleRem;	// the part of a cycle that uMsCycleBase is short by, in thousandths
+	Uint32 uMsCycleHz;	// the hz that uMsCycleBase was computed with
+	unsigned int uPendingInts;	// pending_nmi_count plus all of pending_irq_count
+	struct timer_event
+	{
+		Uint64 when;	// (ms << 32) | slice, when the timer next needs to be looked at
+		unsigned int which;	// 0 is the NMI, 1 and up are the IRQs
+	} timers[MAX_IRQS + 1];	// min-heap of the NMI/IRQ timers that are ticking
+	unsigned int uTimerCount;	// how many entries timers has
+	bool bTimerQueued[MAX_IRQS + 1];	// whether a timer has an entry in timers
+
+	Uint8 *read_page[PAGE_COUNT];	// memory for each page that is read directly, NULL to use the game's handler
+	Uint8 *write_page[PAGE_COUNT];	// same for writes
+	alignas(16) Uint8 context[MAX_CONTEXT_SIZE];	// the cpu's context (in case we were forced to copy it out), cores may be bound to it
 	struct def *next;	// pointer to the next cpu in this linked list
 };
 
@@ -107,6 +150,13 @@ unsigned char get_active();
 Uint8 *get_mem(Uint8 id);
 Uint32 get_hz(Uint8 id);
 
+// Changes the memory map of a cpu at runtime (for bank switching), see mem_range
+void map_memory(Uint8 id, const struct mem_range *ranges);
+
+// the page tables of the active cpu, for the cores
+extern Uint8 *const *g_read_page;
+extern Uint8 *const *g_write_page;
+
 void change_nmi(Uint8 id, double new_period);
 
 // Generates an NMI at the next possible opportunity for the indicated cpu.
@@ -126,6 +176,7 @@ void generic_6502_reset();
 void generic_6502_setmemory(Uint8 *buf);
 Uint32 generic_6502_getcontext(void *context_buf);
 void generic_6502_setcontext(void *context_buf);
+void generic_6502_bindcontext(void *context_buf);
 const char *generic_6502_info(void *context, int regnum);
 Uint32 generic_elapsedcycles_stub();
 const char *generic_ascii_info_stub(void *, int);
@@ -38,6 +38,7 @@
 #ifdef INTEGRATE
 #include "mamewrap.h"
 #include "cpu-debug.h"
+#include "cpu.h"	// for the page tables
 
 #else
 
@@ -80,6 +81,7 @@ struct m80_context
 	/* if this flag is true, no interrupts will be issued until after the next instruction */
 	/* EI masks all interrupts for the proceeding instruction */
 	/* (see Sean Young's undocumented z80 document for explanation of this behavior) */
+	Uint8 *opcode_base;	/* the memory this cpu runs from (so m80_bind_context can restore it) */
 };
 
 #define C_FLAG	1
@@ -93,32 +95,32 @@ struct m80_context
 #define S_FLAG	128
 
 // I _hate_ macros but these just plain make the code look better =)
-#define FLAGS	g_context.m80_regs[M80_AF].b.l
-#define A		g_context.m80_regs[M80_AF].b.h
-#define AF		g_context.m80_regs[M80_AF].w
-#define AFPRIME	g_context.m80_regs[M80_AFPRIME].w
-#define B		g_context.m80_regs[M80_BC].b.h
-#define C		g_context.m80_regs[M80_BC].b.l
-#define BC		g_context.m80_regs[M80_BC].w
-#define BCPRIME	g_context.m80_regs[M80_BCPRIME].w
-#define D		g_context.m80_regs[M80_DE].b.h
-#define E		g_context.m80_regs[M80_DE].b.l
-#define DE		g_context.m80_regs[M80_DE].w
-#define DEPRIME	g_context.m80_regs[M80_DEPRIME].w
-#define H		g_context.m80_regs[M80_HL].b.h
-#define L		g_context.m80_regs[M80_HL].b.l
-#define HL		g_context.m80_regs[M80_HL].w
-#define HLPRIME	g_context.m80_regs[M80_HLPRIME].w
-#define PC		g_context.m80_regs[M80_PC].w
-#define SP		g_context.m80_regs[M80_SP].w
-#define R		g_context.m80_regs[M80_RI].b.h
-#define I		g_context.m80_regs[M80_RI].b.l
-#define IXh	g_context.m80_regs[M80_IX].b.h
-#define IXl	g_context.m80_regs[M80_IX].b.l
-#define IX	g_context.m80_regs[M80_IX].w
-#define IYh	g_context.m80_regs[M80_IY].b.h
-#define IYl	g_context.m80_regs[M80_IY].b.l
-#define IY	g_context.m80_regs[M80_IY].w
+#define FLAGS	g_context->m80_regs[M80_AF].b.l
+#define A		g_context->m80_regs[M80_AF].b.h
+#define AF		g_context->m80_regs[M80_AF].w
+#define AFPRIME	g_context->m80_regs[M80_AFPRIME].w
+#define B		g_context->m80_regs[M80_BC].b.h
+#define C		g_context->m80_regs[M80_BC].b.l
+#define BC		g_context->m80_regs[M80_BC].w
+#define BCPRIME	g_context->m80_regs[M80_BCPRIME].w
+#define D		g_context->m80_regs[M80_DE].b.h
+#define E		g_context->m80_regs[M80_DE].b.l
+#define DE		g_context->m80_regs[M80_DE].w
+#define DEPRIME	g_context->m80_regs[M80_DEPRIME].w
+#define H		g_context->m80_regs[M80_HL].b.h
+#define L		g_context->m80_regs[M80_HL].b.l
+#define HL		g_context->m80_regs[M80_HL].w
+#define HLPRIME	g_context->m80_regs[M80_HLPRIME].w
+#define PC		g_context->m80_regs[M80_PC].w
+#define SP		g_context->m80_regs[M80_SP].w
+#define R		g_context->m80_regs[M80_RI].b.h
+#define I		g_context->m80_regs[M80_RI].b.l
+#define IXh	g_context->m80_regs[M80_IX].b.h
+#define IXl	g_context->m80_regs[M80_IX].b.l
+#define IX	g_context->m80_regs[M80_IX].w
+#define IYh	g_context->m80_regs[M80_IY].b.h
+#define IYl	g_context->m80_regs[M80_IY].b.l
+#define IY	g_context->m80_regs[M80_IY].w
 
 #ifdef CPU_DEBUG
 #define M80_ERROR(MESSAGE)	printf(MESSAGE); printf("Opcode %x at PC %x\n", opcode_base[PC-1], PC-1)
@@ -135,26 +137,41 @@ struct m80_context
 #define M80_CHANGE_PC(newpc)
 #endif // CPU_DEBUG
 
-// returns a byte from memory
+// returns a byte from memory, straight from the page table when the game has mapped it
 #define M80_READ_BYTE(addr)	\
-	cpu_readmem16(addr)	\
+	m80_read_byte(addr)	\
 /*	opcode_base[addr] */
 
 // read Z80 memory into 16-bit z80 register
 #define M80_READ_WORD(addr, reg_index)	\
-	g_context.m80_regs[reg_index].b.l = M80_READ_BYTE(addr);	\
-	g_context.m80_regs[reg_index].b.h = M80_READ_BYTE(addr+1)
+	g_context->m80_regs[reg_index].b.l = M80_READ_BYTE(addr);	\
+	g_context->m80_regs[reg_index].b.h = M80_READ_BYTE(addr+1)
 
 // writes an 8-bit byte into z80 memory
 // addr is where to write, val is which value to write
 #define M80_WRITE_BYTE(addr, val)	\
-	cpu_writemem16(addr, val)	\
+	m80_write_byte(addr, val)	\
 /*	opcode_base[addr] = val */
 
+static inline Uint8 m80_read_byte(Uint16 addr)
+{
+	const Uint8 *page = cpu::g_read_page[addr >> cpu::PAGE_SHIFT];
+
+	return page ? page[addr & ((1 << cpu::PAGE_SHIFT) - 1)] : cpu_readmem16(addr);
+}
+
+static inline void m80_write_byte(Uint16 addr, Uint8 val)
+{
+	Uint8 *page = cpu::g_write_page[addr >> cpu::PAGE_SHIFT];
+
+	if (page) page[addr & ((1 << cpu::PAGE_SHIFT) - 1)] = val;
+	else cpu_writemem16(addr, val);
+}
+
 // write 16-bit z80 reg into Z80 memory
 #define M80_WRITE_WORD(addr, reg_index)	\
-	M80_WRITE_BYTE(addr, g_context.m80_regs[reg_index].b.l);	\
-	M80_WRITE_BYTE(addr+1, g_context.m80_regs[reg_index].b.h)
+	M80_WRITE_BYTE(addr, g_context->m80_regs[reg_index].b.l);	\
+	M80_WRITE_BYTE(addr+1, g_context->m80_regs[reg_index].b.h)
 
 #define M80_GET_ARG opcode_base[PC++]
 #define M80_PEEK_ARG opcode_base[PC]
@@ -169,14 +186,14 @@ struct m80_context
 
 // Interrupt check macro
 #define CHECK_INTERRUPT	\
-	if (g_context.nmi_state == ASSERT_LINE) /* NMI takes priority over IRQ so check it first */	\
+	if (g_context->nmi_state == ASSERT_LINE) /* NMI takes priority over IRQ so check it first */	\
 	{	\
 		m80_activate_nmi();	\
 	}	\
-	else if (g_context.irq_state == ASSERT_LINE)	\
+	else if (g_context->irq_state == ASSERT_LINE)	\
 	{	\
 		/* we can only do an IRQ if IFF1 flipflop is set */	\
-		if (g_context.IFF1)	\
+		if (g_context->IFF1)	\
 		{	\
 			m80_activate_irq();	\
 		}	\
@@ -196,23 +213,23 @@ struct m80_context
 // Enable Maskable Interrupt macro
 #define M80_EI	\
 	/* IFF1 and IFF2 are simultaneously set by EI */	\
-	g_context.IFF1 = 1;	\
-	g_context.IFF2 = 1;	\
-	g_context.got_EI = 1;	/* the next instruction must not be interrupted */
+	g_context->IFF1 = 1;	\
+	g_context->IFF2 = 1;	\
+	g_context->got_EI = 1;	/* the next instruction must not be interrupted */
 
 // Disable Maskable Interrupt macro
 #define M80_DI	\
-	g_context.IFF1 = 0;	\
-	g_context.IFF2 = 0;	\
-/*	g_context.got_EI = 1; */	/* it's DI, but we still need the same action */
+	g_context->IFF1 = 0;	\
+	g_context->IFF2 = 0;	\
+/*	g_context->got_EI = 1; */	/* it's DI, but we still need the same action */
 
-// FIXME: I removed the above g_context.got_EI in order to compare exactly with mame's core
-// but I believe mame has a bug in this regard and that the g_context.got_EI should be uncommencted
+// FIXME: I removed the above g_context->got_EI in order to compare exactly with mame's core
+// but I believe mame has a bug in this regard and that the g_context->got_EI should be uncommencted
 // once we're done debugging
 
 // Macro to go into HALT mode
 #define M80_START_HALT	\
-	g_context.halted = 1;	\
+	g_context->halted = 1;	\
 	PC--;	\
 	/* move PC so it's pointing back to this HALT statement, so next time instruction executes, */	\
 	/* it comes to this HALT again */	\
@@ -220,7 +237,7 @@ struct m80_context
 	/* If we didn't just barely get an EI */	\
 	/* instruction, then interrupts won't be set this time around and we */	\
 	/* can safely use up the rest of the cycles quickly. */	\
-	if (!g_context.got_EI)	\
+	if (!g_context->got_EI)	\
 	{	\
 		int remaining = g_cycles_to_execute - g_cycles_executed;	\
 		/* if we still have cycles that need to be used up */	\
@@ -234,9 +251,9 @@ struct m80_context
 
 // macro to check to see if we're halted and if so, fix the PC and unhalt us
 #define M80_STOP_HALT	\
-	if (g_context.halted)	\
+	if (g_context->halted)	\
 	{	\
-		g_context.halted = 0;	\
+		g_context->halted = 0;	\
 		PC++;	\
 	}
 
@@ -1699,26 +1699,33 @@ static void trap();
 static void cd10();
 static void cd11();
 
+/* the unprefixed opcodes (OP(opcode, handler)), the 0x10 and 0x11 pages follow them in code[] */
+#define MC6809_OPCODES(OP) \
+OP(0x00,negm) OP(0x01,what) OP(0x02,trap) OP(0x03,comm) OP(0x04,lsrm) OP(0x05,what) OP(0x06,rorm) OP(0x07,asrm) OP(0x08,aslm) OP(0x09,rolm) OP(0x0A,decm) OP(0x0B,what) OP(0x0C,incm) OP(0x0D,tstm) OP(0x0E,jmpm) OP(0x0F,clrm) \
+OP(0x10,cd10) OP(0x11,cd11) OP(0x12,nopm) OP(0x13,synm) OP(0x14,what) OP(0x15,what) OP(0x16,lbra) OP(0x17,lbsr) OP(0x18,what) OP(0x19,daam) OP(0x1A,orcc) OP(0x1B,what) OP(0x1C,andc) OP(0x1D,sexm) OP(0x1E,exgm) OP(0x1F,tfrm) \
+OP(0x20,bras) OP(0x21,brns) OP(0x22,bhis) OP(0x23,blss) OP(0x24,bccs) OP(0x25,blos) OP(0x26,bnes) OP(0x27,beqs) OP(0x28,bvcs) OP(0x29,bvss) OP(0x2A,bpls) OP(0x2B,bmis) OP(0x2C,bges) OP(0x2D,blts) OP(0x2E,bgts) OP(0x2F,bles) \
+OP(0x30,leax) OP(0x31,leay) OP(0x32,leas) OP(0x33,leau) OP(0x34,pshs) OP(0x35,puls) OP(0x36,pshu) OP(0x37,pulu) OP(0x38,what) OP(0x39,rtsm) OP(0x3A,abxm) OP(0x3B,rtim) OP(0x3C,cwai) OP(0x3D,mulm) OP(0x3E,what) OP(0x3F,swim) \
+OP(0x40,nega) OP(0x41,what) OP(0x42,what) OP(0x43,coma) OP(0x44,lsra) OP(0x45,what) OP(0x46,rora) OP(0x47,asra) OP(0x48,asla) OP(0x49,rola) OP(0x4A,::deca) OP(0x4B,what) OP(0x4C,inca) OP(0x4D,tsta) OP(0x4E,what) OP(0x4F,clra) \
+OP(0x50,negb) OP(0x51,what) OP(0x52,what) OP(0x53,comb) OP(0x54,lsrb) OP(0x55,what) OP(0x56,rorb) OP(0x57,asrb) OP(0x58,aslb) OP(0x59,rolb) OP(0x5A,decb) OP(0x5B,what) OP(0x5C,incb) OP(0x5D,tstb) OP(0x5E,what) OP(0x5F,clrb) \
+OP(0x60,negm) OP(0x61,what) OP(0x62,what) OP(0x63,comm) OP(0x64,lsrm) OP(0x65,what) OP(0x66,rorm) OP(0x67,asrm) OP(0x68,aslm) OP(0x69,rolm) OP(0x6A,decm) OP(0x6B,what) OP(0x6C,incm) OP(0x6D,tstm) OP(0x6E,jmpm) OP(0x6F,clrm) \
+OP(0x70,negm) OP(0x71,what) OP(0x72,what) OP(0x73,comm) OP(0x74,lsrm) OP(0x75,what) OP(0x76,rorm) OP(0x77,asrm) OP(0x78,aslm) OP(0x79,rolm) OP(0x7A,decm) OP(0x7B,what) OP(0x7C,incm) OP(0x7D,tstm) OP(0x7E,jmpm) OP(0x7F,clrm) \
+OP(0x80,suba) OP(0x81,cmpa) OP(0x82,sbca) OP(0x83,subd) OP(0x84,anda) OP(0x85,bita) OP(0x86,ldam) OP(0x87,what) OP(0x88,eora) OP(0x89,adca) OP(0x8A,oram) OP(0x8B,adda) OP(0x8C,cmpx) OP(0x8D,bsrm) OP(0x8E,ldxm) OP(0x8F,what) \
+OP(0x90,suba) OP(0x91,cmpa) OP(0x92,sbca) OP(0x93,subd) OP(0x94,anda) OP(0x95,bita) OP(0x96,ldam) OP(0x97,stam) OP(0x98,eora) OP(0x99,adca) OP(0x9A,oram) OP(0x9B,adda) OP(0x9C,cmpx) OP(0x9D,jsrm) OP(0x9E,ldxm) OP(0x9F,stxm) \
+OP(0xA0,suba) OP(0xA1,cmpa) OP(0xA2,sbca) OP(0xA3,subd) OP(0xA4,anda) OP(0xA5,bita) OP(0xA6,ldam) OP(0xA7,stam) OP(0xA8,eora) OP(0xA9,adca) OP(0xAA,oram) OP(0xAB,adda) OP(0xAC,cmpx) OP(0xAD,jsrm) OP(0xAE,ldxm) OP(0xAF,stxm) \
+OP(0xB0,suba) OP(0xB1,cmpa) OP(0xB2,sbca) OP(0xB3,subd) OP(0xB4,anda) OP(0xB5,bita) OP(0xB6,ldam) OP(0xB7,stam) OP(0xB8,eora) OP(0xB9,adca) OP(0xBA,oram) OP(0xBB,adda) OP(0xBC,cmpx) OP(0xBD,jsrm) OP(0xBE,ldxm) OP(0xBF,stxm) \
+OP(0xC0,subb) OP(0xC1,cmpb) OP(0xC2,sbcb) OP(0xC3,addd) OP(0xC4,andb) OP(0xC5,bitb) OP(0xC6,ldbm) OP(0xC7,what) OP(0xC8,eorb) OP(0xC9,adcb) OP(0xCA,orbm) OP(0xCB,addb) OP(0xCC,lddm) OP(0xCD,what) OP(0xCE,ldum) OP(0xCF,what) \
+OP(0xD0,subb) OP(0xD1,cmpb) OP(0xD2,sbcb) OP(0xD3,addd) OP(0xD4,andb) OP(0xD5,bitb) OP(0xD6,ldbm) OP(0xD7,stbm) OP(0xD8,eorb) OP(0xD9,adcb) OP(0xDA,orbm) OP(0xDB,addb) OP(0xDC,lddm) OP(0xDD,stdm) OP(0xDE,ldum) OP(0xDF,stum) \
+OP(0xE0,subb) OP(0xE1,cmpb) OP(0xE2,sbcb) OP(0xE3,addd) OP(0xE4,andb) OP(0xE5,bitb) OP(0xE6,ldbm) OP(0xE7,stbm) OP(0xE8,eorb) OP(0xE9,adcb) OP(0xEA,orbm) OP(0xEB,addb) OP(0xEC,lddm) OP(0xED,stdm) OP(0xEE,ldum) OP(0xEF,stum) \
+OP(0xF0,subb) OP(0xF1,cmpb) OP(0xF2,sbcb) OP(0xF3,addd) OP(0xF4,andb) OP(0xF5,bitb) OP(0xF6,ldbm) OP(0xF7,stbm) OP(0xF8,eorb) OP(0xF9,adcb) OP(0xFA,orbm) OP(0xFB,addb) OP(0xFC,lddm) OP(0xFD,stdm) OP(0xFE,ldum) OP(0xFF,stum)
+
+#define MC6809_CODE(n, f) f,
+
 //static void (*code[])(void);
 static void (*code[])(void)=
-{negm,what,trap,comm,lsrm,what,rorm,asrm,aslm,rolm,decm,what,incm,tstm,jmpm,clrm
-,cd10,cd11,nopm,synm,what,what,lbra,lbsr,what,daam,orcc,what,andc,sexm,exgm,tfrm
-,bras,brns,bhis,blss,bccs,blos,bnes,beqs,bvcs,bvss,bpls,bmis,bges,blts,bgts,bles
-,leax,leay,leas,leau,pshs,puls,pshu,pulu,what,rtsm,abxm,rtim,cwai,mulm,what,swim
-,nega,what,what,coma,lsra,what,rora,asra,asla,rola,::deca,what,inca,tsta,what,clra
-,negb,what,what,comb,lsrb,what,rorb,asrb,aslb,rolb,decb,what,incb,tstb,what,clrb
-,negm,what,what,comm,lsrm,what,rorm,asrm,aslm,rolm,decm,what,incm,tstm,jmpm,clrm
-,negm,what,what,comm,lsrm,what,rorm,asrm,aslm,rolm,decm,what,incm,tstm,jmpm,clrm
-,suba,cmpa,sbca,subd,anda,bita,ldam,what,eora,adca,oram,adda,cmpx,bsrm,ldxm,what
-,suba,cmpa,sbca,subd,anda,bita,ldam,stam,eora,adca,oram,adda,cmpx,jsrm,ldxm,stxm
-,suba,cmpa,sbca,subd,anda,bita,ldam,stam,eora,adca,oram,adda,cmpx,jsrm,ldxm,stxm
-,suba,cmpa,sbca,subd,anda,bita,ldam,stam,eora,adca,oram,adda,cmpx,jsrm,ldxm,stxm
-,subb,cmpb,sbcb,addd,andb,bitb,ldbm,what,eorb,adcb,orbm,addb,lddm,what,ldum,what
-,subb,cmpb,sbcb,addd,andb,bitb,ldbm,stbm,eorb,adcb,orbm,addb,lddm,stdm,ldum,stum
-,subb,cmpb,sbcb,addd,andb,bitb,ldbm,stbm,eorb,adcb,orbm,addb,lddm,stdm,ldum,stum
-,subb,cmpb,sbcb,addd,andb,bitb,ldbm,stbm,eorb,adcb,orbm,addb,lddm,stdm,ldum,stum
+{
+MC6809_OPCODES(MC6809_CODE)
 
-,what,what,what,what,what,what,what,what,what,what,what,what,what,what,what,what
+what,what,what,what,what,what,what,what,what,what,what,what,what,what,what,what
 ,what,what,what,what,what,what,what,what,what,what,what,what,what,what,what,what
 ,what,lbrn,lbhi,lbls,lbcc,lblo,lbne,lbeq,lbvc,lbvs,lbpl,lbmi,lbge,lblt,lbgt,lble
 ,what,what,what,what,what,what,what,what,what,what,what,what,what,what,what,swi2
@@ -1962,6 +1969,38 @@ void mc6809_Init(const struct MC6809_INTERFACE *interface)
 }
 
 
+/* threaded dispatch needs labels as values (gcc and clang), the debugger and the */
+/* trace hook every instruction so they keep the loop.  The 0x10/0x11 pages are */
+/* still reached through code[] by cd10() and cd11(). */
+#if defined(__GNUC__) && !defined(CPU_DEBUG) && !defined(DEBUG)
+#define MC6809_THREADED
+#endif
+
+#ifdef MC6809_THREADED
+#define MC6809_LABEL_ADDR(n, f) &&mc6809_op_##n,
+#define MC6809_LABEL(n, f) mc6809_op_##n: f(); MC6809_DISPATCH;
+
+/* ends an opcode by fetching the next one and jumping straight to it, so each opcode */
+/* gets its own (better predicted) indirect branch.  Same steps as the loop below. */
+#define MC6809_DISPATCH \
+    if (ncycles <= (cpu_clock-start_clock)) goto mc6809_done; \
+    if (cpu_clock>=cpu_timer) \
+        TimerCallback(timer_data); \
+    if (mc6809_nmi) \
+        do_nmi(); \
+    else if (mc6809_firq) \
+        do_firq(); \
+    else if (mc6809_irq) \
+        do_irq(); \
+    FetchInstr(pc, fetch_buffer); \
+    op=(signed char*) fetch_buffer; \
+    r=(*(op++))&0xFF; \
+    ad=adr[r]; \
+    cpu_clock+=cpu_cycles[r]; \
+    pc+=taille[r]; \
+    goto *mc6809_op_labels[r]
+#endif // MC6809_THREADED
+
 /*
  * mc6809_StepExec: xcute un nombre donn d'instructions et retourne le
  *                  nombre de cycles ncessaires  leur xcution
@@ -1977,6 +2016,13 @@ unsigned int mc6809_StepExec(unsigned int ncycles)
 //    register unsigned int i;
                       int r;
 
+#ifdef MC6809_THREADED
+    static const void *const mc6809_op_labels[256] = { MC6809_OPCODES(MC6809_LABEL_ADDR) };
+
+    MC6809_DISPATCH;
+    MC6809_OPCODES(MC6809_LABEL)
+mc6809_done:
+#else
 //	for (i=0; i<ninst; i++)
     while (ncycles > (cpu_clock-start_clock))
 	{
@@ -2015,6 +2061,7 @@ unsigned int mc6809_StepExec(unsigned int ncycles)
         /* on xcute l'instruction */
         (*code[r])();
     }
+#endif // MC6809_THREADED
 
     return cpu_clock-start_clock;
 }
@@ -75,7 +75,7 @@
 #define  ADD_CYCLES(x) \
 { \
    remaining_cycles -= (x); \
-   cpu.total_cycles += (x); \
+   cpu->total_cycles += (x); \
 }
 
 /*
@@ -572,10 +572,10 @@
 { \
    i_flag = 0; \
    ADD_CYCLES(2); \
-   if (cpu.int_pending && (remaining_cycles > 0)) \
+   if (cpu->int_pending && (remaining_cycles > 0)) \
    { \
       IRQ(); \
-      cpu.int_pending = 0; \
+      cpu->int_pending = 0; \
    } \
 }
 
@@ -702,8 +702,8 @@
 #define JAM() \
 { \
    PC--; \
-   cpu.jammed = TRUE; \
-   cpu.int_pending = 0; \
+   cpu->jammed = TRUE; \
+   cpu->int_pending = 0; \
    ADD_CYCLES(2); \
 }
 #endif /* !NES6502_TESTOPS */
@@ -954,9 +954,9 @@
    PC = PULL(); \
    PC |= PULL() << 8; \
    ADD_CYCLES(6); \
-   if (0 == i_flag && cpu.int_pending && (remaining_cycles > 0)) \
+   if (0 == i_flag && cpu->int_pending && (remaining_cycles > 0)) \
    { \
-      cpu.int_pending = 0; \
+      cpu->int_pending = 0; \
       IRQ(); \
    } \
 }
@@ -1184,7 +1184,10 @@
 
 
 /* internal CPU context */
-static nes6502_context cpu;
+static nes6502_context own_cpu;
+
+/* the context we run on, see nes6502_bindcontext */
+static nes6502_context *cpu = &own_cpu;
 
 /* memory region pointers */
 static uint8_t *ram = NULL, *stack = NULL;
@@ -1216,7 +1219,7 @@ INLINE uint32_t zp_readword(uint8_t address)
 
 INLINE uint8_t bank_readbyte(uint32_t address)
 {
-   return cpu.mem_page[address >> NES6502_BANKSHIFT][address & NES6502_BANKMASK];
+   return cpu->mem_page[address >> NES6502_BANKSHIFT][address & NES6502_BANKMASK];
 }
 
 INLINE uint32_t bank_readword(uint32_t address)
@@ -1224,12 +1227,12 @@ INLINE uint32_t bank_readword(uint32_t address)
 #ifdef HOST_LITTLE_ENDIAN
    /* TODO: this fails if src address is $xFFF */
    /* TODO: this fails if host architecture doesn't support byte alignment */
-   return (uint32_t) (*(uint16_t *)(cpu.mem_page[address >> NES6502_BANKSHIFT] + (address & NES6502_BANKMASK)));
+   return (uint32_t) (*(uint16_t *)(cpu->mem_page[address >> NES6502_BANKSHIFT] + (address & NES6502_BANKMASK)));
 #else
 #ifdef TARGET_CPU_PPC
-   return __lhbrx(cpu.mem_page[address >> NES6502_BANKSHIFT], address & NES6502_BANKMASK);
+   return __lhbrx(cpu->mem_page[address >> NES6502_BANKSHIFT], address & NES6502_BANKMASK);
 #else
-   uint32_t x = (uint32_t) *(uint16_t *)(cpu.mem_page[address >> NES6502_BANKSHIFT] + (address & NES6502_BANKMASK));
+   uint32_t x = (uint32_t) *(uint16_t *)(cpu->mem_page[address >> NES6502_BANKSHIFT] + (address & NES6502_BANKMASK));
    return (x << 8) | (x >> 8);
 #endif /* TARGET_CPU_PPC */
 #endif /* HOST_LITTLE_ENDIAN */
@@ -1237,7 +1240,7 @@ INLINE uint32_t bank_readword(uint32_t address)
 
 INLINE void bank_writebyte(uint32_t address, uint8_t value)
 {
-   cpu.mem_page[address >> NES6502_BANKSHIFT][address & NES6502_BANKMASK] = value;
+   cpu->mem_page[address >> NES6502_BANKSHIFT][address & NES6502_BANKMASK] = value;
 }
 
 /* read a byte of 6502 memory */
@@ -1255,7 +1258,7 @@ static uint8_t mem_readbyte(uint32_t address)
    /* check memory range handlers */
 //   else
    {
-      for (mr = cpu.read_handler; mr->min_range != 0xFFFFFFFF; mr++)
+      for (mr = cpu->read_handler; mr->min_range != 0xFFFFFFFF; mr++)
       {
          if (address >= mr->min_range && address <= mr->max_range)
             return mr->read_func(address);
@@ -1280,7 +1283,7 @@ static void mem_writebyte(uint32_t address, uint8_t value)
    /* check memory range handlers */
 //   else
    {
-      for (mw = cpu.write_handler; mw->min_range != 0xFFFFFFFF; mw++)
+      for (mw = cpu->write_handler; mw->min_range != 0xFFFFFFFF; mw++)
       {
          if (address >= mw->min_range && address <= mw->max_range)
          {
@@ -1301,18 +1304,42 @@ void nes6502_setcontext(nes6502_context *context)
 
    ASSERT(context);
 
-   memcpy(&cpu, context, sizeof(nes6502_context));
+   cpu = &own_cpu;
+   memcpy(cpu, context, sizeof(nes6502_context));
+
+   for (loop = 0; loop < NES6502_NUMBANKS; loop++)
+   {
+      if (NULL == cpu->mem_page[loop])
+         cpu->mem_page[loop] = dead_page;
+   }
+
+   ram = cpu->mem_page[0];  /* quick zero-page/RAM references */
+   stack = ram + STACK_OFFSET;
+
+   cpu->jammed = FALSE;
+}
+
+/* run straight on a context (filled in by nes6502_getcontext) until the next
+** nes6502_setcontext, so switching between several 6502's is just a pointer swap
+*/
+void nes6502_bindcontext(nes6502_context *context)
+{
+   int loop;
+
+   ASSERT(context);
+
+   cpu = context;
 
    for (loop = 0; loop < NES6502_NUMBANKS; loop++)
    {
-      if (NULL == cpu.mem_page[loop])
-         cpu.mem_page[loop] = dead_page;
+      if (NULL == cpu->mem_page[loop])
+         cpu->mem_page[loop] = dead_page;
    }
 
-   ram = cpu.mem_page[0];  /* quick zero-page/RAM references */
+   ram = cpu->mem_page[0];  /* quick zero-page/RAM references */
    stack = ram + STACK_OFFSET;
 
-   cpu.jammed = FALSE;
+   cpu->jammed = FALSE;
 }
 
 /* get the current context */
@@ -1322,7 +1349,7 @@ void nes6502_getcontext(nes6502_context *context)
 
    ASSERT(context);
 
-   memcpy(context, &cpu, sizeof(nes6502_context));
+   memcpy(context, cpu, sizeof(nes6502_context));
 
    for (loop = 0; loop < NES6502_NUMBANKS; loop++)
    {
@@ -1340,32 +1367,32 @@ uint8_t nes6502_getbyte(uint32_t address)
 /* get number of elapsed cycles */
 uint32_t nes6502_getcycles(bool reset_flag)
 {
-   uint32_t cycles = cpu.total_cycles;
+   uint32_t cycles = cpu->total_cycles;
 
    if (reset_flag)
-      cpu.total_cycles = 0;
+      cpu->total_cycles = 0;
 
    return cycles;
 }
 
 #define  GET_GLOBAL_REGS() \
 { \
-   PC = cpu.pc_reg; \
-   A = cpu.a_reg; \
-   X = cpu.x_reg; \
-   Y = cpu.y_reg; \
-   SCATTER_FLAGS(cpu.p_reg); \
-   S = cpu.s_reg; \
+   PC = cpu->pc_reg; \
+   A = cpu->a_reg; \
+   X = cpu->x_reg; \
+   Y = cpu->y_reg; \
+   SCATTER_FLAGS(cpu->p_reg); \
+   S = cpu->s_reg; \
 }
 
 #define  STORE_LOCAL_REGS() \
 { \
-   cpu.pc_reg = PC; \
-   cpu.a_reg = A; \
-   cpu.x_reg = X; \
-   cpu.y_reg = Y; \
-   cpu.p_reg = COMBINE_FLAGS(); \
-   cpu.s_reg = S; \
+   cpu->pc_reg = PC; \
+   cpu->a_reg = A; \
+   cpu->x_reg = X; \
+   cpu->y_reg = Y; \
+   cpu->p_reg = COMBINE_FLAGS(); \
+   cpu->s_reg = S; \
 }
 
 #define  MIN(a,b)    (((a) < (b)) ? (a) : (b))
@@ -1382,8 +1409,8 @@ uint32_t g_old_cycles = 0;	// MPO : moved this here so other functions could acc
 // MATT : changed this to match callback prototype
 unsigned int nes6502_execute(unsigned int cycles_to_execute)
 {
-//   int old_cycles = cpu.total_cycles;
-	g_old_cycles = cpu.total_cycles;	// MPO
+//   int old_cycles = cpu->total_cycles;
+	g_old_cycles = cpu->total_cycles;	// MPO
    int remaining_cycles = cycles_to_execute;
    uint32_t temp, addr; /* for macros */
    uint8_t btemp, baddr; /* for macros */
@@ -1448,23 +1475,23 @@ unsigned int nes6502_execute(unsigned int cycles_to_execute)
 
    GET_GLOBAL_REGS();
 
-   if (cpu.int_pending && remaining_cycles)
+   if (cpu->int_pending && remaining_cycles)
    {
       if (0 == i_flag)
       {
-         cpu.int_pending = 0;
+         cpu->int_pending = 0;
          IRQ();
       }
    }
 
    /* check for DMA cycle burning */
-   if (cpu.burn_cycles && remaining_cycles)
+   if (cpu->burn_cycles && remaining_cycles)
    {
       int burn_for;
       
-      burn_for = MIN(remaining_cycles, cpu.burn_cycles);
+      burn_for = MIN(remaining_cycles, cpu->burn_cycles);
       ADD_CYCLES(burn_for);
-      cpu.burn_cycles -= burn_for;
+      cpu->burn_cycles -= burn_for;
    }
       
 #ifdef NES6502_JUMPTABLE
@@ -2432,26 +2459,26 @@ end_execute:
    STORE_LOCAL_REGS();
 
    /* Return our actual amount of executed cycles */
-   return (cpu.total_cycles - g_old_cycles);	// MPO : changed old_cycles to g_old_cycles
+   return (cpu->total_cycles - g_old_cycles);	// MPO : changed old_cycles to g_old_cycles
 }
 
 #if 0
 void nes6502_init(void)
 {
-   cpu.a_reg = cpu.x_reg = cpu.y_reg = 0;
-   cpu.s_reg = 0xFF;                         /* Stack grows down */
-   cpu.burn_cycles = 0;
+   cpu->a_reg = cpu->x_reg = cpu->y_reg = 0;
+   cpu->s_reg = 0xFF;                         /* Stack grows down */
+   cpu->burn_cycles = 0;
 }
 #endif
 
 /* Issue a CPU Reset */
 void nes6502_reset(void)
 {
-   cpu.p_reg = Z_FLAG6502 | R_FLAG6502 | I_FLAG6502;     /* Reserved bit always 1 */
-   cpu.int_pending = 0;                      /* No pending interrupts */
-   cpu.pc_reg = bank_readword(RESET_VECTOR); /* Fetch reset vector */
-   cpu.burn_cycles = RESET_CYCLES;
-   cpu.jammed = FALSE;
+   cpu->p_reg = Z_FLAG6502 | R_FLAG6502 | I_FLAG6502;     /* Reserved bit always 1 */
+   cpu->int_pending = 0;                      /* No pending interrupts */
+   cpu->pc_reg = bank_readword(RESET_VECTOR); /* Fetch reset vector */
+   cpu->burn_cycles = RESET_CYCLES;
+   cpu->jammed = FALSE;
 }
 
 /* Non-maskable interrupt */
@@ -2465,11 +2492,11 @@ void nes6502_nmi(void)
    uint8_t n_flag, v_flag, b_flag;
    uint8_t d_flag, i_flag, z_flag, c_flag;
 
-   if (FALSE == cpu.jammed)
+   if (FALSE == cpu->jammed)
    {
       GET_GLOBAL_REGS();
       NMI_PROC();
-      cpu.burn_cycles += INT_CYCLES;
+      cpu->burn_cycles += INT_CYCLES;
       STORE_LOCAL_REGS();
    }
 }
@@ -2485,16 +2512,16 @@ void nes6502_irq(void)
    uint8_t n_flag, v_flag, b_flag;
    uint8_t d_flag, i_flag, z_flag, c_flag;
 
-   if (FALSE == cpu.jammed)
+   if (FALSE == cpu->jammed)
    {
       GET_GLOBAL_REGS();
       if (0 == i_flag)
       {
          IRQ_PROC();
-         cpu.burn_cycles += INT_CYCLES;
+         cpu->burn_cycles += INT_CYCLES;
       }
       else
-         cpu.int_pending = 1;
+         cpu->int_pending = 1;
       STORE_LOCAL_REGS();
    }
 }
@@ -2502,7 +2529,7 @@ void nes6502_irq(void)
 /* Set dead cycle period */
 void nes6502_burn(int cycles)
 {
-   cpu.burn_cycles += cycles;
+   cpu->burn_cycles += cycles;
 }
 
 // start MPO
@@ -2511,13 +2538,13 @@ void nes6502_burn(int cycles)
 // Make sure you understand this or you may be in for some very frustrating debug sessions!
 uint32_t nes6502_get_pc()
 {
-	return cpu.pc_reg;
+	return cpu->pc_reg;
 }
 
 // returns how many cycles have elapsed relative to the beginning of nes6502_execute
 uint32_t nes6502_getcycles_sofar()
 {
-	return (cpu.total_cycles - g_old_cycles);
+	return (cpu->total_cycles - g_old_cycles);
 }
 
 // end MPO
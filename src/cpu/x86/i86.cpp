@@ -352,6 +352,26 @@ void i86_set_irq_callback(int (*callback) (int))
 
 
 
+/* threaded dispatch needs labels as values (gcc and clang), the debugger hooks every */
+/* instruction so it keeps the loop.  Prefixes still reach their opcode through */
+/* i86_instruction[]. */
+#if defined(__GNUC__) && !defined(MAME_DEBUG)
+#define I86_THREADED
+#endif
+
+#ifdef I86_THREADED
+#define I86_LABEL_ADDR(n, f) &&i86_op_##n,
+#define I86_LABEL(n, f) i86_op_##n: PREFIX86(f)(); I86_DISPATCH;
+
+/* ends an opcode by fetching the next one and jumping straight to it, so each opcode */
+/* gets its own (better predicted) indirect branch.  Same steps as the loop below. */
+#define I86_DISPATCH	\
+	if (i86_ICount <= 0) goto i86_done;	\
+	seg_prefix = FALSE;	\
+	I.prevpc = I.pc;	\
+	goto *i86_op_labels[FETCHOP]
+#endif // I86_THREADED
+
 Uint32 i86_execute(Uint32 num_cycles)
 {
 
@@ -364,6 +384,15 @@ Uint32 i86_execute(Uint32 num_cycles)
 	i86_ICount -= I.extra_cycles;
 	I.extra_cycles = 0;
 
+#ifdef I86_THREADED
+	{
+		static const void *const i86_op_labels[256] = { I86_OPCODES(I86_LABEL_ADDR) };
+
+		I86_DISPATCH;
+		I86_OPCODES(I86_LABEL)
+	}
+i86_done:
+#else
 	/* run until we're out */
 	while (i86_ICount > 0)
 	{
@@ -392,6 +421,7 @@ Uint32 i86_execute(Uint32 num_cycles)
 			
   	 	TABLE86;
 	}
+#endif // I86_THREADED
 
 	/* adjust for any interrupts that came in */
 	i86_ICount -= I.extra_cycles;
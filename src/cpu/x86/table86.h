@@ -19,264 +19,270 @@
  */
 
 
+/* the opcode table, OP(opcode, handler) */
+#define I86_OPCODES(OP) \
+	OP(0x00, _add_br8) \
+	OP(0x01, _add_wr16) \
+	OP(0x02, _add_r8b) \
+	OP(0x03, _add_r16w) \
+	OP(0x04, _add_ald8) \
+	OP(0x05, _add_axd16) \
+	OP(0x06, _push_es) \
+	OP(0x07, _pop_es) \
+	OP(0x08, _or_br8) \
+	OP(0x09, _or_wr16) \
+	OP(0x0a, _or_r8b) \
+	OP(0x0b, _or_r16w) \
+	OP(0x0c, _or_ald8) \
+	OP(0x0d, _or_axd16) \
+	OP(0x0e, _push_cs) \
+	OP(0x0f, _invalid) \
+	OP(0x10, _adc_br8) \
+	OP(0x11, _adc_wr16) \
+	OP(0x12, _adc_r8b) \
+	OP(0x13, _adc_r16w) \
+	OP(0x14, _adc_ald8) \
+	OP(0x15, _adc_axd16) \
+	OP(0x16, _push_ss) \
+	OP(0x17, _pop_ss) \
+	OP(0x18, _sbb_br8) \
+	OP(0x19, _sbb_wr16) \
+	OP(0x1a, _sbb_r8b) \
+	OP(0x1b, _sbb_r16w) \
+	OP(0x1c, _sbb_ald8) \
+	OP(0x1d, _sbb_axd16) \
+	OP(0x1e, _push_ds) \
+	OP(0x1f, _pop_ds) \
+	OP(0x20, _and_br8) \
+	OP(0x21, _and_wr16) \
+	OP(0x22, _and_r8b) \
+	OP(0x23, _and_r16w) \
+	OP(0x24, _and_ald8) \
+	OP(0x25, _and_axd16) \
+	OP(0x26, _es) \
+	OP(0x27, _daa) \
+	OP(0x28, _sub_br8) \
+	OP(0x29, _sub_wr16) \
+	OP(0x2a, _sub_r8b) \
+	OP(0x2b, _sub_r16w) \
+	OP(0x2c, _sub_ald8) \
+	OP(0x2d, _sub_axd16) \
+	OP(0x2e, _cs) \
+	OP(0x2f, _das) \
+	OP(0x30, _xor_br8) \
+	OP(0x31, _xor_wr16) \
+	OP(0x32, _xor_r8b) \
+	OP(0x33, _xor_r16w) \
+	OP(0x34, _xor_ald8) \
+	OP(0x35, _xor_axd16) \
+	OP(0x36, _ss) \
+	OP(0x37, _aaa) \
+	OP(0x38, _cmp_br8) \
+	OP(0x39, _cmp_wr16) \
+	OP(0x3a, _cmp_r8b) \
+	OP(0x3b, _cmp_r16w) \
+	OP(0x3c, _cmp_ald8) \
+	OP(0x3d, _cmp_axd16) \
+	OP(0x3e, _ds) \
+	OP(0x3f, _aas) \
+	OP(0x40, _inc_ax) \
+	OP(0x41, _inc_cx) \
+	OP(0x42, _inc_dx) \
+	OP(0x43, _inc_bx) \
+	OP(0x44, _inc_sp) \
+	OP(0x45, _inc_bp) \
+	OP(0x46, _inc_si) \
+	OP(0x47, _inc_di) \
+	OP(0x48, _dec_ax) \
+	OP(0x49, _dec_cx) \
+	OP(0x4a, _dec_dx) \
+	OP(0x4b, _dec_bx) \
+	OP(0x4c, _dec_sp) \
+	OP(0x4d, _dec_bp) \
+	OP(0x4e, _dec_si) \
+	OP(0x4f, _dec_di) \
+	OP(0x50, _push_ax) \
+	OP(0x51, _push_cx) \
+	OP(0x52, _push_dx) \
+	OP(0x53, _push_bx) \
+	OP(0x54, _push_sp) \
+	OP(0x55, _push_bp) \
+	OP(0x56, _push_si) \
+	OP(0x57, _push_di) \
+	OP(0x58, _pop_ax) \
+	OP(0x59, _pop_cx) \
+	OP(0x5a, _pop_dx) \
+	OP(0x5b, _pop_bx) \
+	OP(0x5c, _pop_sp) \
+	OP(0x5d, _pop_bp) \
+	OP(0x5e, _pop_si) \
+	OP(0x5f, _pop_di) \
+	OP(0x60, _invalid) /* 186: _pusha */ \
+	OP(0x61, _invalid) /* 186: _popa */ \
+	OP(0x62, _invalid) /* 186: _bound */ \
+	OP(0x63, _invalid) \
+	OP(0x64, _invalid) \
+	OP(0x65, _invalid) \
+	OP(0x66, _invalid) \
+	OP(0x67, _invalid) \
+	OP(0x68, _invalid) /* 186: _push_d16 */ \
+	OP(0x69, _invalid) /* 186: _imul_d16 */ \
+	OP(0x6a, _invalid) /* 186: _push_d8 */ \
+	OP(0x6b, _invalid) /* 186: _imul_d8 */ \
+	OP(0x6c, _invalid) /* 186: _insb */ \
+	OP(0x6d, _invalid) /* 186: _insw */ \
+	OP(0x6e, _invalid) /* 186: _outsb */ \
+	OP(0x6f, _invalid) /* 186: _outsw */ \
+	OP(0x70, _jo) \
+	OP(0x71, _jno) \
+	OP(0x72, _jb) \
+	OP(0x73, _jnb) \
+	OP(0x74, _jz) \
+	OP(0x75, _jnz) \
+	OP(0x76, _jbe) \
+	OP(0x77, _jnbe) \
+	OP(0x78, _js) \
+	OP(0x79, _jns) \
+	OP(0x7a, _jp) \
+	OP(0x7b, _jnp) \
+	OP(0x7c, _jl) \
+	OP(0x7d, _jnl) \
+	OP(0x7e, _jle) \
+	OP(0x7f, _jnle) \
+	OP(0x80, _80pre) \
+	OP(0x81, _81pre) \
+	OP(0x82, _82pre) \
+	OP(0x83, _83pre) \
+	OP(0x84, _test_br8) \
+	OP(0x85, _test_wr16) \
+	OP(0x86, _xchg_br8) \
+	OP(0x87, _xchg_wr16) \
+	OP(0x88, _mov_br8) \
+	OP(0x89, _mov_wr16) \
+	OP(0x8a, _mov_r8b) \
+	OP(0x8b, _mov_r16w) \
+	OP(0x8c, _mov_wsreg) \
+	OP(0x8d, _lea) \
+	OP(0x8e, _mov_sregw) \
+	OP(0x8f, _popw) \
+	OP(0x90, _nop) \
+	OP(0x91, _xchg_axcx) \
+	OP(0x92, _xchg_axdx) \
+	OP(0x93, _xchg_axbx) \
+	OP(0x94, _xchg_axsp) \
+	OP(0x95, _xchg_axbp) \
+	OP(0x96, _xchg_axsi) \
+	OP(0x97, _xchg_axdi) \
+	OP(0x98, _cbw) \
+	OP(0x99, _cwd) \
+	OP(0x9a, _call_far) \
+	OP(0x9b, _wait) \
+	OP(0x9c, _pushf) \
+	OP(0x9d, _popf) \
+	OP(0x9e, _sahf) \
+	OP(0x9f, _lahf) \
+	OP(0xa0, _mov_aldisp) \
+	OP(0xa1, _mov_axdisp) \
+	OP(0xa2, _mov_dispal) \
+	OP(0xa3, _mov_dispax) \
+	OP(0xa4, _movsb) \
+	OP(0xa5, _movsw) \
+	OP(0xa6, _cmpsb) \
+	OP(0xa7, _cmpsw) \
+	OP(0xa8, _test_ald8) \
+	OP(0xa9, _test_axd16) \
+	OP(0xaa, _stosb) \
+	OP(0xab, _stosw) \
+	OP(0xac, _lodsb) \
+	OP(0xad, _lodsw) \
+	OP(0xae, _scasb) \
+	OP(0xaf, _scasw) \
+	OP(0xb0, _mov_ald8) \
+	OP(0xb1, _mov_cld8) \
+	OP(0xb2, _mov_dld8) \
+	OP(0xb3, _mov_bld8) \
+	OP(0xb4, _mov_ahd8) \
+	OP(0xb5, _mov_chd8) \
+	OP(0xb6, _mov_dhd8) \
+	OP(0xb7, _mov_bhd8) \
+	OP(0xb8, _mov_axd16) \
+	OP(0xb9, _mov_cxd16) \
+	OP(0xba, _mov_dxd16) \
+	OP(0xbb, _mov_bxd16) \
+	OP(0xbc, _mov_spd16) \
+	OP(0xbd, _mov_bpd16) \
+	OP(0xbe, _mov_sid16) \
+	OP(0xbf, _mov_did16) \
+	OP(0xc0, _invalid) /* 186: _rotshft_bd8 */ \
+	OP(0xc1, _invalid) /* 186: _rotshft_wd8 */ \
+	OP(0xc2, _ret_d16) \
+	OP(0xc3, _ret) \
+	OP(0xc4, _les_dw) \
+	OP(0xc5, _lds_dw) \
+	OP(0xc6, _mov_bd8) \
+	OP(0xc7, _mov_wd16) \
+	OP(0xc8, _invalid) /* 186: _enter */ \
+	OP(0xc9, _invalid) /* 186: _leave */ \
+	OP(0xca, _retf_d16) \
+	OP(0xcb, _retf) \
+	OP(0xcc, _int3) \
+	OP(0xcd, _int) \
+	OP(0xce, _into) \
+	OP(0xcf, _iret) \
+	OP(0xd0, _rotshft_b) \
+	OP(0xd1, _rotshft_w) \
+	OP(0xd2, _rotshft_bcl) \
+	OP(0xd3, _rotshft_wcl) \
+	OP(0xd4, _aam) \
+	OP(0xd5, _aad) \
+	OP(0xd6, _invalid) \
+	OP(0xd7, _xlat) \
+	OP(0xd8, _escape) \
+	OP(0xd9, _escape) \
+	OP(0xda, _escape) \
+	OP(0xdb, _escape) \
+	OP(0xdc, _escape) \
+	OP(0xdd, _escape) \
+	OP(0xde, _escape) \
+	OP(0xdf, _escape) \
+	OP(0xe0, _loopne) \
+	OP(0xe1, _loope) \
+	OP(0xe2, _loop) \
+	OP(0xe3, _jcxz) \
+	OP(0xe4, _inal) \
+	OP(0xe5, _inax) \
+	OP(0xe6, _outal) \
+	OP(0xe7, _outax) \
+	OP(0xe8, _call_d16) \
+	OP(0xe9, _jmp_d16) \
+	OP(0xea, _jmp_far) \
+	OP(0xeb, _jmp_d8) \
+	OP(0xec, _inaldx) \
+	OP(0xed, _inaxdx) \
+	OP(0xee, _outdxal) \
+	OP(0xef, _outdxax) \
+	OP(0xf0, _lock) \
+	OP(0xf1, _invalid) \
+	OP(0xf2, _repne) \
+	OP(0xf3, _repe) \
+	OP(0xf4, _hlt) \
+	OP(0xf5, _cmc) \
+	OP(0xf6, _f6pre) \
+	OP(0xf7, _f7pre) \
+	OP(0xf8, _clc) \
+	OP(0xf9, _stc) \
+	OP(0xfa, _cli) \
+	OP(0xfb, _sti) \
+	OP(0xfc, _cld) \
+	OP(0xfd, _std) \
+	OP(0xfe, _fepre) \
+	OP(0xff, _ffpre)
+
+#define I86_TABLE_ENTRY(n, f) PREFIX86(f),
+
 static void (*PREFIX86(_instruction)[256])(void) =
 {
-	 PREFIX86(_add_br8),          /* 0x00 */
-	 PREFIX86(_add_wr16),         /* 0x01 */
-	 PREFIX86(_add_r8b),          /* 0x02 */
-	 PREFIX86(_add_r16w),         /* 0x03 */
-	 PREFIX86(_add_ald8),         /* 0x04 */
-	 PREFIX86(_add_axd16),        /* 0x05 */
-	 PREFIX86(_push_es),          /* 0x06 */
-	 PREFIX86(_pop_es),           /* 0x07 */
-	 PREFIX86(_or_br8),           /* 0x08 */
-	 PREFIX86(_or_wr16),          /* 0x09 */
-	 PREFIX86(_or_r8b),           /* 0x0a */
-	 PREFIX86(_or_r16w),          /* 0x0b */
-	 PREFIX86(_or_ald8),          /* 0x0c */
-	 PREFIX86(_or_axd16),         /* 0x0d */
-	 PREFIX86(_push_cs),          /* 0x0e */
-	 PREFIX86(_invalid),
-	 PREFIX86(_adc_br8),          /* 0x10 */
-	 PREFIX86(_adc_wr16),         /* 0x11 */
-	 PREFIX86(_adc_r8b),          /* 0x12 */
-	 PREFIX86(_adc_r16w),         /* 0x13 */
-	 PREFIX86(_adc_ald8),         /* 0x14 */
-	 PREFIX86(_adc_axd16),        /* 0x15 */
-	 PREFIX86(_push_ss),          /* 0x16 */
-	 PREFIX86(_pop_ss),           /* 0x17 */
-	 PREFIX86(_sbb_br8),          /* 0x18 */
-	 PREFIX86(_sbb_wr16),         /* 0x19 */
-	 PREFIX86(_sbb_r8b),          /* 0x1a */
-	 PREFIX86(_sbb_r16w),         /* 0x1b */
-	 PREFIX86(_sbb_ald8),         /* 0x1c */
-	 PREFIX86(_sbb_axd16),        /* 0x1d */
-	 PREFIX86(_push_ds),          /* 0x1e */
-	 PREFIX86(_pop_ds),           /* 0x1f */
-	 PREFIX86(_and_br8),          /* 0x20 */
-	 PREFIX86(_and_wr16),         /* 0x21 */
-	 PREFIX86(_and_r8b),          /* 0x22 */
-	 PREFIX86(_and_r16w),         /* 0x23 */
-	 PREFIX86(_and_ald8),         /* 0x24 */
-	 PREFIX86(_and_axd16),        /* 0x25 */
-	 PREFIX86(_es),               /* 0x26 */
-	 PREFIX86(_daa),              /* 0x27 */
-	 PREFIX86(_sub_br8),          /* 0x28 */
-	 PREFIX86(_sub_wr16),         /* 0x29 */
-	 PREFIX86(_sub_r8b),          /* 0x2a */
-	 PREFIX86(_sub_r16w),         /* 0x2b */
-	 PREFIX86(_sub_ald8),         /* 0x2c */
-	 PREFIX86(_sub_axd16),        /* 0x2d */
-	 PREFIX86(_cs),               /* 0x2e */
-	 PREFIX86(_das),		/* 0x2f */
-	 PREFIX86(_xor_br8),          /* 0x30 */
-	 PREFIX86(_xor_wr16),         /* 0x31 */
-	 PREFIX86(_xor_r8b),          /* 0x32 */
-	 PREFIX86(_xor_r16w),         /* 0x33 */
-	 PREFIX86(_xor_ald8),         /* 0x34 */
-	 PREFIX86(_xor_axd16),        /* 0x35 */
-	 PREFIX86(_ss),               /* 0x36 */
-	 PREFIX86(_aaa),		/* 0x37 */
-	 PREFIX86(_cmp_br8),          /* 0x38 */
-	 PREFIX86(_cmp_wr16),         /* 0x39 */
-	 PREFIX86(_cmp_r8b),          /* 0x3a */
-	 PREFIX86(_cmp_r16w),         /* 0x3b */
-	 PREFIX86(_cmp_ald8),         /* 0x3c */
-	 PREFIX86(_cmp_axd16),        /* 0x3d */
-	 PREFIX86(_ds),               /* 0x3e */
-	 PREFIX86(_aas),		/* 0x3f */
-	 PREFIX86(_inc_ax),           /* 0x40 */
-	 PREFIX86(_inc_cx),           /* 0x41 */
-	 PREFIX86(_inc_dx),           /* 0x42 */
-	 PREFIX86(_inc_bx),           /* 0x43 */
-	 PREFIX86(_inc_sp),           /* 0x44 */
-	 PREFIX86(_inc_bp),           /* 0x45 */
-	 PREFIX86(_inc_si),           /* 0x46 */
-	 PREFIX86(_inc_di),           /* 0x47 */
-	 PREFIX86(_dec_ax),           /* 0x48 */
-	 PREFIX86(_dec_cx),           /* 0x49 */
-	 PREFIX86(_dec_dx),           /* 0x4a */
-	 PREFIX86(_dec_bx),           /* 0x4b */
-	 PREFIX86(_dec_sp),           /* 0x4c */
-	 PREFIX86(_dec_bp),           /* 0x4d */
-	 PREFIX86(_dec_si),           /* 0x4e */
-	 PREFIX86(_dec_di),           /* 0x4f */
-	 PREFIX86(_push_ax),          /* 0x50 */
-	 PREFIX86(_push_cx),          /* 0x51 */
-	 PREFIX86(_push_dx),          /* 0x52 */
-	 PREFIX86(_push_bx),          /* 0x53 */
-	 PREFIX86(_push_sp),          /* 0x54 */
-	 PREFIX86(_push_bp),          /* 0x55 */
-	 PREFIX86(_push_si),          /* 0x56 */
-	 PREFIX86(_push_di),          /* 0x57 */
-	 PREFIX86(_pop_ax),           /* 0x58 */
-	 PREFIX86(_pop_cx),           /* 0x59 */
-	 PREFIX86(_pop_dx),           /* 0x5a */
-	 PREFIX86(_pop_bx),           /* 0x5b */
-	 PREFIX86(_pop_sp),           /* 0x5c */
-	 PREFIX86(_pop_bp),           /* 0x5d */
-	 PREFIX86(_pop_si),           /* 0x5e */
-	 PREFIX86(_pop_di),           /* 0x5f */
-	 PREFIX86(_invalid), // PREFIX86(_pusha),            /* 0x60 */
-	 PREFIX86(_invalid), // PREFIX86(_popa),             /* 0x61 */
-	 PREFIX86(_invalid), // PREFIX86(_bound),            /* 0x62 */
-	 PREFIX86(_invalid),
-	 PREFIX86(_invalid),
-	 PREFIX86(_invalid),
-	 PREFIX86(_invalid),
-	 PREFIX86(_invalid),
-	 PREFIX86(_invalid), //i_push_d16),         /* 0x68 */
-	 PREFIX86(_invalid), //i_imul_d16),         /* 0x69 */
-	 PREFIX86(_invalid), //i_push_d8),          /* 0x6a */
-	 PREFIX86(_invalid), //i_imul_d8),          /* 0x6b */
-	 PREFIX86(_invalid), //i_insb),             /* 0x6c */
-	 PREFIX86(_invalid), //i_insw),             /* 0x6d */
-	 PREFIX86(_invalid), //i_outsb),            /* 0x6e */
-	 PREFIX86(_invalid), //i_outsw),            /* 0x6f */
-	 PREFIX86(_jo),               /* 0x70 */
-	 PREFIX86(_jno),              /* 0x71 */
-	 PREFIX86(_jb),               /* 0x72 */
-	 PREFIX86(_jnb),              /* 0x73 */
-	 PREFIX86(_jz),               /* 0x74 */
-	 PREFIX86(_jnz),              /* 0x75 */
-	 PREFIX86(_jbe),              /* 0x76 */
-	 PREFIX86(_jnbe),             /* 0x77 */
-	 PREFIX86(_js),               /* 0x78 */
-	 PREFIX86(_jns),              /* 0x79 */
-	 PREFIX86(_jp),               /* 0x7a */
-	 PREFIX86(_jnp),              /* 0x7b */
-	 PREFIX86(_jl),               /* 0x7c */
-	 PREFIX86(_jnl),              /* 0x7d */
-	 PREFIX86(_jle),              /* 0x7e */
-	 PREFIX86(_jnle),             /* 0x7f */
-	 PREFIX86(_80pre),            /* 0x80 */
-	 PREFIX86(_81pre),            /* 0x81 */
-	 PREFIX86(_82pre),			/* 0x82 */
-	 PREFIX86(_83pre),            /* 0x83 */
-	 PREFIX86(_test_br8),         /* 0x84 */
-	 PREFIX86(_test_wr16),        /* 0x85 */
-	 PREFIX86(_xchg_br8),         /* 0x86 */
-	 PREFIX86(_xchg_wr16),        /* 0x87 */
-	 PREFIX86(_mov_br8),          /* 0x88 */
-	 PREFIX86(_mov_wr16),         /* 0x89 */
-	 PREFIX86(_mov_r8b),          /* 0x8a */
-	 PREFIX86(_mov_r16w),         /* 0x8b */
-	 PREFIX86(_mov_wsreg),        /* 0x8c */
-	 PREFIX86(_lea),              /* 0x8d */
-	 PREFIX86(_mov_sregw),        /* 0x8e */
-	 PREFIX86(_popw),             /* 0x8f */
-	 PREFIX86(_nop),              /* 0x90 */
-	 PREFIX86(_xchg_axcx),        /* 0x91 */
-	 PREFIX86(_xchg_axdx),        /* 0x92 */
-	 PREFIX86(_xchg_axbx),        /* 0x93 */
-	 PREFIX86(_xchg_axsp),        /* 0x94 */
-	 PREFIX86(_xchg_axbp),        /* 0x95 */
-	 PREFIX86(_xchg_axsi),        /* 0x97 */
-	 PREFIX86(_xchg_axdi),        /* 0x97 */
-	 PREFIX86(_cbw),              /* 0x98 */
-	 PREFIX86(_cwd),              /* 0x99 */
-	 PREFIX86(_call_far),         /* 0x9a */
-	 PREFIX86(_wait),             /* 0x9b */
-	 PREFIX86(_pushf),            /* 0x9c */
-	 PREFIX86(_popf),             /* 0x9d */
-	 PREFIX86(_sahf),             /* 0x9e */
-	 PREFIX86(_lahf),             /* 0x9f */
-	 PREFIX86(_mov_aldisp),       /* 0xa0 */
-	 PREFIX86(_mov_axdisp),       /* 0xa1 */
-	 PREFIX86(_mov_dispal),       /* 0xa2 */
-	 PREFIX86(_mov_dispax),       /* 0xa3 */
-	 PREFIX86(_movsb),            /* 0xa4 */
-	 PREFIX86(_movsw),            /* 0xa5 */
-	 PREFIX86(_cmpsb),            /* 0xa6 */
-	 PREFIX86(_cmpsw),            /* 0xa7 */
-	 PREFIX86(_test_ald8),        /* 0xa8 */
-	 PREFIX86(_test_axd16),       /* 0xa9 */
-	 PREFIX86(_stosb),            /* 0xaa */
-	 PREFIX86(_stosw),            /* 0xab */
-	 PREFIX86(_lodsb),            /* 0xac */
-	 PREFIX86(_lodsw),            /* 0xad */
-	 PREFIX86(_scasb),            /* 0xae */
-	 PREFIX86(_scasw),            /* 0xaf */
-	 PREFIX86(_mov_ald8),         /* 0xb0 */
-	 PREFIX86(_mov_cld8),         /* 0xb1 */
-	 PREFIX86(_mov_dld8),         /* 0xb2 */
-	 PREFIX86(_mov_bld8),         /* 0xb3 */
-	 PREFIX86(_mov_ahd8),         /* 0xb4 */
-	 PREFIX86(_mov_chd8),         /* 0xb5 */
-	 PREFIX86(_mov_dhd8),         /* 0xb6 */
-	 PREFIX86(_mov_bhd8),         /* 0xb7 */
-	 PREFIX86(_mov_axd16),        /* 0xb8 */
-	 PREFIX86(_mov_cxd16),        /* 0xb9 */
-	 PREFIX86(_mov_dxd16),        /* 0xba */
-	 PREFIX86(_mov_bxd16),        /* 0xbb */
-	 PREFIX86(_mov_spd16),        /* 0xbc */
-	 PREFIX86(_mov_bpd16),        /* 0xbd */
-	 PREFIX86(_mov_sid16),        /* 0xbe */
-	 PREFIX86(_mov_did16),        /* 0xbf */
-	 PREFIX86(_invalid), // PREFIX86(_rotshft_bd8),      /* 0xc0 */
-	 PREFIX86(_invalid), // PREFIX86(_rotshft_wd8),      /* 0xc1 */
-	 PREFIX86(_ret_d16),          /* 0xc2 */
-	 PREFIX86(_ret),              /* 0xc3 */
-	 PREFIX86(_les_dw),           /* 0xc4 */
-	 PREFIX86(_lds_dw),           /* 0xc5 */
-	 PREFIX86(_mov_bd8),          /* 0xc6 */
-	 PREFIX86(_mov_wd16),         /* 0xc7 */
-	 PREFIX86(_invalid), //i_enter),            /* 0xc8 */
-	 PREFIX86(_invalid), //leave),            /* 0xc9 */
-	 PREFIX86(_retf_d16),         /* 0xca */
-	 PREFIX86(_retf),             /* 0xcb */
-	 PREFIX86(_int3),             /* 0xcc */
-	 PREFIX86(_int),              /* 0xcd */
-	 PREFIX86(_into),             /* 0xce */
-	 PREFIX86(_iret),             /* 0xcf */
-	 PREFIX86(_rotshft_b),        /* 0xd0 */
-	 PREFIX86(_rotshft_w),        /* 0xd1 */
-	 PREFIX86(_rotshft_bcl),      /* 0xd2 */
-	 PREFIX86(_rotshft_wcl),      /* 0xd3 */
-	 PREFIX86(_aam),              /* 0xd4 */
-	 PREFIX86(_aad),              /* 0xd5 */
-	 PREFIX86(_invalid),
-	 PREFIX86(_xlat),             /* 0xd7 */
-	 PREFIX86(_escape),           /* 0xd8 */
-	 PREFIX86(_escape),           /* 0xd9 */
-	 PREFIX86(_escape),           /* 0xda */
-	 PREFIX86(_escape),           /* 0xdb */
-	 PREFIX86(_escape),           /* 0xdc */
-	 PREFIX86(_escape),           /* 0xdd */
-	 PREFIX86(_escape),           /* 0xde */
-	 PREFIX86(_escape),           /* 0xdf */
-	 PREFIX86(_loopne),           /* 0xe0 */
-	 PREFIX86(_loope),            /* 0xe1 */
-	 PREFIX86(_loop),             /* 0xe2 */
-	 PREFIX86(_jcxz),             /* 0xe3 */
-	 PREFIX86(_inal),             /* 0xe4 */
-	 PREFIX86(_inax),             /* 0xe5 */
-	 PREFIX86(_outal),            /* 0xe6 */
-	 PREFIX86(_outax),            /* 0xe7 */
-	 PREFIX86(_call_d16),         /* 0xe8 */
-	 PREFIX86(_jmp_d16),          /* 0xe9 */
-	 PREFIX86(_jmp_far),          /* 0xea */
-	 PREFIX86(_jmp_d8),           /* 0xeb */
-	 PREFIX86(_inaldx),           /* 0xec */
-	 PREFIX86(_inaxdx),           /* 0xed */
-	 PREFIX86(_outdxal),          /* 0xee */
-	 PREFIX86(_outdxax),          /* 0xef */
-	 PREFIX86(_lock),             /* 0xf0 */
-	 PREFIX86(_invalid),          /* 0xf1 */
-	 PREFIX86(_repne),            /* 0xf2 */
-	 PREFIX86(_repe),             /* 0xf3 */
-	 PREFIX86(_hlt),		/* 0xf4 */
-	 PREFIX86(_cmc),              /* 0xf5 */
-	 PREFIX86(_f6pre),            /* 0xf6 */
-	 PREFIX86(_f7pre),            /* 0xf7 */
-	 PREFIX86(_clc),              /* 0xf8 */
-	 PREFIX86(_stc),              /* 0xf9 */
-	 PREFIX86(_cli),              /* 0xfa */
-	 PREFIX86(_sti),              /* 0xfb */
-	 PREFIX86(_cld),              /* 0xfc */
-	 PREFIX86(_std),              /* 0xfd */
-	 PREFIX86(_fepre),            /* 0xfe */
-	 PREFIX86(_ffpre)             /* 0xff */
+	I86_OPCODES(I86_TABLE_ENTRY)
 };
 
 #if defined(BIGCASE) && !defined(RS6000)
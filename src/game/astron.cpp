@@ -78,6 +78,23 @@ astron::astron()
     cpu.initial_pc        = 0;
     cpu.must_copy_context = false;
     cpu.mem = m_cpumem;
+
+    // the parts of the address space that cpu_mem_read/cpu_mem_write don't
+    // need to see (the bank rom window is remapped by port_write)
+    const struct cpu::mem_range mem_map[] = {
+        {0x0000, 0x7FFF, cpu::MAP_READ, NULL},    // main rom
+        {0x8000, 0xBFFF, cpu::MAP_READ, rombank}, // bank rom
+        {0xC000, 0xC2FF, cpu::MAP_READ, NULL},    // obj
+        {0xC400, 0xC7FF, cpu::MAP_WRITE, NULL},
+        {0xD000, 0xD7FF, cpu::MAP_WRITE, NULL},
+        {0xD800, 0xD8FF, cpu::MAP_READ, NULL},    // out
+        {0xD900, 0xDFFF, cpu::MAP_RAM, NULL},
+        {0xE000, 0xE1FF, cpu::MAP_READ, NULL},    // color
+        {0xE200, 0xEFFF, cpu::MAP_WRITE, NULL},   // F000-F7FF (characters) stays on the handler
+        {0xF800, 0xFFFF, cpu::MAP_RAM, NULL},     // work ram
+        {0, 0, cpu::MAP_END, NULL}
+    };
+    cpu.mem_map = mem_map;
     cpu::add(&cpu); // add a z80
 
     current_bank        = 0;
@@ -611,6 +628,13 @@ void astron::port_write(Uint16 port, Uint8 value)
     case 0x00: // astron switches rom banks with the D0 bit here
     case 0x01: // at 0x01 too?
         current_bank = value & 0x01;
+        {
+            const struct cpu::mem_range bank_map[] = {
+                {0x8000, 0xBFFF, cpu::MAP_READ, &rombank[0x4000 * current_bank]},
+                {0, 0, cpu::MAP_END, NULL}
+            };
+            cpu::map_memory(0, bank_map);
+        }
         break;
     default:
         LOGW << fmt("ERROR: CPU port %x write requested (value %x) but this "
@@ -38,6 +38,7 @@
 #include "../io/input.h"
 #include "../video/palette.h"
 #include "../video/video.h"
+#include "../video/yuvkernel.h"
 #include "../timer/timer.h"
 
 benchmark::benchmark()
@@ -50,6 +51,10 @@ benchmark::benchmark()
 
 void benchmark::start()
 {
+#ifdef BENCHMARK
+    yuvkernel::benchmark(); // per frame cost of the YUV post-processing
+#endif
+
     g_ldp->play(); // start the disc playing immediately
 
     Uint32 timer     = refresh_ms_time();
@@ -65,9 +70,34 @@ void benchmark::start()
     }
 
     // run for 60 seconds
+    // the first half composes every frame on the mix texture, the second
+    // half lets vid_blit() pick, so the two render paths can be compared
+    uint32_t blits;
+    double ms;
+    bool mixed = true;
+
+    video::set_mix_target(true);
+    video::get_blit_timing(blits, ms, true);
+
     while (!get_quitflag() && (elapsed_ms_time(timer) < ms_to_run)) {
         SDL_check_input();
         SDL_Delay(1000); // don't hog CPU
+
+        if (mixed && elapsed_ms_time(timer) >= (ms_to_run >> 1)) {
+            video::get_blit_timing(blits, ms, true);
+            LOGI << fmt("Blit via mix texture: %u frames, %.3f ms/frame", blits, ms);
+            video::set_mix_target(false);
+            mixed = false;
+        }
+    }
+
+    video::set_mix_target(false);
+
+    if (!mixed) {
+        video::get_blit_timing(blits, ms, true);
+        LOGI << fmt("Blit %s: %u frames, %.3f ms/frame",
+                    video::get_fRotateDegrees() != 0 ? "via mix texture (rotated)" :
+                    "direct to backbuffer", blits, ms);
     }
 }
 
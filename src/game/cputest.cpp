@@ -37,6 +37,10 @@
 #include "../cpu/cpu-debug.h"
 #include "../cpu/cpu.h"
 #include "../cpu/generic_z80.h"
+#include "../cpu/nes6502.h"
+#include "../cpu/6809infc.h"
+#include "../cpu/mamewrap.h"
+#include "../cpu/x86/i86intf.h"
 #include "../io/conout.h"
 #include "../io/input.h"
 #include "../timer/timer.h"
@@ -44,7 +48,7 @@
 
 //////////////////////////////////////////////////////////////////////////
 
-cputest::cputest() : m_uZeroCount(0), m_bStarted(false)
+cputest::cputest() : m_uZeroCount(0), m_bStarted(false), m_bBenchmark(false)
 {
     struct cpu::def cpu; // structure we will define our cpu in
 
@@ -67,6 +71,13 @@ bool cputest::init()
 {
     bool bSuccess = false;
 
+    // the benchmarks drive the cores directly, so they don't need CPU_DEBUG
+    if (m_bBenchmark) {
+        run_benchmark();
+        set_quitflag();
+        return true;
+    }
+
 #ifdef CPU_DEBUG
     // this cpu test requirescpu::type::DEBUG to be enabled because that's the only
     // way that the update_pc callback will get called.
@@ -81,6 +92,8 @@ bool cputest::init()
 
 void cputest::shutdown()
 {
+    if (m_bBenchmark) return;
+
     Uint32 elapsed_ms = GET_TICKS() - m_speedtimer;
 
     LOGI << fmt("Z80 cputest executed in %d ms", elapsed_ms);
@@ -183,9 +196,216 @@ void cputest::set_preset(int val)
     case 2: // tests for GCC4 compiler bug
         m_rom_list = branchtest_rom;
         break;
+    case 3: // opcode benchmarks for every core, no rom needed
+        m_bBenchmark = true;
+        break;
     default:
         LOGW << "Bad preset!";
         set_quitflag();
         break;
     } // end switch
 }
+
+//////////////////////////////////////////////////////////////////////////
+// Opcode benchmarks (-preset 3)
+// Runs a few small loops (register/ALU work, memory read-modify-write and
+// subroutine calls) on each cpu core and logs how many emulated MHz the core
+// manages, so dispatch changes can be measured on the target hardware.
+
+// emulated cycles per kernel, and the slice the core is called with each time
+// (about what cpu::execute hands a core per interleave)
+static const Uint64 BENCH_CYCLES = 50000000;
+static const Uint32 BENCH_SLICE  = 20000;
+
+struct bench_kernel {
+    const char *name;
+    Uint8 code[24]; // subroutines (if any) start at +0x10
+    unsigned int size;
+};
+
+struct bench_core {
+    const char *name;
+    Uint16 org; // where the kernels are loaded and started
+    void (*start)(Uint8 *mem, Uint16 org);
+    Uint32 (*run)(Uint32 cycles);
+    bench_kernel kernels[3];
+};
+
+#ifdef USE_M80
+static void bench_z80_start(Uint8 *mem, Uint16 org)
+{
+    m80_set_opcode_base(mem);
+    m80_reset();
+    m80_set_pc(org);
+}
+#endif
+
+static void bench_6502_start(Uint8 *mem, Uint16 org)
+{
+    mem[0xFFFC] = org & 0xFF; // reset vector
+    mem[0xFFFD] = org >> 8;
+    cpu::generic_6502_setmemory(mem);
+    cpu::generic_6502_reset();
+}
+
+static void bench_6809_start(Uint8 *mem, Uint16 org)
+{
+    mem[0xFFFE] = org >> 8; // reset vector
+    mem[0xFFFF] = org & 0xFF;
+    m6809_set_memory(mem);
+    m6809_reset();
+}
+
+static void bench_i86_start(Uint8 *mem, Uint16 org)
+{
+    mw_i86_set_mem(mem);
+    i86_reset();
+    i86_set_pc(org);
+}
+
+static const bench_core g_bench_cores[] = {
+#ifdef USE_M80
+    {"z80", 0x100, bench_z80_start, m80_execute,
+     {{"alu", {0x3E, 0x01,             // ld a,1
+               0x06, 0x00,             // ld b,0
+               0x80,                   // add a,b
+               0xEE, 0x55,             // xor 55h
+               0x4F,                   // ld c,a
+               0x10, 0xFA,             // djnz -6
+               0xC3, 0x02, 0x01},      // jp 0102h
+       13},
+      {"mem", {0x21, 0x00, 0x80,       // ld hl,8000h
+               0x06, 0x00,             // ld b,0
+               0x7E,                   // ld a,(hl)
+               0x3C,                   // inc a
+               0x77,                   // ld (hl),a
+               0x23,                   // inc hl
+               0x10, 0xFA,             // djnz -6
+               0xC3, 0x00, 0x01},      // jp 0100h
+       14},
+      {"call", {0x31, 0x00, 0xF0,      // ld sp,0F000h
+                0xCD, 0x10, 0x01,      // call 0110h
+                0xC5,                  // push bc
+                0xC1,                  // pop bc
+                0x18, 0xF9,            // jr -7
+                0, 0, 0, 0, 0, 0,
+                0x23,                  // inc hl
+                0xC9},                 // ret
+       18}}},
+#endif
+    {"6502", 0x200, bench_6502_start, nes6502_execute,
+     {{"alu", {0xA9, 0x01,             // lda #1
+               0xA2, 0x00,             // ldx #0
+               0x18,                   // clc
+               0x69, 0x03,             // adc #3
+               0x49, 0x55,             // eor #$55
+               0xA8,                   // tay
+               0xCA,                   // dex
+               0xD0, 0xF7,             // bne -9
+               0x4C, 0x02, 0x02},      // jmp $0202
+       16},
+      {"mem", {0xA2, 0x00,             // ldx #0
+               0xBD, 0x00, 0x03,       // lda $0300,x
+               0x69, 0x01,             // adc #1
+               0x9D, 0x00, 0x03,       // sta $0300,x
+               0xE6, 0x10,             // inc $10
+               0xE8,                   // inx
+               0xD0, 0xF3,             // bne -13
+               0x4C, 0x00, 0x02},      // jmp $0200
+       18},
+      {"call", {0xA2, 0xFF,            // ldx #$ff
+                0x9A,                  // txs
+                0x20, 0x10, 0x02,      // jsr $0210
+                0x48,                  // pha
+                0x68,                  // pla
+                0x4C, 0x03, 0x02,      // jmp $0203
+                0, 0, 0, 0, 0,
+                0xE8,                  // inx
+                0x60},                 // rts
+       18}}},
+    {"6809", 0x200, bench_6809_start, mc6809_StepExec,
+     {{"alu", {0x86, 0x01,             // lda #1
+               0x8E, 0x01, 0x00,       // ldx #$100
+               0x8B, 0x03,             // adda #3
+               0x88, 0x55,             // eora #$55
+               0x1F, 0x89,             // tfr a,b
+               0x30, 0x1F,             // leax -1,x
+               0x26, 0xF6,             // bne -10
+               0x20, 0xF1},            // bra -15
+       17},
+      {"mem", {0x8E, 0x03, 0x00,       // ldx #$300
+               0xA6, 0x84,             // lda ,x
+               0x4C,                   // inca
+               0xA7, 0x80,             // sta ,x+
+               0x8C, 0x04, 0x00,       // cmpx #$400
+               0x26, 0xF6,             // bne -10
+               0x20, 0xF1},            // bra -15
+       15},
+      {"call", {0x10, 0xCE, 0xF0, 0x00, // lds #$f000
+                0x8D, 0x0A,            // bsr +10
+                0x34, 0x06,            // pshs a,b
+                0x35, 0x06,            // puls a,b
+                0x20, 0xF8,            // bra -8
+                0, 0, 0, 0,
+                0x30, 0x01,            // leax 1,x
+                0x39},                 // rts
+       19}}},
+    {"i86", 0x200, bench_i86_start, i86_execute,
+     {{"alu", {0xB8, 0x01, 0x00,       // mov ax,1
+               0xB9, 0x00, 0x01,       // mov cx,100h
+               0x05, 0x03, 0x00,       // add ax,3
+               0x35, 0x55, 0x00,       // xor ax,55h
+               0x89, 0xC3,             // mov bx,ax
+               0xE2, 0xF6,             // loop -10
+               0xEB, 0xF1},            // jmp -15
+       18},
+      {"mem", {0xBE, 0x00, 0x03,       // mov si,300h
+               0xB9, 0x00, 0x01,       // mov cx,100h
+               0x8A, 0x04,             // mov al,[si]
+               0xFE, 0xC0,             // inc al
+               0x88, 0x04,             // mov [si],al
+               0x46,                   // inc si
+               0xE2, 0xF7,             // loop -9
+               0xEB, 0xEF},            // jmp -17
+       17},
+      {"call", {0xBC, 0x00, 0xF0,      // mov sp,0F000h
+                0xE8, 0x0A, 0x00,      // call +10
+                0x50,                  // push ax
+                0x58,                  // pop ax
+                0xEB, 0xF9,            // jmp -7
+                0, 0, 0, 0, 0, 0,
+                0x43,                  // inc bx
+                0xC3},                 // ret
+       18}}},
+};
+
+void cputest::run_benchmark()
+{
+    // the 6502 and 6809 cores need their interfaces set up before they can run
+    cpu::generic_6502_init();
+    initialize_m6809();
+    i86_init();
+
+    LOGI << fmt("cputest: running each kernel for %u million cycles",
+                (unsigned int)(BENCH_CYCLES / 1000000));
+
+    for (const bench_core &core : g_bench_cores) {
+        for (const bench_kernel &k : core.kernels) {
+            memset(m_cpumem, 0, 0x10000);
+            memcpy(&m_cpumem[core.org], k.code, k.size);
+            core.start(m_cpumem, core.org);
+            core.run(BENCH_SLICE); // warm up
+
+            Uint64 cycles = 0;
+            Uint64 start  = SDL_GetTicksNS();
+            while (cycles < BENCH_CYCLES) cycles += core.run(BENCH_SLICE);
+            Uint64 ns = SDL_GetTicksNS() - start;
+
+            LOGI << fmt("cputest %-4s %-4s %9.2f MHz", core.name, k.name,
+                        ns ? (double)cycles * 1000.0 / ns : 0.0);
+        }
+    }
+
+    i86_exit();
+    cpu::generic_6502_shutdown();
+}
@@ -40,9 +40,12 @@ class cputest : public game
     void start();
 
   private:
+    void run_benchmark();
+
     Uint32 m_speedtimer;
     unsigned int m_uZeroCount;
     bool m_bStarted;
+    bool m_bBenchmark; // -preset 3, time opcode kernels on each core and quit
 };
 
 #endif
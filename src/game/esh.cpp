@@ -48,6 +48,14 @@ enum { S_ESH_BEEP };
 
 ////////////////
 
+// the parts of the address space that cpu_mem_write doesn't need to see
+static const struct cpu::mem_range esh_mem_map[] = {
+    {0x0000, 0xFFFF, cpu::MAP_READ, NULL},
+    {0x0000, 0xEFFF, cpu::MAP_WRITE, NULL},
+    {0xF800, 0xFFFF, cpu::MAP_WRITE, NULL}, // F000-F7FF is video memory
+    {0, 0, cpu::MAP_END, NULL}
+};
+
 esh::esh() : m_needlineblink(false), m_needcharblink(false)
 {
     struct cpu::def cpu;
@@ -78,6 +86,7 @@ esh::esh() : m_needlineblink(false), m_needcharblink(false)
                                              // (likely guess)
     cpu.irq_period[0] = (1000.0 / 60.0);     // irq from vblank (guess)
     cpu.mem = m_cpumem;
+    cpu.mem_map = esh_mem_map;
     cpu::add(&cpu); // add z80 cpu
 
     blank_count      = 0;
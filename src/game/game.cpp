@@ -93,6 +93,9 @@ game::game()
       m_video_overlay_height(0),          // " " "
       m_video_overlay_needs_update(true), // it always needs to be updated the
                                           // first time
+      m_video_overlay_dirty({0, 0, 0, 0}),
+      m_video_overlay_dirty_all(true),
+      m_video_overlay_dirty_reported(false),
       m_bMouseEnabled(false)              // mouse is disabled for most games
 {
     memset(m_video_overlay, 0, sizeof(m_video_overlay)); // clear this structure
@@ -374,6 +377,7 @@ bool game::init_video()
             }
 
             video::set_overlay_offset(m_video_col_offset, m_video_row_offset);
+            m_video_overlay_dirty_all = true;
 
         } // end if video overlay is used
 
@@ -415,24 +419,6 @@ void game::shutdown_video()
     }
 }
 
-// Note: The way it is implemented works only for UPscaling the game-graphics.
-//       If game graphic needs to be DOWNscaled, multiple pixels would have to
-//       be
-//       combined into one pixel of the resulting surface.
-void Scale(SDL_Surface *src, SDL_Surface *dst, long *matrix)
-{
-    long i;
-    long m = dst->w * dst->h;
-
-    Uint8 *srcpixmap = (Uint8 *)src->pixels;
-    Uint8 *dstpixmap = (Uint8 *)dst->pixels;
-
-    for (i = 0; i < m; i++) {
-        dstpixmap[i] = srcpixmap[matrix[i]];
-    } /*endfor*/
-}
-// end-add
-
 // generic function to ensure that the video buffer gets drawn to the screen,
 // will call repaint()
 void game::blit()
@@ -455,7 +441,14 @@ void game::blit()
             false; // game will need to set this value to true next time it
                    // becomes needful for us to redraw the screen
 
-        video::vid_update_overlay_surface(m_video_overlay[m_active_video_overlay]);
+        bool all = m_video_overlay_dirty_all || SDL_RectEmpty(&m_video_overlay_dirty);
+
+        video::vid_update_overlay_surface(m_video_overlay[m_active_video_overlay],
+                                          all ? NULL : &m_video_overlay_dirty);
+
+        m_video_overlay_dirty          = {0, 0, 0, 0};
+        m_video_overlay_dirty_all      = false;
+        m_video_overlay_dirty_reported = false;
     }
     video::vid_blit();
 }
@@ -468,7 +461,7 @@ void game::force_blit()
     // if the game uses a video overlay, we have to go through this blit
     // routine to update a bunch of variables
     if (m_game_uses_video_overlay) {
-        m_video_overlay_needs_update = true;
+        set_video_overlay_needs_update(true);
         blit();
     }
 
@@ -525,9 +518,26 @@ void game::resize()
 
 void game::set_video_overlay_needs_update(bool value)
 {
+    // whoever changed the overlay didn't say where
+    if (value && !m_video_overlay_dirty_reported) m_video_overlay_dirty_all = true;
+
+    m_video_overlay_dirty_reported = false;
     m_video_overlay_needs_update = value;
 }
 
+void game::set_video_overlay_dirty(const SDL_Rect *rect)
+{
+    SDL_Rect full = {0, 0, (int)m_video_overlay_width, (int)m_video_overlay_height};
+    SDL_Rect r;
+
+    m_video_overlay_dirty_reported = true;
+
+    if (!rect) m_video_overlay_dirty_all = true;
+    else if (!SDL_GetRectIntersection(rect, &full, &r)) return;
+    else if (SDL_RectEmpty(&m_video_overlay_dirty)) m_video_overlay_dirty = r;
+    else SDL_GetRectUnion(&m_video_overlay_dirty, &r, &m_video_overlay_dirty);
+}
+
 Uint8 game::get_overlay_depth() { return m_overlay_depth; }
 
 unsigned int game::get_video_overlay_height() { return m_video_overlay_height; }
@@ -1064,4 +1074,4 @@ void game::set_mice_detected(int thisMany) { m_miceDetected = thisMany; }
 
 bool game::getGameNeedsOverlayUpdate() { return m_video_overlay_needs_update; }
 
-void game::setGameNeedsOverlayUpdate(bool val) { m_video_overlay_needs_update = val; }
+void game::setGameNeedsOverlayUpdate(bool val) { set_video_overlay_needs_update(val); }
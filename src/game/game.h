@@ -193,6 +193,13 @@ class game
     // part of the game class)
     void set_video_overlay_needs_update(bool value);
 
+    // tells blit() which part of the overlay changed (NULL for all of it) so
+    // only that part gets converted and uploaded.  It covers the next
+    // set_video_overlay_needs_update(true); any call to that which isn't
+    // preceded by one of these refreshes the whole overlay, as does a blit
+    // with nothing reported.  Rects are clipped to the overlay.
+    void set_video_overlay_dirty(const SDL_Rect *rect);
+
     // returns m_video_overlay_width
     unsigned int get_video_overlay_width();
 
@@ -382,6 +389,10 @@ class game
     // The game is responsible for setting this value to true when it knows that
     // the repaint needs to be called
 
+    SDL_Rect m_video_overlay_dirty;  // changed since the last blit, see
+    bool m_video_overlay_dirty_all;  // set_video_overlay_dirty()
+    bool m_video_overlay_dirty_reported; // since the last needs_update(true)
+
     bool m_video_no_overlay;
 
     // if the game uses the mouse, this should be set to true IN THE GAME'S
@@ -55,6 +55,13 @@ bool g_bBootLog = true;
 
 //////////////////////////////////////////////////////////////////////////
 
+// the parts of the address space that cpu_mem_read/cpu_mem_write don't need to see
+static const struct cpu::mem_range lair_mem_map[] = {
+    {0x0000, 0xBFFF, cpu::MAP_READ, NULL},  // ROM and RAM
+    {0xA100, 0xAFFF, cpu::MAP_WRITE, NULL}, // RAM (A01C plays the beeps)
+    {0, 0, cpu::MAP_END, NULL}
+};
+
 // lair class constructor (default the rev F2 roms)
 lair::lair() : m_bUseAnnunciator(false), m_pScoreboard(NULL)
 {
@@ -80,6 +87,7 @@ lair::lair() : m_bUseAnnunciator(false), m_pScoreboard(NULL)
     cpu.initial_pc        = 0;
     cpu.must_copy_context = false;
     cpu.mem = m_cpumem;
+    cpu.mem_map = lair_mem_map;
     cpu::add(&cpu); // add this cpu to the list (it will be our only one)
 
     struct sound::chip soundchip;
@@ -176,6 +176,8 @@ static const SDL_Color m_colorTransparent = {0, 0, 0, 0};
 
 int (*g_original_prepare_frame)(uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane,
                int Ypitch, int Upitch, int Vpitch);
+int (*g_original_prepare_held_frame)(uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane,
+               int Ypitch, int Upitch, int Vpitch, void *ref);
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -580,6 +582,10 @@ static void sep_capture_vldp()
     // Intercept VLDP callback
     g_original_prepare_frame = g_pSingeIn->g_local_info->prepare_frame;
     g_pSingeIn->g_local_info->prepare_frame = sep_prepare_frame_callback;
+
+    // every frame has to come through the callback above
+    g_original_prepare_held_frame = g_pSingeIn->g_local_info->prepare_held_frame;
+    g_pSingeIn->g_local_info->prepare_held_frame = NULL;
 }
 
 static bool sep_init_mixer()
@@ -697,6 +703,7 @@ void sep_print(const char *fmt, ...)
 void sep_release_vldp()
 {
     g_pSingeIn->g_local_info->prepare_frame = g_original_prepare_frame;
+    g_pSingeIn->g_local_info->prepare_held_frame = g_original_prepare_held_frame;
 }
 
 void sep_set_static_pointers(double *m_disc_fps, unsigned int *m_uDiscFPKS)
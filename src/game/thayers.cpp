@@ -42,6 +42,14 @@
 #include "../cpu/cpu.h"
 #include "../cpu/generic_z80.h"
 
+// the parts of the address space that cpu_mem_read/cpu_mem_write don't need to see
+static const struct cpu::mem_range thayers_mem_map[] = {
+    {0x0000, 0xBDFF, cpu::MAP_RAM, NULL},
+    {0xBE00, 0xBEFF, cpu::MAP_WRITE, NULL}, // BE17 is faked in cpu_mem_read
+    {0xBF00, 0xFFFF, cpu::MAP_RAM, NULL},
+    {0, 0, cpu::MAP_END, NULL}
+};
+
 thayers::thayers() : m_pScoreboard(NULL)
 {
     struct cpu::def cpu;
@@ -61,6 +69,7 @@ thayers::thayers() : m_pScoreboard(NULL)
     cpu.initial_pc        = 0;
     cpu.must_copy_context = false;
     cpu.mem = m_cpumem;
+    cpu.mem_map = thayers_mem_map;
     cpu::add(&cpu);
 
     cpu.type = cpu::type::COP421;
@@ -69,6 +78,7 @@ thayers::thayers() : m_pScoreboard(NULL)
     cpu.nmi_period        = 0;
     cpu.must_copy_context = false;
     cpu.mem = coprom;
+    cpu.mem_map = NULL;
     cpu::add(&cpu);
 
     m_irq_status = 0x3f;
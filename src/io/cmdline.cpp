@@ -37,6 +37,7 @@
 #include "../io/numstr.h"
 #include "../video/video.h"
 #include "../video/led.h"
+#include "../video/capture.h"
 #include "../hypseus.h"
 #include "../cpu/cpu-debug.h" // for set_cpu_trace
 #include "../game/lair.h"
@@ -773,6 +774,35 @@ bool parse_cmd_line(int argc, char **argv)
                     printline("NOTE : Min seek delay disabled");
             }
 
+            // memory budget (in MB) for caching frames that have been
+            // searched to, 0 = disabled
+            else if (strcasecmp(s, "-framecache") == 0) {
+                get_next_word(s, sizeof(s));
+                i = atoi(s);
+
+                if ((i >= 0) && (i <= 4096))
+                    g_ldp->set_frame_cache_mb((unsigned int)i);
+                else {
+                    printerror("-framecache must be between 0 and 4096 MB");
+                    result = false;
+                }
+            }
+
+            // record the screen and sound to <name>.y4m and <name>.wav,
+            // or pipe the video into a command with -capture "|command"
+            else if (strcasecmp(s, "-capture") == 0) {
+                get_next_word(s, sizeof(s));
+
+                if (s[0] == '\0' || (s[0] == '|' && s[1] == '\0')) {
+                    printerror("capture switch used but no output specified!");
+                    result = false;
+                }
+                else capture::set_target(s);
+            }
+            else if (strcasecmp(s, "-capture_overlay") == 0) {
+                capture::set_overlay(true);
+            }
+
             // if the user wants the searching to be the old blocking style
             // instead of non-blocking
             else if (strcasecmp(s, "-blocking") == 0) {
@@ -26,8 +26,7 @@
 // handles the audio portion of VLDP (using Ogg Vorbis)
 
 #ifdef UNIX
-//#define TRY_MMAP 1	// NOTE : this seems to fail on read-only filesystems
-//(such as NTFS mounted from linux)
+#define TRY_MMAP 1 // if the mapping fails, the file is read into RAM instead
 #endif
 
 #include "ldp-vldp.h"
@@ -46,6 +45,10 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
 #include <vorbis/codec.h> // OGG VORBIS specific headers
 #include <vorbis/vorbisfile.h>
 
@@ -56,9 +59,37 @@
 // how much uncompressed audio we deal with at a time
 #define AUDIO_BUF_CHUNK 4096
 
-// Macros to lock and unlock the mutex for the audio to make sure we aren't
-// playing audio while
-// we are loading or seeking
+// Uncompressed audio waiting for the audio callback (must be a power of 2,
+// 65536 bytes is about 370ms)
+#define AUDIO_RING_SIZE 65536
+#define AUDIO_RING_MASK (AUDIO_RING_SIZE - 1)
+
+// how long the decoder thread sleeps when it has nothing to do but might
+// soon (the ring is full, or it has reached the end of the stream)
+#define AUDIO_IDLE_MS 5
+
+// Audio seeks decode forward from the nearest indexed page; if that would mean
+// decoding more than this many samples, the index is no use and vorbisfile's
+// own seek is used instead
+#define AUDIO_SEEK_MAX_DECODE 44100
+
+// The page index for foo.ogg is cached in foo.oix:
+//   audio_index_header
+//   Sint64 granule[page_count]; // granule position at the end of each page
+//   Uint32 offset[page_count];  // byte offset of each page
+// (only pages that finish a packet are indexed)
+#define AUDIO_INDEX_VERSION 1
+struct audio_index_header {
+    char magic[4];     // "OIDX"
+    Uint32 version;    // AUDIO_INDEX_VERSION
+    Uint32 ogg_size;   // size of the .ogg the index was made from
+    Uint32 serial;     // bitstream serial number of the .ogg
+    Uint32 page_count; // how many pages are indexed
+};
+
+// Macros to lock and unlock the mutex that keeps the decoder thread away from
+// the ogg stream while we are loading or closing it.  The audio callback
+// never takes it.
 #define OGG_LOCK SDL_LockMutex(g_ogg_mutex)
 #define OGG_UNLOCK SDL_UnlockMutex(g_ogg_mutex)
 
@@ -68,18 +99,73 @@ typedef void *(*audiocopyproc)(void *dest, const void *src, size_t bytes_to_copy
 audiocopyproc paudiocopy = memcpy; // pointer to the audio copy procedure
                                    // (defaults to memcpy)
 
-SDL_Mutex *g_ogg_mutex   = NULL;
-mpo_io *g_pIOAudioHandle = NULL;
-OggVorbis_File s_ogg;
-
-Uint32 g_audio_filesize = 0;     // total size of the audio stream
-Uint32 g_audio_filepos  = 0;     // the position in the file of our audio stream
-Uint8 *g_big_buf        = NULL;  // holds entire Ogg stream in RAM :)
-bool g_audio_ready      = false; // whether audio is ready to be parsed
-bool g_audio_playing    = false; // whether the audio is to be playing or not
-Uint32 g_playing_timer  = 0;     // the time at which we began playing audio
-Uint32 g_samples_played = 0; // how many samples have played since we've been
-                             // timing
+SDL_Mutex *g_ogg_mutex    = NULL;
+SDL_Condition *g_ogg_cond = NULL; // wakes up the decoder thread
+SDL_Thread *g_ogg_thread  = NULL; // decodes the ogg stream into g_audio_ring
+bool g_ogg_quit           = false; // tells the decoder thread to exit
+
+// An opened .ogg.  The last few that were used stay open so that searches
+// which go back and forth between the segments of a multi-file disc don't
+// have to load them again.
+struct audio_source {
+    string path;    // full path of the .ogg
+    Uint8 *buf;     // holds entire Ogg stream (mapped or in RAM) :)
+    Uint32 size;    // total size of the audio stream
+    Uint32 pos;     // the position in the file of our audio stream
+    bool mapped;    // whether buf is mapped (else it was new[]'d)
+    OggVorbis_File ogg;
+    std::vector<Sint64> page_granule; // page index (see audio_index_header)
+    std::vector<Uint32> page_offset;
+    Uint32 last_used; // when it was last opened (from g_audio_open_count)
+};
+
+#define AUDIO_SOURCE_CACHE 4
+audio_source *g_audio_sources[AUDIO_SOURCE_CACHE] = {NULL};
+audio_source *g_cur_audio  = NULL; // the one we're playing (protected by
+                                   // g_ogg_mutex)
+Uint32 g_audio_open_count = 0;
+
+std::atomic<bool> g_audio_ready(false);   // whether audio is ready to be parsed
+std::atomic<bool> g_audio_playing(false); // whether the audio is to be playing
+                                          // or not
+std::atomic<Uint32> g_playing_timer(0);   // the time at which we began playing
+                                          // audio
+std::atomic<Uint32> g_play_count(0);      // bumped by each audio_play()
+Uint32 g_play_count_seen = 0; // the last g_play_count the callback saw
+Uint32 g_samples_played  = 0; // how many samples have played since we've been
+                              // timing (only used by the audio callback)
+
+// PCM decoded by the decoder thread.  Only the decoder thread writes to the
+// ring and advances g_ring_write, only the audio callback reads from it and
+// advances g_ring_read.  Both count bytes forever and are masked to index the
+// ring.
+Uint8 g_audio_ring[AUDIO_RING_SIZE];
+std::atomic<Uint32> g_ring_write(0);
+std::atomic<Uint32> g_ring_read(0);
+std::atomic<Uint32> g_ring_flush_to(0);  // the callback skips everything before
+                                         // this (it's from before a seek)
+std::atomic<bool> g_audio_eof(false);    // decoder thread has nothing more to add
+
+// seek_audio() posts seeks to the decoder thread, which has finished them when
+// g_seek_done catches up with g_seek_posted
+std::atomic<Uint64> g_seek_target(0);
+std::atomic<Uint32> g_seek_posted(0);
+std::atomic<Uint32> g_seek_done(0);
+
+// how often the audio callback had nothing to give, and how many samples it
+// threw away to catch up with the video
+std::atomic<Uint32> g_audio_underruns(0);
+std::atomic<Uint64> g_audio_late_samples(0);
+
+// when the last seek was posted, and how long seeks have been taking (the
+// totals are only written by the decoder thread)
+std::atomic<Uint32> g_seek_posted_ms(0);
+std::atomic<Uint32> g_audio_seeks(0);
+std::atomic<Uint64> g_audio_seek_ms_total(0);
+std::atomic<Uint32> g_audio_seek_ms_max(0);
+
+char g_seek_scratch[AUDIO_BUF_CHUNK]; // where audio_seek() decodes to
+
 bool g_audio_left_muted  = false; // left audio channel enabled
 bool g_audio_right_muted = false; // right audio channel enabled
 string m_oggpath         = "";
@@ -92,32 +178,25 @@ unsigned int g_uCallbackDbgTimer   = 0;
 
 ///////////////////////////////////////////////////////////////////////////////////
 
-// resets mm states
-void mmreset()
-{
-    g_audio_filepos = 0; // rewind back to position #0
-}
-
 // replaces fread
 size_t mmread(void *ptr, size_t size, size_t nmemb, void *datasource)
 {
+    audio_source *src    = (audio_source *)datasource;
     size_t bytes_to_read = size * nmemb; // how many bytes to be read
-    // where to get the data from
-    Uint8 *src = ((Uint8 *)datasource) + g_audio_filepos;
 
     //	printf("mmread being called.. size is %d, nmemb is %d, bytes_to_read is
     //%d\n", size, nmemb, bytes_to_read);
 
-    if (g_audio_filepos + bytes_to_read > g_audio_filesize) {
+    if (src->pos + bytes_to_read > src->size) {
         bytes_to_read = 0;
-        if (g_audio_filepos < g_audio_filesize) {
-            bytes_to_read = g_audio_filesize - g_audio_filepos;
+        if (src->pos < src->size) {
+            bytes_to_read = src->size - src->pos;
         }
     }
 
     if (bytes_to_read != 0) {
-        memcpy(ptr, src, bytes_to_read); // copy the memory
-        g_audio_filepos += bytes_to_read;
+        memcpy(ptr, src->buf + src->pos, bytes_to_read); // copy the memory
+        src->pos += (Uint32)bytes_to_read;
     }
 
     return (bytes_to_read);
@@ -129,21 +208,18 @@ size_t mmread(void *ptr, size_t size, size_t nmemb, void *datasource)
 
 int mmseek(void *datasource, int64_t offset, int whence)
 {
-    int result = -1;
+    audio_source *src = (audio_source *)datasource;
+    int result        = -1;
 
     //	printf("mmseek being called, whence is %d\n", whence);
 
-    // just to get rid of warnings
-    if (datasource) {
-    }
-
     switch (whence) {
     case SEEK_SET:
         // bug fix by Arnaud Gibert
-        if (offset <= g_audio_filesize) {
+        if (offset <= src->size) {
             // make sure offset is positive so we don't get into trouble
             if (offset >= 0) {
-                g_audio_filepos = (Uint32)offset;
+                src->pos = (Uint32)offset;
             } else {
                 LOGW << "SEEK_SET used with a negative offset!";
             }
@@ -151,17 +227,17 @@ int mmseek(void *datasource, int64_t offset, int whence)
         }
         break;
     case SEEK_CUR:
-        if (offset + g_audio_filepos <= g_audio_filesize) {
-            g_audio_filepos = (unsigned int)(g_audio_filepos + offset);
-            result          = 0;
+        if (offset + src->pos <= src->size) {
+            src->pos = (unsigned int)(src->pos + offset);
+            result   = 0;
         }
         break;
     case SEEK_END:
         //		printf("SEEK_END being called, offset is %x, whence is %d!\n",
         //(Uint32) offset, whence);
-        if (g_audio_filesize + offset <= g_audio_filesize) {
-            g_audio_filepos = (unsigned int)(g_audio_filesize + offset);
-            result          = 0;
+        if (src->size + offset <= src->size) {
+            src->pos = (unsigned int)(src->size + offset);
+            result   = 0;
         }
         break;
     }
@@ -171,24 +247,20 @@ int mmseek(void *datasource, int64_t offset, int whence)
 
 int mmclose(void *datasource)
 {
-    // safety check
-    if (datasource != g_big_buf) {
-        LOGE << "datasource != g_bigbuf, this should never happen!";
-    }
+    audio_source *src = (audio_source *)datasource;
 
 #ifdef TRY_MMAP
-    LOGD << "Unmapping audio stream from memory ...";
-    munmap(g_big_buf, g_audio_filesize);
-    datasource = NULL;
-#else
-    LOGD << "Freeing memory used to store audio stream...";
-    // free(datasource);
-    delete[] g_big_buf;
-    g_big_buf = NULL;
+    if (src->mapped) {
+        LOGD << "Unmapping audio stream from memory ...";
+        munmap(src->buf, src->size);
+        src->buf = NULL;
+    }
 #endif
-
-    mpo_close(g_pIOAudioHandle);
-    g_pIOAudioHandle = NULL;
+    if (src->buf) {
+        LOGD << "Freeing memory used to store audio stream...";
+        delete[] src->buf;
+        src->buf = NULL;
+    }
 
     return 0;
 }
@@ -196,12 +268,9 @@ int mmclose(void *datasource)
 long mmtell(void *datasource)
 {
     //	printf("mmtell being called, filepos is %x\n", (Uint32)
-    // g_audio_filepos);
-
-    if (datasource) {
-    }
+    // ((audio_source *)datasource)->pos);
 
-    return g_audio_filepos;
+    return ((audio_source *)datasource)->pos;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -343,6 +412,361 @@ void ldp_vldp::oggize_path(string &oggpath, string m2vpath)
     oggpath += ".ogg";
 }
 
+// reads a little-endian value out of an ogg page header
+static Uint64 ogg_read_le(const Uint8 *p, unsigned int bytes)
+{
+    Uint64 val = 0;
+
+    while (bytes > 0) {
+        --bytes;
+        val = (val << 8) | p[bytes];
+    }
+
+    return val;
+}
+
+// Walks the pages of the ogg stream in 'buf' and indexes every page of the
+// first bitstream that finishes a packet.  Returns that bitstream's serial
+// number.
+static Uint32 audio_index_build(audio_source *src)
+{
+    const Uint8 *buf = src->buf;
+    Uint32 size      = src->size;
+    Uint32 pos       = 0;
+    Uint32 serial    = 0;
+    bool bFirst      = true;
+
+    src->page_granule.clear();
+    src->page_offset.clear();
+
+    while (size - pos >= 27) {
+        const Uint8 *page = buf + pos;
+        Uint32 page_size  = 27 + page[26];
+
+        // we've lost sync somehow, so look for the next page
+        if (memcmp(page, "OggS", 4) != 0) {
+            ++pos;
+            continue;
+        }
+
+        if (page_size > size - pos) break;
+        for (unsigned int i = 0; i < page[26]; i++) {
+            page_size += page[27 + i];
+        }
+        if (page_size > size - pos) break;
+
+        if (bFirst) {
+            serial = (Uint32)ogg_read_le(page + 14, 4);
+            bFirst = false;
+        }
+
+        Sint64 granule = (Sint64)ogg_read_le(page + 6, 8);
+
+        // a granule position of -1 means no packet finishes on this page
+        if ((granule != -1) && ((Uint32)ogg_read_le(page + 14, 4) == serial)) {
+            src->page_granule.push_back(granule);
+            src->page_offset.push_back(pos);
+        }
+
+        pos += page_size;
+    }
+
+    return serial;
+}
+
+// loads the cached page index for 'src', returns false if there isn't one or
+// it was made from a different .ogg
+static bool audio_index_load(const string &strIndexPath, audio_source *src)
+{
+    const Uint8 *buf = src->buf;
+    Uint32 size      = src->size;
+    bool result = false;
+    struct audio_index_header header;
+    FILE *F = fopen(strIndexPath.c_str(), "rb");
+
+    if (!F) return false;
+
+    if ((size >= 18) && (fread(&header, sizeof(header), 1, F) == 1) &&
+        (memcmp(header.magic, "OIDX", 4) == 0) &&
+        (header.version == AUDIO_INDEX_VERSION) && (header.ogg_size == size) &&
+        (header.serial == (Uint32)ogg_read_le(buf + 14, 4)) &&
+        (header.page_count <= size / 28)) {
+        src->page_granule.resize(header.page_count);
+        src->page_offset.resize(header.page_count);
+
+        if ((header.page_count == 0) ||
+            ((fread(&src->page_granule[0], sizeof(Sint64), header.page_count, F) ==
+              header.page_count) &&
+             (fread(&src->page_offset[0], sizeof(Uint32), header.page_count, F) ==
+              header.page_count))) {
+            result = true;
+        }
+    }
+
+    fclose(F);
+
+    if (!result) {
+        src->page_granule.clear();
+        src->page_offset.clear();
+    }
+
+    return result;
+}
+
+// indexes a stream that has just been opened, using the cached index next to
+// it if it is still good and (re)writing it otherwise
+static void audio_index_open(audio_source *src)
+{
+    string strIndexPath = src->path;
+
+    strIndexPath.replace(strIndexPath.length() - 4, 4, ".oix");
+
+    if (audio_index_load(strIndexPath, src)) {
+        return;
+    }
+
+    struct audio_index_header header;
+    memcpy(header.magic, "OIDX", 4);
+    header.version    = AUDIO_INDEX_VERSION;
+    header.ogg_size   = src->size;
+    header.serial     = audio_index_build(src);
+    header.page_count = (Uint32)src->page_granule.size();
+
+    LOGD << fmt("Indexed %u audio pages, saving to %s", header.page_count,
+                strIndexPath.c_str());
+
+    // it doesn't matter if this fails (read-only filesystem, for example),
+    // we'll just have to index the stream again next time
+    FILE *F = fopen(strIndexPath.c_str(), "wb");
+    if (F) {
+        bool bOK = (fwrite(&header, sizeof(header), 1, F) == 1);
+        if (bOK && header.page_count) {
+            bOK = (fwrite(&src->page_granule[0], sizeof(Sint64), header.page_count, F) ==
+                   header.page_count) &&
+                  (fwrite(&src->page_offset[0], sizeof(Uint32), header.page_count, F) ==
+                   header.page_count);
+        }
+        fclose(F);
+        if (!bOK) {
+            remove(strIndexPath.c_str());
+        }
+    }
+}
+
+// Positions the current stream at sample 'target'.  The page index gets us to the page
+// before the one that the target is on, so only the rest of the way has to be
+// decoded.  If there's no index or it didn't get us close enough, vorbisfile
+// bisects the stream itself.
+// Returns 0 on success, like ov_pcm_seek.
+static int audio_seek(Uint64 target)
+{
+    audio_source *src = g_cur_audio;
+    std::vector<Sint64>::const_iterator it =
+        std::lower_bound(src->page_granule.begin(), src->page_granule.end(), (Sint64)target);
+    size_t page = it - src->page_granule.begin();
+
+    if (page > 0) {
+        --page;
+    }
+
+    if ((page < src->page_offset.size()) &&
+        (ov_raw_seek(&src->ogg, src->page_offset[page]) == 0)) {
+        ogg_int64_t pos = ov_pcm_tell(&src->ogg);
+
+        if ((pos >= 0) && ((Uint64)pos <= target) &&
+            ((target - (Uint64)pos) <= AUDIO_SEEK_MAX_DECODE)) {
+            Uint32 remaining = (Uint32)(target - (Uint64)pos) * sound::BYTES_PER_SAMPLE;
+
+            while (remaining > 0) {
+                int nop;
+                long bytes_read =
+                    ov_read(&src->ogg, g_seek_scratch,
+                            (remaining < AUDIO_BUF_CHUNK) ? remaining : AUDIO_BUF_CHUNK,
+                            0, 2, 1, &nop);
+                if (bytes_read <= 0) break;
+                remaining -= (Uint32)bytes_read;
+            }
+
+            if (remaining == 0) {
+                return 0;
+            }
+        }
+    }
+
+    return ov_pcm_seek(&src->ogg, (ogg_int64_t)target);
+}
+
+// Opens the .ogg at 'strPath' and gets it ready to decode, returns NULL if it
+// can't be used.
+static audio_source *audio_source_load(const string &strPath)
+{
+    ov_callbacks mycallbacks = {mmread, mmseek, mmclose, mmtell};
+    audio_source *src        = NULL;
+    bool result              = false;
+
+    mpo_io *pIO = mpo_open(strPath.c_str(), MPO_OPEN_READONLY);
+    // if audio file couldn't be opened
+    if (!pIO) {
+// don't show this message to end-users, a surprising number of them report this
+// as a bug and it's really getting annoying :)
+        LOGD << "No audio file (" << strPath <<
+            ") was found to go with the opened video file";
+        return NULL;
+    }
+
+    src         = new audio_source();
+    src->path   = strPath;
+    src->size   = static_cast<unsigned int>(pIO->size & 0xFFFFFFFF);
+    src->buf    = NULL;
+    src->pos    = 0;
+    src->mapped = false;
+
+#ifdef TRY_MMAP
+    void *pMap = mmap(NULL, src->size, PROT_READ, MAP_PRIVATE, fileno(pIO->handle), 0);
+    if (pMap != MAP_FAILED) {
+        src->buf    = (Uint8 *)pMap;
+        src->mapped = true;
+    }
+#endif
+    if (!src->buf) {
+        src->buf = new unsigned char[src->size];
+        if (src->buf) {
+            mpo_read(src->buf, src->size, NULL, pIO); // read entire stream into RAM
+        } else {
+            LOGE << "out of memory";
+        }
+    }
+
+    // a mapping doesn't need the file to stay open
+    mpo_close(pIO);
+
+    if (src->buf) {
+        int open_result = ov_open_callbacks(src, &src->ogg, NULL, 0, mycallbacks);
+
+        // if we opening the .OGG succeeded
+        if (open_result == 0) {
+            // now check to make sure it's stereo and the proper sample rate
+            vorbis_info *info = ov_info(&src->ogg, -1);
+
+            // if they meet the proper specification, let them proceed
+            if ((info->channels == 2) && (info->rate == 44100)) {
+                audio_index_open(src);
+                result = true;
+            } else {
+                LOGE << ".ogg file must have 2 channels and 44100 Hz";
+                LOGE << fmt(".ogg file has %u channel(s) and is %ld Hz",
+                            info->channels, info->rate);
+                LOGE << ".ogg file ignored (you won't hear any audio)";
+                ov_clear(&src->ogg); // (frees src->buf)
+            }
+        } else {
+            LOGE << fmt("ov_open_callbacks failed! Error code is %d",
+                        open_result);
+            LOGE << fmt("OV_EREAD=%d OV_ENOTVORBIS=%d OV_EVERSION=%d "
+                        "OV_EBADHEADER=%d OV_EFAULT=%d\n",
+                        OV_EREAD,
+                        OV_ENOTVORBIS,
+                        OV_EVERSION,
+                        OV_EBADHEADER,
+                        OV_EFAULT);
+            mmclose(src);
+        }
+    }
+    // else we've already printed error messages, so we don't need to do
+    // anything else
+
+    if (!result) {
+        delete src;
+        src = NULL;
+    }
+
+    return src;
+}
+
+// closes an audio source for good
+static void audio_source_free(audio_source *src)
+{
+    ov_clear(&src->ogg); // (mmclose frees the stream)
+    delete src;
+}
+
+// Keeps g_audio_ring topped up from the open ogg stream and carries out the
+// seeks that seek_audio() posts.  This does all of the vorbis decoding so
+// that the audio callback only ever has to copy.
+static int ldp_vldp_audio_thread(void *data)
+{
+    OGG_LOCK;
+
+    while (!g_ogg_quit) {
+        Uint32 seek_posted = g_seek_posted.load(std::memory_order_acquire);
+        Uint32 ring_write  = g_ring_write.load(std::memory_order_relaxed);
+        Uint32 ring_free   = AUDIO_RING_SIZE -
+                           (ring_write - g_ring_read.load(std::memory_order_acquire));
+
+        // nothing to decode until open_audio_stream() says otherwise
+        if (!g_audio_ready) {
+            SDL_WaitCondition(g_ogg_cond, g_ogg_mutex);
+        } else if (seek_posted != g_seek_done.load(std::memory_order_relaxed)) {
+            if (audio_seek(g_seek_target) != 0) {
+                LOGW << "Audio seek failed!";
+            }
+            g_audio_eof = false;
+
+            // whatever is in the ring now is from before the seek
+            g_ring_flush_to.store(ring_write, std::memory_order_release);
+            g_seek_done.store(seek_posted, std::memory_order_release);
+
+            Uint32 seek_ms = GET_TICKS() - g_seek_posted_ms;
+            ++g_audio_seeks;
+            g_audio_seek_ms_total += seek_ms;
+            if (seek_ms > g_audio_seek_ms_max) {
+                g_audio_seek_ms_max = seek_ms;
+            }
+        }
+        // the ring is full or there's nothing left to decode, so wait for the
+        // callback to make room or for a seek (seeks don't take the lock so
+        // we may not hear about them, hence the timeout)
+        else if (g_audio_eof || (ring_free < AUDIO_BUF_CHUNK)) {
+            SDL_WaitConditionTimeout(g_ogg_cond, g_ogg_mutex, AUDIO_IDLE_MS);
+        } else {
+            Uint32 offset = ring_write & AUDIO_RING_MASK;
+            Uint32 chunk  = AUDIO_RING_SIZE - offset; // don't go past the end
+            int nop;
+
+            if (chunk > AUDIO_BUF_CHUNK) {
+                chunk = AUDIO_BUF_CHUNK;
+            }
+
+            long samples_read = ov_read(&g_cur_audio->ogg, (char *)g_audio_ring + offset,
+                                        chunk, 0, 2, 1, &nop);
+
+            if (samples_read > 0) {
+                g_ring_write.store(ring_write + (Uint32)samples_read,
+                                   std::memory_order_release);
+            }
+            // if we got an error
+            else if (samples_read < 0) {
+                LOGE << "Problem reading samples!";
+                g_audio_eof = true;
+            }
+            // else, samples_read == 0 in which case we've come to the end
+            // of the stream
+            else {
+                LOGW << "End of audio stream detected!";
+                g_audio_eof = true;
+            }
+
+            // give open_audio_stream() a chance between chunks
+            OGG_UNLOCK;
+            OGG_LOCK;
+        }
+    }
+
+    OGG_UNLOCK;
+
+    return 0;
+}
+
 // initializes VLDP audio, returns 1 on success or 0 on failure
 bool ldp_vldp::audio_init()
 {
@@ -354,10 +778,23 @@ bool ldp_vldp::audio_init()
     g_uCallbackDbgTimer    = GET_TICKS();
 #endif
 
+    g_audio_underruns     = 0;
+    g_audio_late_samples  = 0;
+    g_audio_seeks         = 0;
+    g_audio_seek_ms_total = 0;
+    g_audio_seek_ms_max   = 0;
+
     // create a mutex to prevent threads from interfering
     g_ogg_mutex = SDL_CreateMutex();
-    if (g_ogg_mutex) {
-        result = true;
+    g_ogg_cond  = SDL_CreateCondition();
+    if (g_ogg_mutex && g_ogg_cond) {
+        g_ogg_quit   = false;
+        g_ogg_thread = SDL_CreateThread(ldp_vldp_audio_thread, "vldp audio", NULL);
+        if (g_ogg_thread) {
+            result = true;
+        } else {
+            LOGE << fmt("Could not create audio decoder thread: %s", SDL_GetError());
+        }
     }
 
     return result;
@@ -366,11 +803,33 @@ bool ldp_vldp::audio_init()
 // shuts down VLDP audio
 void ldp_vldp::audio_shutdown()
 {
+    // stop the decoder thread before pulling the stream out from under it
+    if (g_ogg_thread) {
+        OGG_LOCK;
+        g_ogg_quit = true;
+        SDL_SignalCondition(g_ogg_cond);
+        OGG_UNLOCK;
+        SDL_WaitThread(g_ogg_thread, NULL);
+        g_ogg_thread = NULL;
+    }
+
     // if we have an audio file still open, close it
-    if (g_pIOAudioHandle != 0) {
+    if (g_cur_audio != NULL) {
         close_audio_stream();
     }
 
+    for (unsigned int i = 0; i < AUDIO_SOURCE_CACHE; i++) {
+        if (g_audio_sources[i]) {
+            audio_source_free(g_audio_sources[i]);
+            g_audio_sources[i] = NULL;
+        }
+    }
+
+    if (g_ogg_cond) {
+        SDL_DestroyCondition(g_ogg_cond);
+        g_ogg_cond = NULL;
+    }
+
     // if we successfully created a mutex previously, then destroy it now
     if (g_ogg_mutex) {
         SDL_DestroyMutex(g_ogg_mutex);
@@ -378,105 +837,101 @@ void ldp_vldp::audio_shutdown()
     }
 }
 
+unsigned int ldp_vldp::get_audio_underruns()
+{
+    return g_audio_underruns;
+}
+
+Uint64 ldp_vldp::get_audio_late_samples()
+{
+    return g_audio_late_samples;
+}
+
+void ldp_vldp::get_audio_seek_stats(unsigned int &uCount, Uint64 &u64TotalMs,
+                                    Uint32 &uMaxMs)
+{
+    uCount     = g_audio_seeks;
+    u64TotalMs = g_audio_seek_ms_total;
+    uMaxMs     = g_audio_seek_ms_max;
+}
+
+// stops using the current audio stream (it stays open in g_audio_sources in
+// case we come back to it)
 void ldp_vldp::close_audio_stream()
 {
     OGG_LOCK;
 
     g_audio_ready   = false;
     g_audio_playing = false;
-    ov_clear(&s_ogg);
+    g_cur_audio     = NULL;
 
     OGG_UNLOCK;
 }
 
 bool ldp_vldp::open_audio_stream(const string &strFilename)
 {
-    bool result              = false;
-    ov_callbacks mycallbacks = {mmread, mmseek, mmclose, mmtell};
+    bool result       = false;
+    string strPath    = m_mpeg_path + strFilename;
+    audio_source *src = NULL;
+    unsigned int slot = 0;
 
-    OGG_LOCK; // can't have audio callback running during this
+    OGG_LOCK; // can't have the decoder thread running during this
 
     // if an audio stream is already open, close it first
-    if (g_pIOAudioHandle != 0) {
+    if (g_cur_audio != NULL) {
         close_audio_stream();
     }
 
-    mmreset(); // reset the mm wrappers for new use
-
-    g_pIOAudioHandle = mpo_open((m_mpeg_path + strFilename).c_str(), MPO_OPEN_READONLY);
-    // if audio file was opened successfully
-    if (g_pIOAudioHandle) {
-        g_audio_filesize = static_cast<unsigned int>(g_pIOAudioHandle->size & 0xFFFFFFFF);
-#ifdef TRY_MMAP
-        g_big_buf = (Uint8 *)mmap(NULL, g_audio_filesize, PROT_READ, MAP_PRIVATE,
-                                  fileno(g_pIOAudioHandle->handle), 0);
-        if (!g_big_buf) {
-            LOGE << "mmap failed";
+    // we may still have it open from last time
+    for (unsigned int i = 0; i < AUDIO_SOURCE_CACHE; i++) {
+        if (g_audio_sources[i] && (g_audio_sources[i]->path == strPath)) {
+            src = g_audio_sources[i];
+            break;
         }
-#else
-        g_big_buf = new unsigned char[g_audio_filesize];
-        if (g_big_buf) {
-            mpo_read(g_big_buf, g_audio_filesize, NULL,
-                     g_pIOAudioHandle); // read entire stream into RAM
-        } else {
-            LOGE << "out of memory";
+    }
+
+    if (src) {
+        // start from the beginning, as we would if we had just opened it
+        g_cur_audio = src;
+        if (audio_seek(0) != 0) {
+            LOGW << "Audio seek failed!";
         }
-#endif
-        if (g_big_buf) {
-            int open_result = ov_open_callbacks(g_big_buf, &s_ogg, NULL, 0, mycallbacks);
-
-            // if we opening the .OGG succeeded
-            if (open_result == 0) {
-                // now check to make sure it's stereo and the proper sample rate
-                vorbis_info *info = ov_info(&s_ogg, -1);
-
-                // if they meet the proper specification, let them proceed
-                if ((info->channels == 2) && (info->rate == 44100)) {
-                    g_audio_ready = true;
-                    result        = true;
-                } else {
-                    LOGE << ".ogg file must have 2 channels and 44100 Hz";
-                    LOGE << fmt(".ogg file has %u channel(s) and is %ld Hz",
-                                info->channels, info->rate);
-                    LOGE << ".ogg file ignored (you won't hear any audio)";
+    } else {
+        src = audio_source_load(strPath);
+
+        // take an empty slot, or else the one used longest ago
+        if (src) {
+            for (unsigned int i = 0; i < AUDIO_SOURCE_CACHE; i++) {
+                if (!g_audio_sources[i]) {
+                    slot = i;
+                    break;
+                }
+                if (g_audio_sources[i]->last_used < g_audio_sources[slot]->last_used) {
+                    slot = i;
                 }
-            } else {
-                LOGE << fmt("ov_open_callbacks failed! Error code is %d",
-                            open_result);
-                LOGE << fmt("OV_EREAD=%d OV_ENOTVORBIS=%d OV_EVERSION=%d "
-                            "OV_EBADHEADER=%d OV_EFAULT=%d\n",
-                            OV_EREAD,
-                            OV_ENOTVORBIS,
-                            OV_EVERSION,
-                            OV_EBADHEADER,
-                            OV_EFAULT);
             }
-        }
-        // else we've already printed error messages, so we don't need to do
-        // anything else
-
-        // close file if we got an earlier error
-        if (!result) {
-            mpo_close(g_pIOAudioHandle);
-            g_pIOAudioHandle = NULL;
 
-            // if we have memory allocated, de-allocate it
-            if (g_big_buf) {
-#ifdef TRY_MMAP
-                munmap(g_big_buf, g_audio_filesize);
-#else
-                delete[] g_big_buf;
-#endif
-                g_big_buf = NULL;
+            if (g_audio_sources[slot]) {
+                audio_source_free(g_audio_sources[slot]);
             }
+            g_audio_sources[slot] = src;
         }
+    }
 
-    } // end if we could open file
-    else {
-// don't show this message to end-users, a surprising number of them report this
-// as a bug and it's really getting annoying :)
-        LOGD << "No audio file (" << strFilename <<
-            ") was found to go with the opened video file";
+    if (src) {
+        src->last_used = ++g_audio_open_count;
+        g_cur_audio    = src;
+
+        // anything left in the ring is from the old stream, and any seek that
+        // hasn't happened yet was meant for it too
+        g_audio_eof = false;
+        g_ring_flush_to.store(g_ring_write.load(std::memory_order_relaxed),
+                              std::memory_order_release);
+        g_seek_done.store(g_seek_posted.load(), std::memory_order_release);
+
+        g_audio_ready = true;
+        result        = true;
+        SDL_SignalCondition(g_ogg_cond);
     }
 
     OGG_UNLOCK;
@@ -492,18 +947,19 @@ bool ldp_vldp::seek_audio(Uint64 u64Samples)
 
     if (sound::is_enabled()) {
 
-        OGG_LOCK; // can't have audio callback running during this
-
-        if (ov_seekable(&s_ogg)) {
-            ov_pcm_seek(&s_ogg, u64Samples);
+        // the decoder thread does the actual seek, so we don't have to wait
+        // for it
+        if (g_cur_audio && ov_seekable(&g_cur_audio->ogg)) {
             g_audio_playing = false; // audio should not be playing immediately
-                                 // after a seek
+                                     // after a seek
+            g_seek_target    = u64Samples;
+            g_seek_posted_ms = GET_TICKS();
+            g_seek_posted.fetch_add(1, std::memory_order_release);
+            SDL_SignalCondition(g_ogg_cond);
             result = true;
         } else {
             LOGE << "DOH! OGG stream is not seekable!";
         }
-
-        OGG_UNLOCK;
     }
 
     return result;
@@ -512,28 +968,36 @@ bool ldp_vldp::seek_audio(Uint64 u64Samples)
 // starts playing the audio
 void ldp_vldp::audio_play(Uint32 timer)
 {
-    OGG_LOCK;
-    g_playing_timer  = timer;
-    g_samples_played = 0;
-    g_audio_playing  = true;
-    OGG_UNLOCK;
+    g_playing_timer = timer;
+    ++g_play_count; // the callback resets g_samples_played when it sees this
+    g_audio_playing = true;
 }
 
 // pauses the audio at the current position
 void ldp_vldp::audio_pause()
 {
-    OGG_LOCK;
     g_audio_playing = false;
-    OGG_UNLOCK;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
 
-char g_small_buf[AUDIO_BUF_CHUNK]     = {0};
-Uint8 g_leftover_buf[AUDIO_BUF_CHUNK] = {0};
-int g_leftover_samples                = 0;
+// copies 'bytes' from the ring starting at 'ring_pos' (wrapping around the end)
+static void audiocopy_from_ring(Uint8 *dest, Uint32 ring_pos, Uint32 bytes)
+{
+    Uint32 offset = ring_pos & AUDIO_RING_MASK;
+    Uint32 first  = AUDIO_RING_SIZE - offset;
+
+    if (first >= bytes) {
+        paudiocopy(dest, g_audio_ring + offset, bytes);
+    } else {
+        paudiocopy(dest, g_audio_ring + offset, first);
+        paudiocopy(dest + first, g_audio_ring, bytes - first);
+    }
+}
 
 // our audio callback
+// This only copies what the decoder thread has left in g_audio_ring, it never
+// blocks.
 void ldp_vldp_audio_callback(Uint8 *stream, int len, int unused)
 {
 #ifdef AUDIO_DEBUG
@@ -545,139 +1009,98 @@ void ldp_vldp_audio_callback(Uint8 *stream, int len, int unused)
     }
 #endif
 
-    OGG_LOCK; // make sure nothing changes with any ogg stuff while we decode
+    Uint32 ring_read  = g_ring_read.load(std::memory_order_relaxed);
+    bool seek_pending = (g_seek_done.load(std::memory_order_acquire) !=
+                         g_seek_posted.load(std::memory_order_relaxed));
+    Uint32 flush_to   = g_ring_flush_to.load(std::memory_order_acquire);
+    bool eof          = g_audio_eof;
+    Uint32 available  = 0;
+    Uint32 copied     = 0;
+
+    // throw away anything that was decoded before the last seek
+    if ((Sint32)(flush_to - ring_read) > 0) {
+        ring_read = flush_to;
+    }
+    available = g_ring_write.load(std::memory_order_acquire) - ring_read;
 
     // if audio is ready to be read and if it is playing
-    if (g_audio_ready && g_audio_playing) {
-        bool audio_caught_up = false;
-        int loop_count       = 0;
-
-        // normally we only want to go through this loop once
-        // The exception is if we are behind, in which case we want to process
-        // audio until we're caught up again
-        // we don't want to loop endlessly in here if there is a bug, which is
-        // why we have a loop count
-        while ((!audio_caught_up) && (loop_count++ < 10)) {
-            long samples_read      = 0;
-            int samples_copied     = 0;
-            Uint32 bytes_to_read   = 0;
-            Uint32 correct_samples = 0; // how many samples we should have
-                                        // played up to this point
-            int nop;
-
-            // if we have some samples from last time for the audio stream
-            if (g_leftover_samples) {
-                if (g_leftover_samples <= len) {
-                    paudiocopy(stream, g_leftover_buf, g_leftover_samples);
-                    samples_copied += g_leftover_samples;
-                    g_leftover_samples = 0;
-                } else {
-                    paudiocopy(stream, g_leftover_buf, len);
-                    memmove(g_leftover_buf, g_leftover_buf + len,
-                            g_leftover_samples - len); // shift remaining buf to
-                                                       // front
-                    // memmove is used because the memory area overlaps
-                    samples_copied = len;
-                    g_leftover_samples -= len;
-                }
-            }
-
-            while (samples_copied < len) {
-                samples_read =
-                    ov_read(&s_ogg, &g_small_buf[0], AUDIO_BUF_CHUNK, 0, 2, 1, &nop);
-
-                if (samples_read > 0) {
-                    bytes_to_read = len - samples_copied; // how much space we
-                                                          // have left to fill
-                    // (samples_copied can and often is 0)
-
-                    // if we have more space to fill than samples available,
-                    // then we only want to read
-                    // as many samples as we have available
-                    if (bytes_to_read > (Uint32)samples_read) {
-                        bytes_to_read = samples_read;
-                    }
-                    // else we have to split the buffer
-                    else {
-                        g_leftover_samples = samples_read - bytes_to_read;
-                        memcpy(g_leftover_buf, g_small_buf + bytes_to_read, g_leftover_samples);
-                    }
-
-                    paudiocopy(stream + samples_copied, g_small_buf, bytes_to_read);
-                    samples_copied += bytes_to_read;
-                } // end if samples were read
-
-                // if we got an error
-                else if (samples_read < 0) {
-                    LOGE << "Problem reading samples!";
-                    g_audio_playing = false;
-                    break;
-                }
-
-                // else, samples_read == 0 in which case we've come to the end
-                // of the stream
-                else {
-                    LOGW << "End of audio stream detected!";
-                    g_audio_playing = false;
-                    break;
-                }
-
-            } // end while we have not filled the buffer
-
-            // NOW WE CHECK TO SEE IF THE AUDIO IS LAGGING TOO FAR BEHIND
-            // IF IT IS, WE NEED TO SKIP FORWARD
-
-            g_samples_played += len; // update stats on how many samples have
-                                     // played so we can make sure audio is in
-                                     // sync
-
-            // unsigned int cur_time = refresh_ms_time();
-            unsigned int cur_time = g_ldp->get_elapsed_ms_since_play();
-            // if our timer is set to the current time or some previous time
-            if (g_playing_timer < cur_time) {
-                // needs to be uint64 to prevent overflow from subsequent math
-                static const Uint64 uBYTES_PER_S = sound::FREQ * sound::BYTES_PER_SAMPLE;
-                // how many samples should have played 176.4 = 44.1 samples per
-                // millisecond * 2 for stereo * 2 for 16-bit
-                correct_samples =
-                    (unsigned int)((uBYTES_PER_S * (cur_time - g_playing_timer)) / 1000);
-            }
-            // our timer is set to some time in the future (used with skipping)
-            // so we actually should not have played any samples at this point
-            else {
-                // fprintf(stderr, "LDP-VLDP-AUDIO : Timer is in the future\n");
-                correct_samples = 0;
-            }
+    if (g_audio_ready && g_audio_playing && !seek_pending) {
+        Uint32 bytes_wanted    = (Uint32)len;
+        Uint32 correct_samples = 0; // how many samples we should have
+                                    // played up to this point
+        Uint32 play_count      = g_play_count;
+
+        // audio_play() has been called since last time, so start timing again
+        if (play_count != g_play_count_seen) {
+            g_play_count_seen = play_count;
+            g_samples_played  = 0;
+        }
 
-            // if we're ahead instead of behind, don't loop
-            if (correct_samples <= g_samples_played) {
-                audio_caught_up = true;
+        // unsigned int cur_time = refresh_ms_time();
+        unsigned int cur_time = g_ldp->get_elapsed_ms_since_play();
+        Uint32 playing_timer  = g_playing_timer;
+        // if our timer is set to the current time or some previous time
+        if (playing_timer < cur_time) {
+            // needs to be uint64 to prevent overflow from subsequent math
+            static const Uint64 uBYTES_PER_S = sound::FREQ * sound::BYTES_PER_SAMPLE;
+            // how many samples should have played 176.4 = 44.1 samples per
+            // millisecond * 2 for stereo * 2 for 16-bit
+            correct_samples =
+                (unsigned int)((uBYTES_PER_S * (cur_time - playing_timer)) / 1000);
+        }
+        // else our timer is set to some time in the future (used with
+        // skipping) so we actually should not have played any samples at this
+        // point
+
+        // IF THE AUDIO IS LAGGING A WHOLE BUFFER OR MORE BEHIND (counting this
+        // one), WE NEED TO SKIP FORWARD
+        if ((Sint32)(correct_samples - g_samples_played - bytes_wanted) >= (Sint32)bytes_wanted) {
+            Uint32 skip  = ((correct_samples - g_samples_played - bytes_wanted) /
+                           bytes_wanted) * bytes_wanted;
+            Uint32 spare = (available > bytes_wanted) ? (available - bytes_wanted) : 0;
+
+            if (skip > spare) {
+                skip = spare;
             }
+            skip -= skip % sound::BYTES_PER_SAMPLE;
+
+            LOGD << fmt("played %u, expected %u, timer=%u, curtime=%u",
+                        g_samples_played,
+                        correct_samples,
+                        playing_timer,
+                        cur_time);
+
+            ring_read += skip;
+            available -= skip;
+            g_samples_played += skip;
+            g_audio_late_samples += skip / sound::BYTES_PER_SAMPLE;
+        }
 
-            // if we're not too far behind, don't loop
-            else if ((Sint32)(correct_samples - g_samples_played) < len) {
-                audio_caught_up = true;
-            }
+        copied = (available < bytes_wanted) ? available : bytes_wanted;
+        audiocopy_from_ring(stream, ring_read, copied);
+        ring_read += copied;
+        g_samples_played += copied; // update stats on how many samples have
+                                    // played so we can make sure audio is in
+                                    // sync
 
-            // if we're too far behind, notify the user for testing purposes
-            else {
-                LOGD << fmt("played %u, expected %u, timer=%u, curtime=%u",
-                            g_samples_played,
-                            correct_samples,
-                            g_playing_timer,
-                            g_ldp->get_elapsed_ms_since_play());
-                audio_caught_up = false;
-                SDL_Delay(0); // don't starve other processes while trying to
-                              // catch up
+        // the decoder thread couldn't keep up (or there's no more audio)
+        if (copied < bytes_wanted) {
+#ifdef WIN32
+            ZeroMemory(stream + copied, bytes_wanted - copied);
+#else
+            bzero(stream + copied, bytes_wanted - copied);
+#endif
+            if (eof) {
+                g_audio_playing = false;
+            } else {
+                ++g_audio_underruns;
             }
-        } // end while we're not caught up
-
+        }
     } // end if audio is playing
 
     // Either we have no audio file opened OR
-    // disc is not playing, pause audio and make sure we don't have any
-    // extraneous audio lingering around when
-    // we start playing again
+    // disc is not playing (or the seek we've been told about hasn't happened
+    // yet)
     else {
 // fill audio stream with silence since it will be expecting to get something
 // back from us
@@ -687,8 +1110,10 @@ void ldp_vldp_audio_callback(Uint8 *stream, int len, int unused)
         bzero(stream, len);
 #endif
 
-        g_leftover_samples = 0;
+        if (g_audio_ready && g_audio_playing) {
+            ++g_audio_underruns;
+        }
     }
 
-    OGG_UNLOCK;
+    g_ring_read.store(ring_read, std::memory_order_release);
 }
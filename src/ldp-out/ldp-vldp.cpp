@@ -48,6 +48,7 @@
 #include "ldp-vldp.h"
 #include <plog/Log.h>
 #include <set>
+#include <vector>
 #include <stdlib.h>
 #include <time.h>
 
@@ -117,6 +118,12 @@ ldp_vldp::ldp_vldp()
     m_blank_on_skips     = false;
     m_seek_frames_per_ms = 0;
     m_min_seek_delay     = 0;
+    m_uFrameCacheMB      = 32;
+    m_bTimingSearch      = false;
+    m_uSearchStartMs     = 0;
+    m_uSearchCount       = 0;
+    m_u64SearchMsTotal   = 0;
+    m_uSearchMsMax       = 0;
 
     m_testing = false; // don't run tests by default
 
@@ -151,6 +158,7 @@ bool ldp_vldp::init_player()
 
             if (audio_init() && !get_quitflag()) {
                 g_local_info.prepare_frame         = prepare_frame_callback;
+                g_local_info.prepare_held_frame    = prepare_held_frame_callback;
                 g_local_info.display_frame         = display_frame_callback;
                 g_local_info.report_parse_progress = report_parse_progress_callback;
                 g_local_info.report_mpeg_dimensions = report_mpeg_dimensions_callback;
@@ -159,6 +167,7 @@ bool ldp_vldp::init_player()
                 g_local_info.blank_during_skips    = m_blank_on_skips;
                 g_local_info.GetTicksFunc          = GetTicksFunc;
                 g_local_info.Uid                   = get_id();
+                g_local_info.uFrameCacheMB         = m_uFrameCacheMB;
 
                 g_vldp_info = vldp_init(&g_local_info);
 
@@ -191,6 +200,11 @@ bool ldp_vldp::init_player()
                         bPreCacheOK = precache_all_video();
                     }
 
+                    // load the frame indexes of every file that has
+                    // already been parsed, so segment switches don't touch
+                    // the .DAT files again
+                    load_all_indexes();
+
                     // if we need to parse all the video
                     if (need_to_parse) {
                         parse_all_video();
@@ -282,11 +296,41 @@ void ldp_vldp::shutdown_player()
 {
     // if VLDP has been loaded
     if (g_vldp_info) {
+        if (m_uFrameCacheMB > 0) {
+            LOGI << fmt("VLDP frame cache: %u hits, %u misses",
+                        g_vldp_info->uFrameCacheHits, g_vldp_info->uFrameCacheMisses);
+        }
+        if (m_uSearchCount > 0) {
+            unsigned int uAudioSeeks = 0;
+            Uint64 u64AudioMsTotal   = 0;
+            Uint32 uAudioMsMax       = 0;
+
+            get_audio_seek_stats(uAudioSeeks, u64AudioMsTotal, uAudioMsMax);
+            LOGI << fmt("VLDP search latency: video %u ms avg (%u max) over %u "
+                        "searches, audio %u ms avg (%u max) over %u seeks",
+                        (unsigned int)(m_u64SearchMsTotal / m_uSearchCount),
+                        m_uSearchMsMax, m_uSearchCount,
+                        uAudioSeeks ? (unsigned int)(u64AudioMsTotal / uAudioSeeks) : 0,
+                        uAudioMsMax, uAudioSeeks);
+        }
         g_vldp_info->shutdown();
         g_vldp_info = NULL;
     }
 
+    {
+        uint32_t uPublished = 0, uDropped = 0, uRepeated = 0;
+
+        video::get_yuv_mailbox_stats(uPublished, uDropped, uRepeated);
+        if (uPublished > 0) {
+            LOGI << fmt("VLDP video: %u frames, %u dropped before display, "
+                        "%u blits repeated a frame", uPublished, uDropped, uRepeated);
+        }
+    }
+
     if (sound::is_enabled()) {
+        LOGI << fmt("VLDP audio: %u underruns, %llu late samples",
+                    get_audio_underruns(),
+                    (unsigned long long)get_audio_late_samples());
         if (!sound::delete_chip(m_uSoundChipID)) {
             LOGW << "sound chip could not be deleted";
         }
@@ -379,6 +423,9 @@ bool ldp_vldp::nonblocking_search(char *frame)
 
     audio_pause(); // pause the audio before we seek so we don't have overrun
 
+    m_bTimingSearch  = true;
+    m_uSearchStartMs = GET_TICKS();
+
     // do we need to compute seek_delay_ms?
     // (This is best done sooner than later so get_current_frame() is more
     // accurate
@@ -498,6 +545,14 @@ int ldp_vldp::get_search_result()
     // if search is finished and has succeeded
     if (g_vldp_info->status == STAT_PAUSED) {
         result = SEARCH_SUCCESS;
+
+        if (m_bTimingSearch) {
+            Uint32 uSearchMs = GET_TICKS() - m_uSearchStartMs;
+            m_bTimingSearch  = false;
+            ++m_uSearchCount;
+            m_u64SearchMsTotal += uSearchMs;
+            if (uSearchMs > m_uSearchMsMax) m_uSearchMsMax = uSearchMs;
+        }
     }
 
     // if the search failed
@@ -756,6 +811,11 @@ unsigned int ldp_vldp::get_min_seek_delay()
     return m_min_seek_delay;
 }
 
+void ldp_vldp::set_frame_cache_mb(unsigned int value)
+{
+    m_uFrameCacheMB = value;
+}
+
 // sets the name of the frame file
 void ldp_vldp::set_framefile(const char *filename)
 {
@@ -1108,6 +1168,31 @@ bool ldp_vldp::last_video_file_parsed()
     return result;
 }
 
+// loads the frame indexes of all video files up front, in parallel
+void ldp_vldp::load_all_indexes()
+{
+    vector<string> vPaths;
+    vector<const char *> vNames;
+    set<string> sDupePreventer;
+    unsigned int i = 0;
+
+    for (i = 0; i < m_file_index; i++) {
+        if (sDupePreventer.insert(m_mpeginfo[i].name).second) {
+            vPaths.push_back(m_mpeg_path + m_mpeginfo[i].name);
+        }
+    }
+
+    for (i = 0; i < vPaths.size(); i++) {
+        vNames.push_back(vPaths[i].c_str());
+    }
+
+    if (!vNames.empty()) {
+        unsigned int uLoaded = g_vldp_info->load_indexes(&vNames[0], (unsigned int)vNames.size());
+        LOGI << fmt("Loaded %u of %u video frame indexes", uLoaded,
+                    (unsigned int)vNames.size());
+    }
+}
+
 // opens (and closes) all video files, forcing any unparsed video files to get
 // parsed
 void ldp_vldp::parse_all_video()
@@ -1462,6 +1547,24 @@ int prepare_frame_callback(uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane,
     return result;
 }
 
+// like prepare_frame_callback, but the planes can go to the YUV texture in
+// place, and are given back to VLDP once they have
+int prepare_held_frame_callback(uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane,
+                                int Ypitch, int Upitch, int Vpitch, void *ref)
+{
+    int result = (video::vid_hold_yuv_overlay(Yplane, Uplane, Vplane, Ypitch, Upitch,
+                                              Vpitch, ref, g_vldp_info->release_frame) == 0)
+                 ? VLDP_TRUE
+                 : VLDP_FALSE;
+
+    if (g_take_screenshot) {
+        g_take_screenshot = false;
+        video::set_queue_screenshot(true);
+    }
+
+    return result;
+}
+
 // displays the frame as fast as possible
 void display_frame_callback()
 {
@@ -1511,7 +1614,6 @@ void update_parse_meter(const string &strFilename)
 	//
         if (remaining_s > 0) {
             SDL_Renderer *renderer = video::get_renderer();
-            TTF_TextEngine *engine = video::get_font_engine();
             TTF_Font *font = video::get_font();
             int h = video::get_logical_height();
             int w = video::get_logical_width();
@@ -1525,11 +1627,11 @@ void update_parse_meter(const string &strFilename)
                      "Video parsing is %02.f percent complete, %02.f seconds remaining.",
                      percent_complete, remaining_s);
 
-            auto draw_centered_text = [&](const char *text, int y)
+            auto draw_centered_text = [&](int slot, const char *text, int y)
             {
                 SDL_Color color = {255, 255, 255, 255};
 
-                TTF_Text *tt = TTF_CreateText(engine, font, text, strlen(text));
+                TTF_Text *tt = video::get_text(slot, font, text);
                 if (!tt) return;
 
                 TTF_SetTextColor(tt, color.r, color.g, color.b, color.a);
@@ -1542,12 +1644,10 @@ void update_parse_meter(const string &strFilename)
                 dst.y = (float)y;
 
                 TTF_DrawRendererText(tt, dst.x, dst.y);
-
-                TTF_DestroyText(tt);
             };
 
-            draw_centered_text(f, (h * 50) / 100);
-            draw_centered_text(s, (h * 55) / 100);
+            draw_centered_text(video::TEXT_PARSE_FILE, f, (h * 50) / 100);
+            draw_centered_text(video::TEXT_PARSE_STATUS, s, (h * 55) / 100);
 
             SDL_RenderPresent(renderer);
         }
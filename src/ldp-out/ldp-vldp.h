@@ -74,6 +74,7 @@ class ldp_vldp : public ldp
     void set_skip_blanking(bool);
     void set_seek_frames_per_ms(double value);
     void set_min_seek_delay(unsigned int);
+    void set_frame_cache_mb(unsigned int);
     void set_framefile(const char *filename);
     void set_altaudio(const char *audio_suffix);
 
@@ -114,6 +115,9 @@ class ldp_vldp : public ldp
     bool last_video_file_parsed();
     void parse_all_video();
 
+    // loads the frame index of every video file that has been parsed
+    void load_all_indexes();
+
     // Attempts to precache all video, returns false if there isn't enough RAM
     // and we aren't overriding the safety check
     bool precache_all_video();
@@ -152,6 +156,13 @@ class ldp_vldp : public ldp
                                      // millisecond (0 = no limit)
     unsigned int m_min_seek_delay;   // min # of milliseconds to force seek to
                                      // last
+    unsigned int m_uFrameCacheMB;    // memory budget for VLDP's decoded search
+                                     // frame cache (0 = disabled)
+    bool m_bTimingSearch;            // whether a search is being timed
+    Uint32 m_uSearchStartMs;         // when the search being timed began
+    unsigned int m_uSearchCount;     // how many searches have been timed
+    Uint64 m_u64SearchMsTotal;       // total time those searches took
+    Uint32 m_uSearchMsMax;           // longest time a search took
     bool m_testing;   // should we do a few simple tests to make sure VLDP is
                       // functioning robustly?
     bool m_bPreCache; // should we precache all video?
@@ -173,6 +184,10 @@ class ldp_vldp : public ldp
     void disable_audio1();
     void disable_audio2();
     bool switch_altaudio(const char *);
+    unsigned int get_audio_underruns();  // times the audio callback ran dry
+    Uint64 get_audio_late_samples();     // samples skipped to keep up with video
+    void get_audio_seek_stats(unsigned int &uCount, Uint64 &u64TotalMs,
+                              Uint32 &uMaxMs);
 
   private:
     void set_audiocopy_callback();
@@ -190,6 +205,8 @@ class ldp_vldp : public ldp
 // function pointers
 int prepare_frame_callback(uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane,
                            int Ypitch, int Upitch, int Vpitch);
+int prepare_held_frame_callback(uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane,
+                                int Ypitch, int Upitch, int Vpitch, void *ref);
 void display_frame_callback();
 void set_blend_fields(bool val);
 void update_parse_meter(const string &strFilename);
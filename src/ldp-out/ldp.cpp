@@ -997,6 +997,13 @@ unsigned int ldp::get_min_seek_delay()
     return 0;
 }
 
+void ldp::set_frame_cache_mb(unsigned int value)
+{
+    if (m_bVerbose) {
+        LOGI << "Frame caching is not supported with this laserdisc player!";
+    }
+}
+
 // causes sram to be saved after every seek
 void ldp::set_sram_continuous_update(bool value)
 {
@@ -210,6 +210,7 @@ class ldp
     virtual void set_seek_frames_per_ms(double value);
     virtual void set_min_seek_delay(unsigned int value);
     virtual unsigned int get_min_seek_delay();
+    virtual void set_frame_cache_mb(unsigned int value);
 
     // END LDP-SPECIFIC SECTION
 
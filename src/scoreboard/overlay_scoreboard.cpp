@@ -78,6 +78,7 @@ bool OverlayScoreboard::RepaintIfNeeded()
 		else
 		{
 			SDL_FillSurfaceRect(pSurface, NULL, 0x00000000);
+			video::set_overlay_dirty(NULL);
 		}
 
 		bRepainted = true;
@@ -39,6 +39,7 @@
 #include "../io/mpo_mem.h"
 #include "../io/numstr.h"
 #include "../ldp-out/ldp-vldp.h" // added by JFA for -startsilent
+#include "../video/capture.h"
 #include "dac.h"
 #include "gisound.h"
 #include "mix.h"
@@ -604,6 +605,8 @@ void SDLCALL StreamAudio(void *userdata, SDL_AudioStream *stream, int additional
 
     g_soundmix_callback(mix.data(), buf);
 
+    capture::audio(mix.data(), buf);
+
     if (!SDL_PutAudioStreamData(stream, mix.data(), buf))
     {
         LOGE << fmt("SDL_PutAudioStreamData failed: %s", SDL_GetError());
@@ -0,0 +1,442 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 DirtBagXon
+ *
+ * This file is part of HYPSEUS, a laserdisc arcade game emulator
+ *
+ * HYPSEUS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "config.h"
+
+#include "../game/game.h"
+#include "../io/conout.h"
+#include "../sound/sound.h"
+#include "capture.h"
+#include <plog/Log.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+namespace capture
+{
+
+// about three seconds of sound
+#define AUDIO_RING (1 << 19)
+
+struct frame_slot {
+    uint8_t *yuv;      // Y, then U, then V
+    uint8_t *overlay;  // RGBA copy of the shown part of the overlay
+    int ow, oh;        // size of that copy, 0 when there is none
+    int repeat;        // how many times the frame is written
+};
+
+std::string g_target;
+bool g_overlay                 = false;
+
+SDL_Thread *g_thread           = NULL;
+SDL_Mutex *g_mutex             = NULL;
+SDL_Condition *g_cond          = NULL;
+bool g_quit                    = false;
+std::atomic<bool> g_running(false);
+
+FILE *g_video                  = NULL;
+FILE *g_wav                    = NULL;
+bool g_piped                   = false;
+
+int g_width = 0, g_height = 0;
+int g_overlay_w = 0, g_overlay_h = 0;  // overlay copy buffers' capacity
+unsigned int g_fpks            = 0;
+Uint64 g_start_ns              = 0;
+uint64_t g_frames_due          = 0;
+
+// single producer (main thread), single consumer (writer) queues
+frame_slot g_slots[QUEUE_FRAMES];
+std::atomic<uint32_t> g_frame_head(0), g_frame_tail(0);
+
+std::vector<uint8_t> g_audio_ring;
+std::atomic<uint32_t> g_audio_head(0), g_audio_tail(0);
+
+// statistics
+uint64_t g_frames_written      = 0;
+uint32_t g_frames_dropped      = 0;
+std::atomic<uint32_t> g_audio_dropped(0);
+uint64_t g_audio_written       = 0;
+
+void set_target(const char *name) { g_target = name; }
+void set_overlay(bool value) { g_overlay = value; }
+bool is_armed() { return !g_target.empty(); }
+bool get_overlay() { return g_overlay; }
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8);
+}
+
+// 'data' is the number of sample bytes that follow
+static void write_wav_header(uint32_t data)
+{
+    uint8_t h[44];
+    uint32_t rate = sound::FREQ;
+
+    memcpy(h, "RIFF", 4);
+    put_le32(h + 4, 36 + data);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put_le32(h + 16, 16);
+    put_le16(h + 20, 1);                       // PCM
+    put_le16(h + 22, sound::CHANNELS);
+    put_le32(h + 24, rate);
+    put_le32(h + 28, rate * sound::BYTES_PER_SAMPLE);
+    put_le16(h + 32, sound::BYTES_PER_SAMPLE);
+    put_le16(h + 34, 16);
+    memcpy(h + 36, "data", 4);
+    put_le32(h + 40, data);
+
+    fseek(g_wav, 0, SEEK_SET);
+    fwrite(h, 1, sizeof(h), g_wav);
+}
+
+// blends the overlay copy over the frame, stretched over all of it the way
+// vid_blit() draws it (BT.601 limited range, like the mpeg video)
+static void blend_overlay(uint8_t *yuv, const frame_slot &f)
+{
+    uint8_t *Yp = yuv;
+    uint8_t *Up = yuv + (g_width * g_height);
+    uint8_t *Vp = Up + ((g_width * g_height) >> 2);
+
+    for (int y = 0; y < g_height; y++) {
+        const uint8_t *row = f.overlay + ((size_t)((y * f.oh) / g_height) * f.ow * 4);
+
+        for (int x = 0; x < g_width; x++) {
+            const uint8_t *p = row + (((x * f.ow) / g_width) * 4);
+            int a = p[3];
+
+            if (!a) continue;
+
+            int r = p[0], g = p[1], b = p[2];
+            int yo = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+            uint8_t *yd = Yp + (y * g_width) + x;
+
+            *yd = (uint8_t)((*yd * (255 - a) + yo * a) / 255);
+
+            if (!(x & 1) && !(y & 1)) {
+                int uo = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+                int vo = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+                int ci = ((y >> 1) * (g_width >> 1)) + (x >> 1);
+
+                Up[ci] = (uint8_t)((Up[ci] * (255 - a) + uo * a) / 255);
+                Vp[ci] = (uint8_t)((Vp[ci] * (255 - a) + vo * a) / 255);
+            }
+        }
+    }
+}
+
+static void drain_audio()
+{
+    uint32_t head = g_audio_head.load(std::memory_order_relaxed);
+    uint32_t tail = g_audio_tail.load(std::memory_order_acquire);
+
+    while (head != tail) {
+        uint32_t at = head % AUDIO_RING;
+        uint32_t n  = tail - head;
+
+        if (n > AUDIO_RING - at) n = AUDIO_RING - at;
+
+        if (g_wav) fwrite(&g_audio_ring[at], 1, n, g_wav);
+        g_audio_written += n;
+        head += n;
+    }
+
+    g_audio_head.store(head, std::memory_order_release);
+}
+
+static bool drain_frames()
+{
+    uint32_t head = g_frame_head.load(std::memory_order_relaxed);
+    uint32_t tail = g_frame_tail.load(std::memory_order_acquire);
+    size_t size   = (size_t)g_width * g_height * 3 / 2;
+
+    if (head == tail) return false;
+
+    for (; head != tail; head++) {
+        frame_slot &f = g_slots[head % QUEUE_FRAMES];
+
+        if (f.ow) blend_overlay(f.yuv, f);
+
+        for (int i = 0; i < f.repeat; i++) {
+            fputs("FRAME\n", g_video);
+            fwrite(f.yuv, 1, size, g_video);
+        }
+        g_frames_written += f.repeat;
+
+        g_frame_head.store(head + 1, std::memory_order_release);
+    }
+
+    return true;
+}
+
+static int writer_thread(void *)
+{
+    SDL_LockMutex(g_mutex);
+
+    while (!g_quit) {
+        SDL_UnlockMutex(g_mutex);
+
+        bool busy = drain_frames();
+        drain_audio();
+
+        SDL_LockMutex(g_mutex);
+
+        if (!busy && !g_quit) SDL_WaitConditionTimeout(g_cond, g_mutex, 20);
+    }
+
+    SDL_UnlockMutex(g_mutex);
+
+    // whatever made it into the queues before stop()
+    drain_frames();
+    drain_audio();
+
+    return 0;
+}
+
+static bool start(int width, int height, SDL_Surface *overlay)
+{
+    std::string wavname;
+
+    g_width  = width;
+    g_height = height;
+    g_fpks   = g_game->get_disc_fpks();
+
+    if (!g_fpks) g_fpks = 29970;
+
+    if (g_target[0] == '|') {
+        g_video  = popen(g_target.c_str() + 1, "w");
+        g_piped  = true;
+        wavname  = "capture.wav";
+    } else {
+        g_video  = fopen((g_target + ".y4m").c_str(), "wb");
+        g_piped  = false;
+        wavname  = g_target + ".wav";
+    }
+
+    if (!g_video) {
+        LOGE << fmt("Could not open capture output: %s", g_target.c_str());
+        g_target.clear();
+        return false;
+    }
+
+    g_wav = fopen(wavname.c_str(), "wb");
+
+    if (!g_wav) LOGW << fmt("Could not open %s, sound is not captured", wavname.c_str());
+    else write_wav_header(0);
+
+    fprintf(g_video, "YUV4MPEG2 W%d H%d F%u:1000 Ip A1:1 C420mpeg2\n",
+            g_width, g_height, g_fpks);
+
+    size_t size = (size_t)g_width * g_height * 3 / 2;
+
+    if (g_overlay && overlay) {
+        g_overlay_w = overlay->w;
+        g_overlay_h = overlay->h;
+    }
+
+    for (int i = 0; i < QUEUE_FRAMES; i++) {
+        g_slots[i].yuv = (uint8_t *)malloc(size);
+        g_slots[i].overlay = g_overlay_w ?
+            (uint8_t *)malloc((size_t)g_overlay_w * g_overlay_h * 4) : NULL;
+    }
+
+    if (g_audio_ring.empty()) g_audio_ring.resize(AUDIO_RING);
+
+    g_mutex = SDL_CreateMutex();
+    g_cond  = SDL_CreateCondition();
+    g_quit  = false;
+
+    if (g_mutex && g_cond)
+        g_thread = SDL_CreateThread(writer_thread, "capture", NULL);
+
+    if (!g_thread) {
+        LOGE << fmt("Could not create capture thread: %s", SDL_GetError());
+        stop();
+        g_target.clear();
+        return false;
+    }
+
+    g_start_ns   = SDL_GetTicksNS();
+    g_frames_due = 0;
+    g_audio_head = g_audio_tail.load();
+    g_running    = true;
+
+    LOGI << fmt("Capturing %dx%d at %u.%03u fps to %s", g_width, g_height,
+                g_fpks / 1000, g_fpks % 1000, g_target.c_str());
+
+    return true;
+}
+
+void video_frame(const uint8_t *Y, const uint8_t *U, const uint8_t *V,
+                 int Ypitch, int Upitch, int Vpitch, int width, int height,
+                 SDL_Surface *overlay, const SDL_Rect *overlay_rect)
+{
+    if (!g_running && (g_thread || !start(width, height, overlay))) return;
+
+    // the stream runs at the disc rate however often we get called, frames
+    // are repeated or skipped to keep it in step with the sound
+    uint64_t due = ((SDL_GetTicksNS() - g_start_ns) / 1000000ULL) * g_fpks / 1000000ULL + 1;
+
+    if (due <= g_frames_due) return;
+
+    int repeat = (int)(due - g_frames_due);
+    g_frames_due = due;
+
+    uint32_t tail = g_frame_tail.load(std::memory_order_relaxed);
+
+    if (width != g_width || height != g_height ||
+            tail - g_frame_head.load(std::memory_order_acquire) >= QUEUE_FRAMES) {
+        g_frames_dropped += repeat;
+        return;
+    }
+
+    frame_slot &f = g_slots[tail % QUEUE_FRAMES];
+    uint8_t *d = f.yuv;
+
+    if (Y) {
+        for (int y = 0; y < height; y++, d += width)
+            memcpy(d, Y + (y * Ypitch), width);
+        for (int y = 0; y < (height >> 1); y++, d += (width >> 1))
+            memcpy(d, U + (y * Upitch), width >> 1);
+        for (int y = 0; y < (height >> 1); y++, d += (width >> 1))
+            memcpy(d, V + (y * Vpitch), width >> 1);
+    } else {
+        memset(d, 16, (size_t)width * height);
+        memset(d + (width * height), 128, (size_t)width * height / 2);
+    }
+
+    f.ow = f.oh = 0;
+
+    if (f.overlay && overlay && overlay_rect && overlay_rect->w > 0 &&
+            overlay_rect->h > 0 && overlay_rect->w <= g_overlay_w &&
+            overlay_rect->h <= g_overlay_h &&
+            overlay_rect->x + overlay_rect->w <= overlay->w &&
+            overlay_rect->y + overlay_rect->h <= overlay->h &&
+            SDL_BYTESPERPIXEL(overlay->format) == 4) {
+        const uint8_t *s = (const uint8_t *)overlay->pixels +
+                               (overlay_rect->y * overlay->pitch) + (overlay_rect->x * 4);
+
+        for (int y = 0; y < overlay_rect->h; y++)
+            memcpy(f.overlay + ((size_t)y * overlay_rect->w * 4),
+                   s + (y * overlay->pitch), (size_t)overlay_rect->w * 4);
+
+        f.ow = overlay_rect->w;
+        f.oh = overlay_rect->h;
+    }
+
+    f.repeat = repeat;
+
+    g_frame_tail.store(tail + 1, std::memory_order_release);
+    SDL_SignalCondition(g_cond);
+}
+
+void audio(const uint8_t *pcm, int bytes)
+{
+    if (!g_running.load(std::memory_order_acquire)) return;
+
+    uint32_t tail = g_audio_tail.load(std::memory_order_relaxed);
+    uint32_t used = tail - g_audio_head.load(std::memory_order_acquire);
+
+    if ((uint32_t)bytes > AUDIO_RING - used) {
+        g_audio_dropped += bytes;
+        return;
+    }
+
+    uint32_t at = tail % AUDIO_RING;
+    uint32_t n  = (uint32_t)bytes;
+
+    if (n > AUDIO_RING - at) n = AUDIO_RING - at;
+
+    memcpy(&g_audio_ring[at], pcm, n);
+    memcpy(&g_audio_ring[0], pcm + n, bytes - n);
+
+    g_audio_tail.store(tail + bytes, std::memory_order_release);
+}
+
+void stop()
+{
+    bool was_running = g_running;
+
+    g_running = false;
+
+    if (g_thread) {
+        SDL_LockMutex(g_mutex);
+        g_quit = true;
+        SDL_SignalCondition(g_cond);
+        SDL_UnlockMutex(g_mutex);
+
+        SDL_WaitThread(g_thread, NULL);
+        g_thread = NULL;
+    }
+
+    if (g_cond) {
+        SDL_DestroyCondition(g_cond);
+        g_cond = NULL;
+    }
+
+    if (g_mutex) {
+        SDL_DestroyMutex(g_mutex);
+        g_mutex = NULL;
+    }
+
+    if (g_video) {
+        if (g_piped) pclose(g_video);
+        else fclose(g_video);
+        g_video = NULL;
+    }
+
+    if (g_wav) {
+        write_wav_header((uint32_t)g_audio_written);
+        fclose(g_wav);
+        g_wav = NULL;
+    }
+
+    for (int i = 0; i < QUEUE_FRAMES; i++) {
+        free(g_slots[i].yuv);
+        free(g_slots[i].overlay);
+        g_slots[i].yuv = g_slots[i].overlay = NULL;
+    }
+
+    if (was_running) {
+        LOGI << fmt("Capture: %llu frames written, %u dropped, %u sound bytes dropped",
+                    (unsigned long long)g_frames_written, g_frames_dropped,
+                    g_audio_dropped.load());
+    }
+
+    g_target.clear();
+}
+
+}
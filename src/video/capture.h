@@ -0,0 +1,63 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 DirtBagXon
+ *
+ * This file is part of HYPSEUS, a laserdisc arcade game emulator
+ *
+ * HYPSEUS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Records what is on screen to a Y4M file (or pipe) and the mixed sound to a
+// WAV file.  The game threads only copy into preallocated buffers, a writer
+// thread does the file I/O; anything that doesn't fit is dropped and counted.
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <SDL3/SDL.h>
+#include <stdint.h>
+
+namespace capture
+{
+// how many frames may be waiting for the writer
+static const int QUEUE_FRAMES = 8;
+
+// Arms the capture: <name>.y4m and <name>.wav are written, or if name starts
+// with '|' the Y4M stream is piped into the rest of it as a command and the
+// sound goes to capture.wav.  Nothing happens until the first frame.
+void set_target(const char *name);
+
+// blend the game overlay into the captured frames
+void set_overlay(bool value);
+
+bool is_armed();
+bool get_overlay();
+
+// Called from vid_blit() with the YUV frame on screen (NULL planes for a
+// blanked screen) and optionally the overlay surface and the part of it that
+// is shown.  The first call opens the streams.
+void video_frame(const uint8_t *Y, const uint8_t *U, const uint8_t *V,
+                 int Ypitch, int Upitch, int Vpitch, int width, int height,
+                 SDL_Surface *overlay, const SDL_Rect *overlay_rect);
+
+// called from the audio callback with the final mix
+void audio(const uint8_t *pcm, int bytes);
+
+// writes what is queued, closes the streams and logs the drop counts
+void stop();
+}
+
+#endif // CAPTURE_H
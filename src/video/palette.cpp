@@ -27,11 +27,17 @@
 #include "../video/video.h"
 #include "palette.h"
 #include <plog/Log.h>
+#include <string.h>
 
 #ifdef DEBUG
 #include <assert.h>
 #endif
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define PALETTE_AVX2
+#endif
+
 namespace palette
 {
 
@@ -40,6 +46,18 @@ bool g_modified     = true;
 
 std::vector<SDL_Color> g_rgb;
 
+// bumped whenever the surfaces get a new palette, so convert() knows its
+// lookup table is out of date
+Uint32 g_generation = 0;
+
+// convert() state: the 32-bit value of each colour for the destination
+// format, and a copy of the 8-bit pixels it last converted
+Uint32 g_lut[256];
+Uint32 g_lut_generation = 0;
+SDL_PixelFormat g_lut_format = SDL_PIXELFORMAT_UNKNOWN;
+std::vector<Uint8> g_shadow;
+int g_shadow_w = 0, g_shadow_h = 0;
+
 // call this function once to set size of game palette
 bool initialize(unsigned int num_colors)
 {
@@ -74,6 +92,8 @@ bool initialize(unsigned int num_colors)
     // Default colour 0 is transparent.
     set_transparency(0, true);
 
+    g_generation++;
+
     return true;
 }
 
@@ -130,6 +150,10 @@ void finalize()
                 break;
             }
         }
+
+        // every pixel of the overlay may have changed colour
+        g_game->set_video_overlay_dirty(NULL);
+        g_generation++;
     }
     g_modified = false;
 }
@@ -138,6 +162,125 @@ void finalize()
 void shutdown(void)
 {
     g_rgb.clear();
+    g_shadow.clear();
+    g_shadow_w = g_shadow_h = 0;
+    g_lut_format = SDL_PIXELFORMAT_UNKNOWN;
+}
+
+typedef void (*index_row_t)(Uint32 *, const Uint8 *, int);
+
+static void index_row_c(Uint32 *d, const Uint8 *s, int w)
+{
+    int x = 0;
+
+    for (; x + 4 <= w; x += 4) {
+        Uint32 p0 = g_lut[s[x]], p1 = g_lut[s[x + 1]];
+        Uint32 p2 = g_lut[s[x + 2]], p3 = g_lut[s[x + 3]];
+        d[x] = p0; d[x + 1] = p1; d[x + 2] = p2; d[x + 3] = p3;
+    }
+    for (; x < w; x++) d[x] = g_lut[s[x]];
+}
+
+#ifdef PALETTE_AVX2
+// 8 pixels per gather, there is no cheaper way to look up a 256 entry table
+// of 32-bit values on x86 (pshufb only reaches 16 bytes)
+__attribute__((target("avx2")))
+static void index_row_avx2(Uint32 *d, const Uint8 *s, int w)
+{
+    int x = 0;
+
+    for (; x + 8 <= w; x += 8) {
+        __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(s + x)));
+        __m256i px  = _mm256_i32gather_epi32((const int *)g_lut, idx, 4);
+        _mm256_storeu_si256((__m256i *)(d + x), px);
+    }
+    for (; x < w; x++) d[x] = g_lut[s[x]];
+}
+#endif
+
+static index_row_t select_index_row()
+{
+#ifdef PALETTE_AVX2
+    if (__builtin_cpu_supports("avx2")) return index_row_avx2;
+#endif
+    return index_row_c;
+}
+
+static index_row_t get_index_row()
+{
+    static const index_row_t row = select_index_row();
+    return row;
+}
+
+static void build_lut(SDL_Surface *src, SDL_Surface *dst)
+{
+    const SDL_PixelFormatDetails *details = SDL_GetPixelFormatDetails(dst->format);
+    SDL_Palette *palette = SDL_GetSurfacePalette(src);
+
+    memset(g_lut, 0, sizeof(g_lut));
+
+    for (int i = 0; palette && i < palette->ncolors && i < 256; i++) {
+        const SDL_Color &c = palette->colors[i];
+        g_lut[i] = SDL_MapRGBA(details, NULL, c.r, c.g, c.b, c.a);
+    }
+
+    g_lut_generation = g_generation;
+    g_lut_format     = dst->format;
+}
+
+SDL_Rect convert(SDL_Surface *src, const SDL_Rect &area, SDL_Surface *dst,
+                 int dx, int dy, bool force)
+{
+    SDL_Rect out = {0, 0, 0, 0};
+    SDL_Rect a, d;
+    SDL_Rect whole = {0, 0, src->w, src->h};
+    SDL_Rect dst_whole = {0, 0, dst->w, dst->h};
+
+    if (!SDL_GetRectIntersection(&area, &whole, &a)) return out;
+
+    d = (SDL_Rect){a.x + dx, a.y + dy, a.w, a.h};
+    if (!SDL_GetRectIntersection(&d, &dst_whole, &d)) return out;
+
+    a = (SDL_Rect){d.x - dx, d.y - dy, d.w, d.h};
+
+    // anything we don't have a table for goes the slow way
+    if (src->format != SDL_PIXELFORMAT_INDEX8 ||
+            SDL_BYTESPERPIXEL(dst->format) != 4) {
+        SDL_BlitSurface(src, &a, dst, &d);
+        return d;
+    }
+
+    if (g_lut_generation != g_generation || g_lut_format != dst->format) {
+        build_lut(src, dst);
+        force = true;
+    }
+
+    if (g_shadow_w != src->w || g_shadow_h != src->h) {
+        g_shadow.assign((size_t)src->w * src->h, 0);
+        g_shadow_w = src->w;
+        g_shadow_h = src->h;
+        force = true;
+    }
+
+    index_row_t row = get_index_row();
+    int top = -1, bottom = -1;
+
+    for (int y = a.y; y < a.y + a.h; y++) {
+        const Uint8 *s = (const Uint8 *)src->pixels + (y * src->pitch) + a.x;
+        Uint8 *shadow  = &g_shadow[((size_t)y * g_shadow_w) + a.x];
+
+        if (!force && !memcmp(s, shadow, a.w)) continue;
+
+        memcpy(shadow, s, a.w);
+        row((Uint32 *)((Uint8 *)dst->pixels + ((y + dy) * dst->pitch)) + d.x, s, a.w);
+
+        if (top < 0) top = y;
+        bottom = y;
+    }
+
+    if (top >= 0) out = (SDL_Rect){d.x, top + dy, d.w, bottom - top + 1};
+
+    return out;
 }
 
 bool get_yuv_overlay_ready()
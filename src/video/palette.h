@@ -40,4 +40,12 @@ bool get_yuv_overlay_ready();
 void set_color(unsigned int color_num, SDL_Color color_value);
 void finalize();
 void shutdown(void);
+
+// Converts 'area' of an 8-bit overlay into a 32-bit surface at (dx, dy)
+//  through a lookup table built from the overlay's palette.  Rows that are
+//  the same as when they were last converted are skipped, unless the palette
+//  has been finalized since or 'force' is set.  Returns the part of 'dst'
+//  that was written, which may be empty.
+SDL_Rect convert(SDL_Surface *src, const SDL_Rect &area, SDL_Surface *dst,
+                 int dx, int dy, bool force);
 }
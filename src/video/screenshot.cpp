@@ -0,0 +1,192 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 DirtBagXon
+ *
+ * This file is part of HYPSEUS, a laserdisc arcade game emulator
+ *
+ * HYPSEUS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "config.h"
+
+#include "../io/conout.h"
+#include "../io/mpo_fileio.h"
+#include "screenshot.h"
+#include "video.h"
+#include <SDL3_image/SDL_image.h>
+#include <plog/Log.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+namespace screenshot
+{
+
+static const char g_dir[] = "screenshots";
+
+SDL_Thread *g_thread       = NULL;
+SDL_Mutex *g_mutex         = NULL;
+SDL_Condition *g_cond      = NULL;
+bool g_quit                = false;
+
+// frames waiting for the encoder, oldest at g_head
+SDL_Surface *g_queue[QUEUE_SIZE];
+int g_head                 = 0;
+int g_count                = 0;
+
+// next hypseus-N.png to try, 0 until the directory has been scanned
+int g_next                 = 0;
+
+// finds the highest hypseus-N.png already there, once
+static void scan_dir()
+{
+    int count = 0;
+    char **names = SDL_GlobDirectory(g_dir, "hypseus-*.png", 0, &count);
+
+    g_next = 1;
+
+    for (int i = 0; names && i < count; i++) {
+        int n = 0;
+        if (sscanf(names[i], "hypseus-%d.png", &n) == 1 && n >= g_next)
+            g_next = n + 1;
+    }
+
+    SDL_free(names);
+}
+
+static void write_frame(SDL_Surface *frame)
+{
+    struct stat info;
+    char filename[64];
+
+    if (stat(g_dir, &info) != 0) {
+        LOGW << fmt("'%s' directory does not exist.", g_dir);
+        return;
+    } else if (!(info.st_mode & S_IFDIR)) {
+        LOGW << fmt("'%s' is not a directory.", g_dir);
+        return;
+    }
+
+    if (!g_next) scan_dir();
+
+    // something else may have written one since the scan
+    do {
+        snprintf(filename, sizeof(filename), "%s%shypseus-%d.png",
+                 g_dir, PATH_SEPARATOR, g_next++);
+    } while (mpo_file_exists(filename));
+
+    if (IMG_SavePNG(frame, filename))
+        LOGI << fmt("Wrote screenshot: %s", filename);
+    else
+        LOGE << fmt("Could not write screenshot: %s !! - %s", filename, SDL_GetError());
+}
+
+static int encoder_thread(void *)
+{
+    SDL_LockMutex(g_mutex);
+
+    for (;;) {
+        while (!g_count && !g_quit)
+            SDL_WaitCondition(g_cond, g_mutex);
+
+        if (!g_count) break; // quitting, and nothing left to write
+
+        SDL_Surface *frame = g_queue[g_head];
+        g_head = (g_head + 1) % QUEUE_SIZE;
+        g_count--;
+
+        SDL_UnlockMutex(g_mutex);
+
+        write_frame(frame);
+        SDL_DestroySurface(frame);
+
+        SDL_LockMutex(g_mutex);
+    }
+
+    SDL_UnlockMutex(g_mutex);
+
+    return 0;
+}
+
+static bool start()
+{
+    g_mutex = SDL_CreateMutex();
+    g_cond  = SDL_CreateCondition();
+
+    if (g_mutex && g_cond) {
+        g_quit   = false;
+        g_thread = SDL_CreateThread(encoder_thread, "screenshot", NULL);
+        if (g_thread) return true;
+    }
+
+    LOGE << fmt("Could not create screenshot thread: %s", SDL_GetError());
+    shutdown();
+
+    return false;
+}
+
+bool queue(SDL_Surface *frame)
+{
+    bool result = false;
+
+    if (!g_thread && !start()) {
+        SDL_DestroySurface(frame);
+        return false;
+    }
+
+    SDL_LockMutex(g_mutex);
+
+    if (g_count < QUEUE_SIZE) {
+        g_queue[(g_head + g_count) % QUEUE_SIZE] = frame;
+        g_count++;
+        SDL_SignalCondition(g_cond);
+        result = true;
+    }
+
+    SDL_UnlockMutex(g_mutex);
+
+    if (!result) {
+        LOGW << "Screenshot dropped, still writing the previous ones";
+        SDL_DestroySurface(frame);
+    }
+
+    return result;
+}
+
+void shutdown()
+{
+    if (g_thread) {
+        SDL_LockMutex(g_mutex);
+        g_quit = true;
+        SDL_SignalCondition(g_cond);
+        SDL_UnlockMutex(g_mutex);
+
+        SDL_WaitThread(g_thread, NULL);
+        g_thread = NULL;
+    }
+
+    if (g_cond) {
+        SDL_DestroyCondition(g_cond);
+        g_cond = NULL;
+    }
+
+    if (g_mutex) {
+        SDL_DestroyMutex(g_mutex);
+        g_mutex = NULL;
+    }
+}
+
+}
@@ -0,0 +1,45 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 DirtBagXon
+ *
+ * This file is part of HYPSEUS, a laserdisc arcade game emulator
+ *
+ * HYPSEUS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Writes screenshots on a background thread, so vid_blit() only pays for
+// the read back.
+
+#ifndef SCREENSHOT_H
+#define SCREENSHOT_H
+
+#include <SDL3/SDL.h>
+
+namespace screenshot
+{
+// how many read back frames may be waiting to be encoded
+static const int QUEUE_SIZE = 4;
+
+// Hands a read back frame to the encoder thread (starting it if needed),
+// which frees it once written.  If the queue is full the frame is dropped
+// and false is returned.
+bool queue(SDL_Surface *frame);
+
+// writes whatever is still queued and stops the encoder thread
+void shutdown();
+}
+
+#endif // SCREENSHOT_H
@@ -792,6 +792,11 @@ void tms9128nl_drawchar(unsigned char ch, int col, int row, unsigned char tile)
         }
     }
 
+    // this character and possibly the one after it (see above), which isn't
+    // there for the last column
+    SDL_Rect dirty = {x, y + stretch_offset,
+                      SDL_min(CharWidth << 1, TMS9128NL_OVERLAY_W - x), CharHeight};
+    g_game->set_video_overlay_dirty(&dirty);
     g_game->set_video_overlay_needs_update(true);
 }
 
@@ -912,6 +917,7 @@ void tms9128nl_video_repaint()
 
         if (g_conv_12a563) g_vidmode = prev_vidmode;
         g_transparency_latch = g_transparency_enabled;
+        g_game->set_video_overlay_dirty(NULL);
     }
 
     g_transparency_enabled = 0; // apparently this has to be set to true every
@@ -922,6 +928,7 @@ void tms9128nl_video_repaint()
     // instead of our regular one
     if (g_vidmode == 2 && !g_nostretch) {
         tms9128nl_video_repaint_stretched();
+        g_game->set_video_overlay_dirty(NULL); // blended across characters
     }
 
     // if we're not in mode 2, display our non-stretched overlay
@@ -1030,6 +1037,7 @@ void tms9128nl_clear_overlay()
         *ptr = 0;
     }
 
+    g_game->set_video_overlay_dirty(NULL);
     g_game->set_video_overlay_needs_update(true);
 }
 
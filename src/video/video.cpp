@@ -28,12 +28,17 @@
 #include "../io/mpo_fileio.h"
 #include "../io/mpo_mem.h"
 #include "icon.h"
+#include "palette.h"
+#include "screenshot.h"
+#include "capture.h"
 #include "video.h"
+#include "yuvkernel.h"
 #include <SDL3_image/SDL_image.h>
 #include <plog/Log.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
 #include <string>
 
 namespace video {
@@ -139,14 +144,32 @@ double g_aux_ratio                     = 1.0f;
 float g_yuv_scale[2]                   = {1.0f, 1.0f};
 
 // YUV structure
+// Triple buffered so that neither the vldp thread nor vid_blit() ever waits
+// for the other: the vldp thread fills 'back' and swaps it into 'mailbox',
+// vid_blit() swaps whatever is in 'mailbox' with 'front' when it is FRESH.
+// A buffer can also stand for a vldp frame that is uploaded in place (see
+// vid_hold_yuv_overlay()), which is released once the buffer is reused.
+#define YUV_BUFFERS 3
+#define YUV_FRESH   4                  // mailbox holds a frame not yet taken
+
+typedef struct {
+    void *ref;                         // held vldp frame, NULL if none
+    void (*release)(void *ref);
+    const uint8_t *Y, *U, *V;
+    int Ypitch, Upitch, Vpitch;
+} m_yuv_held_t;
+
 typedef struct {
-    uint8_t *Yplane;
-    uint8_t *Uplane;
-    uint8_t *Vplane;
+    uint8_t *Yplane[YUV_BUFFERS];
+    uint8_t *Uplane[YUV_BUFFERS];
+    uint8_t *Vplane[YUV_BUFFERS];
+    m_yuv_held_t held[YUV_BUFFERS];    // in place of the planes above
     int width, height;
     int Ysize, Usize, Vsize;           // The size of each plane in bytes.
     int Ypitch, Upitch, Vpitch;        // The pitch of each plane in bytes.
-    SDL_Mutex *mutex;
+    int back;                          // buffer the vldp thread is filling
+    int front;                         // buffer last taken by vid_blit()
+    std::atomic<int> mailbox;          // newest complete buffer (| YUV_FRESH)
 } m_yuv_surface_t;
 
 // texture size caching
@@ -160,12 +183,56 @@ std::vector<SDL_Rect>                  displayDimensions;
 
 m_textureT g_mix_texture               = {.t = NULL, .w = 0, .h = 0 };
 
+// Scanlines and the outline border are drawn once into these and only
+// redrawn when their rect or the settings in 'key' change, or on a rescale
+#define LAYER_STALE 0xffffffff
+typedef struct {
+    SDL_Texture *t;
+    SDL_Rect r;              // where the layer goes on the mix texture
+    uint32_t key;            // packed settings it was drawn with
+    SDL_Texture *target;     // render state saved while drawing it
+    SDL_BlendMode mode;
+} m_layerT;
+
+m_layerT g_scanline_layer              = {.t = NULL, .r = {0, 0, 0, 0}, .key = LAYER_STALE };
+m_layerT g_border_layer                = {.t = NULL, .r = {0, 0, 0, 0}, .key = LAYER_STALE };
+
 // blitting flags
 bool g_scoreboard_needs_update         = false;
-bool g_yuv_video_needs_update          = false;
 bool g_aux_needs_update                = false;
 bool g_yuv_skip                        = true;
 
+// set_yuv_blank(YUV_BLANK) asks vid_blit() to blank the texture right away
+std::atomic<bool> g_yuv_blank_pending(false);
+
+// whether vid_blit() last blanked the YUV texture rather than filling it
+bool g_yuv_shown_blank = true;
+
+// YUV mailbox statistics
+std::atomic<uint32_t> g_yuv_published(0); // frames the vldp thread finished
+std::atomic<uint32_t> g_yuv_dropped(0);   // replaced before vid_blit() saw them
+uint32_t g_yuv_repeated                = 0; // blits that had no new frame
+
+// part of g_overlay_surface changed since it was last sent to the texture,
+// and how much of it has been sent (see notify_stats)
+SDL_Rect g_overlay_dirty               = {0, 0, 0, 0};
+SDL_Rect g_overlay_converted           = {0, 0, 0, 0}; // last game overlay size
+uint64_t g_overlay_upload_bytes        = 0;
+Uint64 g_overlay_upload_since          = 0;
+
+// strings kept laid out between frames (see get_text)
+typedef struct {
+    TTF_Text *t;
+    TTF_Font *font;
+    std::string s;
+} m_textT;
+
+m_textT g_text_cache[TEXT_SLOTS];
+
+// vid_blit() timing, read by the benchmark
+uint32_t g_blit_count                  = 0;
+Uint64 g_blit_ticks                    = 0;
+
 //////////////////////////////////////////////////////////////////////////////
 
 static void ConvertSurface(SDL_Surface **surface, SDL_PixelFormat fmt)
@@ -184,22 +251,85 @@ static void LogicalPosition(SDL_Rect *port, SDL_Rect *dst, int x, int y)
     *dst = tmpRect;
 }
 
-static inline void copyPlane(uint8_t *dst, const uint8_t *src, int w, int h, int srcPitch)
+static void calcAuxRect()
+{
+     double scale = 9.0f - double((g_aux_bezel_scale << 1) / 10.0f);
+     g_aux_rect.w = (g_bezel_scalewidth / scale);
+     g_aux_rect.h = (g_aux_rect.w * g_aux_ratio);
+}
+
+static void layer_invalidate(m_layerT *layer) { layer->key = LAYER_STALE; }
+
+static void layer_destroy(m_layerT *layer)
 {
-    if (srcPitch == w)
+    SDL_DestroyTexture(layer->t);
+    layer->t = NULL;
+    layer->key = LAYER_STALE;
+}
+
+static void free_text_cache()
+{
+    for (int i = 0; i < TEXT_SLOTS; i++)
     {
-        memcpy(dst, src, (size_t)w * h);
-    } else {
-        for (int y = 0; y < h; ++y)
-            memcpy(dst + (size_t)y * w, src + (size_t)y * srcPitch, w);
+        if (g_text_cache[i].t) TTF_DestroyText(g_text_cache[i].t);
+
+        g_text_cache[i].t = NULL;
+        g_text_cache[i].font = NULL;
+        g_text_cache[i].s.clear();
     }
 }
 
-static void calcAuxRect()
+TTF_Text *get_text(int slot, TTF_Font *font, const char *s)
 {
-     double scale = 9.0f - double((g_aux_bezel_scale << 1) / 10.0f);
-     g_aux_rect.w = (g_bezel_scalewidth / scale);
-     g_aux_rect.h = (g_aux_rect.w * g_aux_ratio);
+    m_textT *c = &g_text_cache[slot];
+
+    if (c->t && c->font == font && c->s == s) return c->t;
+
+    if (c->t) TTF_DestroyText(c->t);
+
+    c->t = TTF_CreateText(g_font_engine, font, s, 0);
+    c->font = font;
+    c->s = s;
+
+    return c->t;
+}
+
+// grows g_overlay_dirty by 'rect' (NULL for the whole surface)
+static void overlay_dirty(const SDL_Rect *rect)
+{
+    if (!g_overlay_surface) return;
+
+    SDL_Rect full = {0, 0, g_overlay_surface->w, g_overlay_surface->h};
+    SDL_Rect r = full;
+
+    if (rect && !SDL_GetRectIntersection(rect, &full, &r)) return;
+
+    if (SDL_RectEmpty(&g_overlay_dirty)) g_overlay_dirty = r;
+    else SDL_GetRectUnion(&g_overlay_dirty, &r, &g_overlay_dirty);
+}
+
+static void overlay_upload(const SDL_Rect &r)
+{
+    int bpp = SDL_BYTESPERPIXEL(g_overlay_surface->format);
+    Uint8 *pixels = (Uint8 *)g_overlay_surface->pixels +
+                        (r.y * g_overlay_surface->pitch) + (r.x * bpp);
+
+    SDL_UpdateTexture(g_overlay_texture, &r, pixels, g_overlay_surface->pitch);
+    g_overlay_upload_bytes += (uint64_t)r.w * r.h * bpp;
+}
+
+// KB/s sent to the overlay texture since the last call
+static unsigned int overlay_upload_rate()
+{
+    Uint64 now = SDL_GetTicks();
+    Uint64 elapsed = now - g_overlay_upload_since;
+    unsigned int rate = elapsed ?
+        (unsigned int)((g_overlay_upload_bytes * 1000) / (elapsed << 10)) : 0;
+
+    g_overlay_upload_bytes = 0;
+    g_overlay_upload_since = now;
+
+    return rate;
 }
 
 static void resize_cleanup()
@@ -220,6 +350,7 @@ static void resize_cleanup()
     g_aux_texture = NULL;
     g_scoreboard_texture = NULL;
 
+    free_text_cache();
     TTF_CloseFont(g_font);
     TTF_CloseFont(g_ttfont);
     TTF_DestroyRendererTextEngine(g_font_engine);
@@ -230,6 +361,8 @@ static void resize_cleanup()
 
     SDL_DestroyTexture(g_overlay_texture);
     SDL_DestroyTexture(g_mix_texture.t);
+    layer_destroy(&g_scanline_layer);
+    layer_destroy(&g_border_layer);
 
     if (g_renderer)
     {
@@ -247,6 +380,8 @@ static void resize_cleanup()
 
 static void load_fonts()
 {
+    free_text_cache();
+
     if (g_font)
     {
        TTF_CloseFont(g_font);
@@ -780,6 +915,9 @@ bool init_display()
                 goto exit;
             }
 
+            g_overlay_converted = (SDL_Rect){0, 0, 0, 0};
+            overlay_dirty(NULL);
+
             // Check for game overlay enhancements (depth and size)
             VIDEO_ASSIGN(ENHANCE_OVERLAY, g_game->has_overlay_upgrade(GAME_OVERLAY_UPGRADE));
             VIDEO_ASSIGN(OVERLAY_DYNAMIC,  g_game->get_dynamic_overlay());
@@ -839,15 +977,28 @@ void reset_yuv_overlay()
     SDL_Delay(2);
 }
 
+// hands the vldp frame that a buffer was standing for back to vldp
+static void vid_release_held_yuv(int buf)
+{
+    m_yuv_held_t *held = &g_yuv_surface->held[buf];
+
+    if (held->ref)
+    {
+        held->release(held->ref);
+        held->ref = NULL;
+    }
+}
+
 void vid_free_yuv_overlay()
 {
     // Here we free both the YUV surface and YUV texture.
-    SDL_DestroyMutex (g_yuv_surface->mutex);
-   
-    free(g_yuv_surface->Yplane);
-    free(g_yuv_surface->Uplane);
-    free(g_yuv_surface->Vplane);
-    free(g_yuv_surface);
+    // (U and V live in the same allocation as Y)
+    for (int i = 0; i < YUV_BUFFERS; i++)
+    {
+        vid_release_held_yuv(i);
+        free(g_yuv_surface->Yplane[i]);
+    }
+    delete g_yuv_surface;
 
     if (g_yuv_texture)
         SDL_DestroyTexture(g_yuv_texture);
@@ -862,6 +1013,9 @@ void vid_free_yuv_overlay()
 // returns true if successful, false if failure
 bool deinit_display()
 {
+    screenshot::shutdown(); // let queued screenshots finish
+    capture::stop();
+
     SDL_SetWindowMouseGrab(g_window, false);
 
     SDL_DestroyTexture(g_scoreboard_texture);
@@ -882,6 +1036,9 @@ bool deinit_display()
 
     g_overlay_surface = NULL;
 
+    LOGI << fmt("Overlay uploads: %u KB/s", overlay_upload_rate());
+
+    free_text_cache();
     TTF_CloseFont(g_font);
     TTF_CloseFont(g_ttfont);
     TTF_DestroyRendererTextEngine(g_font_engine);
@@ -905,6 +1062,8 @@ bool deinit_display()
 
     SDL_DestroyTexture(g_overlay_texture);
     SDL_DestroyTexture(g_mix_texture.t);
+    layer_destroy(&g_scanline_layer);
+    layer_destroy(&g_border_layer);
     SDL_DestroyRenderer(g_renderer);
     SDL_DestroyWindow(g_window);
 
@@ -1099,12 +1258,25 @@ bool draw_led(int value, int x, int y, unsigned char end)
     if (led == end)
     {
 
-        if (g_scoreboard_texture) SDL_DestroyTexture(g_scoreboard_texture);
-
         SDL_Renderer *renderer = VIDEO_HAS(SCOREBOARD_BEZEL) ? g_renderer : g_scoreboard_renderer;
 
-        g_scoreboard_texture = SDL_CreateTextureFromSurface(renderer, g_scoreboard_blit_surface);
-        if (!g_scoreboard_texture) return false;
+        // the digits change, the texture doesn't need to
+        if (g_scoreboard_texture &&
+                SDL_GetRendererFromTexture(g_scoreboard_texture) == renderer &&
+                g_scoreboard_texture->format == g_scoreboard_blit_surface->format &&
+                g_scoreboard_texture->w == g_scoreboard_blit_surface->w &&
+                g_scoreboard_texture->h == g_scoreboard_blit_surface->h)
+        {
+            SDL_UpdateTexture(g_scoreboard_texture, NULL,
+                g_scoreboard_blit_surface->pixels, g_scoreboard_blit_surface->pitch);
+        }
+        else
+        {
+            if (g_scoreboard_texture) SDL_DestroyTexture(g_scoreboard_texture);
+
+            g_scoreboard_texture = SDL_CreateTextureFromSurface(renderer, g_scoreboard_blit_surface);
+            if (!g_scoreboard_texture) return false;
+        }
 
         if (!VIDEO_HAS(SCOREBOARD_BEZEL))
         {
@@ -1220,6 +1392,10 @@ void draw_overlay_leds(unsigned int values[], int num_digits,
         dest.x += OVERLAY_LED_WIDTH;
     }
 
+    SDL_Rect dirty = {start_x - 1, y, (num_digits * OVERLAY_LED_WIDTH) + 1,
+                          OVERLAY_LED_HEIGHT + 1};
+    overlay_dirty(&dirty);
+
     VIDEO_SET(BLOCK_DRIVER_OVERLAY);
 }
 
@@ -1282,6 +1458,11 @@ void draw_singleline_LDP1450(char *LDP1450_String, int start_x, int y)
          }
          dest.x += OVERLAY_LDP1450_CHARACTER_SPACING;
     }
+
+    SDL_Rect dirty = {start_x, y, (dest.x - start_x) -
+                          OVERLAY_LDP1450_CHARACTER_SPACING + OVERLAY_LDP1450_WIDTH,
+                          OVERLAY_LDP1450_HEIGHT};
+    overlay_dirty(&dirty);
 }
 
 //  used to draw non LED stuff like scoreboard text
@@ -1385,6 +1566,7 @@ void set_scanlines(bool value) { VIDEO_ASSIGN(SCANLINES, value); }
 void set_shunt(uint8_t value) { g_scanline_shunt = value; }
 void set_alpha(uint8_t value) { g_scanline_alpha = value; }
 void set_queue_screenshot(bool value) { VIDEO_ASSIGN(TAKE_SCREENSHOT, value); }
+void set_mix_target(bool value) { VIDEO_ASSIGN(MIX_TARGET, value); }
 void set_scale_linear(bool value) { VIDEO_ASSIGN(SCALE_LINEAR, value); }
 void set_sboverlay_characterset(int value) { sboverlay_characterset = value; }
 void set_sboverlay_white(bool value) { VIDEO_ASSIGN(OVERLAY_WHITE, value); }
@@ -1464,10 +1646,9 @@ void set_yuv_blank(int value)
 {
     g_yuv_display = value;
 
+    // later frames from the vldp thread are blanked, but it may not send any
     if (value == YUV_BLANK)
-        vid_update_yuv_overlay(g_yuv_surface->Yplane, g_yuv_surface->Uplane,
-            g_yuv_surface->Vplane, g_yuv_surface->Ypitch, g_yuv_surface->Upitch,
-            g_yuv_surface->Vpitch);
+        g_yuv_blank_pending = true;
 }
 
 void set_scalefactor(int value)
@@ -1799,6 +1980,14 @@ void draw_string(const char *t, int col, int row, SDL_Surface *overlay,
     }
 
     SDL_BlitSurface(text_surface, NULL, overlay, &dest);
+
+    if (overlay == g_overlay_surface)
+    {
+        SDL_Rect dirty = {dest.x - 1, dest.y - 1, text_surface->w + 2,
+                              text_surface->h + 2};
+        overlay_dirty(&dirty);
+    }
+
     SDL_DestroySurface(text_surface);
 }
 
@@ -1832,20 +2021,26 @@ void draw_srt(const char *s, uint8_t func, int pos = -1)
     char *copy = SDL_strdup(s);
     char *saveptr = NULL;
 
+    TTF_Text *lines[SRT_LINES];
+    int widths[SRT_LINES];
+
     int max_w = 0;
     int line_count = 0;
 
     for (char *line = strtok_r(copy, "\n", &saveptr);
-         line;
+         line && line_count < SRT_LINES;
          line = strtok_r(NULL, "\n", &saveptr))
     {
+        TTF_Text *text = get_text(TEXT_SRT + line_count, g_font, line);
+
         int w = 0, h = 0;
-        TTF_GetStringSize(g_font, line, 0, &w, &h);
+        if (text) TTF_GetTextSize(text, &w, &h);
 
         if (w > max_w)
             max_w = w;
 
-        line_count++;
+        lines[line_count] = text;
+        widths[line_count++] = w;
     }
 
     int line_skip = TTF_GetFontLineSkip(g_font);
@@ -1862,31 +2057,17 @@ void draw_srt(const char *s, uint8_t func, int pos = -1)
     SDL_SetRenderDrawColor(g_renderer, 0x14, 0x14, 0x14, 0xff);
     SDL_RenderFillRect(g_renderer, &bg);
 
-    copy = SDL_strdup(s);
-    saveptr = NULL;
-
     float y = base_y;
 
-    for (char *line = strtok_r(copy, "\n", &saveptr);
-         line;
-         line = strtok_r(NULL, "\n", &saveptr))
+    for (int i = 0; i < line_count; i++)
     {
-        TTF_Text *text = TTF_CreateText(g_font_engine, g_font, line, 0);
+        float lx = x - widths[i] / 2.0f;
 
-        int w = 0, h = 0;
-        TTF_GetStringSize(g_font, line, 0, &w, &h);
-
-        float lx = x - w / 2.0f;
-
-        TTF_DrawRendererText(text, (int)lx, (int)y);
-
-        TTF_DestroyText(text);
+        if (lines[i]) TTF_DrawRendererText(lines[i], (int)lx, (int)y);
 
         y += line_skip;
     }
 
-    SDL_free(copy);
-
     message_timer++;
 }
 
@@ -1916,8 +2097,11 @@ void draw_subtitle(const char *s, uint8_t func, bool center = false)
 
     const int pad_x = (int)(g_scaling_rect.w * 0.03f);
 
+    TTF_Text *text = get_text(TEXT_SUBTITLE, g_font, s);
+    if (!text) return;
+
     int w = 0, h = 0;
-    TTF_GetStringSize(g_font, s, 0, &w, &h);
+    TTF_GetTextSize(text, &w, &h);
 
     if (align)
     {
@@ -1928,10 +2112,7 @@ void draw_subtitle(const char *s, uint8_t func, bool center = false)
         p.x = (float)(g_scaling_rect.x + pad_x);
     }
 
-    TTF_Text *text = TTF_CreateText(g_font_engine, g_font, s, strlen(s));
-
     TTF_DrawRendererText(text, (int)p.x, (int)p.y);
-    TTF_DestroyText(text);
 
     m_message_timer++;
 }
@@ -2054,16 +2235,21 @@ void vid_setup_yuv_overlay (int width, int height)
         vid_free_yuv_overlay();
     }
 
-    g_yuv_surface = (m_yuv_surface_t*) malloc (sizeof(m_yuv_surface_t));
+    g_yuv_surface = new m_yuv_surface_t;
 
     // 12 bits (1 + 0.5 bytes) per pixel, and each plane has different size. Crazy stuff.
     g_yuv_surface->Ysize = width * height;
     g_yuv_surface->Usize = g_yuv_surface->Ysize / 4;
     g_yuv_surface->Vsize = g_yuv_surface->Ysize / 4;
-   
-    g_yuv_surface->Yplane = (uint8_t*) malloc (g_yuv_surface->Ysize);
-    g_yuv_surface->Uplane = (uint8_t*) malloc (g_yuv_surface->Usize);
-    g_yuv_surface->Vplane = (uint8_t*) malloc (g_yuv_surface->Vsize);
+
+    for (int i = 0; i < YUV_BUFFERS; i++)
+    {
+        g_yuv_surface->Yplane[i] = (uint8_t*) malloc (g_yuv_surface->Ysize +
+            g_yuv_surface->Usize + g_yuv_surface->Vsize);
+        g_yuv_surface->Uplane[i] = g_yuv_surface->Yplane[i] + g_yuv_surface->Ysize;
+        g_yuv_surface->Vplane[i] = g_yuv_surface->Uplane[i] + g_yuv_surface->Usize;
+        g_yuv_surface->held[i].ref = NULL;
+    }
 
     g_yuv_surface->width  = width;
     g_yuv_surface->height = height;
@@ -2072,8 +2258,10 @@ void vid_setup_yuv_overlay (int width, int height)
     g_yuv_surface->Upitch = g_yuv_surface->width / 2;
     g_yuv_surface->Vpitch = g_yuv_surface->width / 2;
 
-    // Setup the threaded access stuff, since this surface is accessed from the vldp thread, too.
-    g_yuv_surface->mutex = SDL_CreateMutex();
+    // Each side of the mailbox starts off with a buffer of its own
+    g_yuv_surface->back    = 0;
+    g_yuv_surface->front   = 1;
+    g_yuv_surface->mailbox = 2;
 
     if (g_yuv_frect[0])
     {
@@ -2085,24 +2273,24 @@ void vid_setup_yuv_overlay (int width, int height)
     }
 }
 
-static void vid_flash_yuv_surface()
+static void vid_flash_yuv_surface(int buf)
 {
     // White: YUV#ED8080 - D4 = 90%
-    memset(g_yuv_surface->Yplane, 0xd4, g_yuv_surface->Ysize);
-    memset(g_yuv_surface->Uplane, 0x80, g_yuv_surface->Usize);
-    memset(g_yuv_surface->Vplane, 0x80, g_yuv_surface->Vsize);
+    memset(g_yuv_surface->Yplane[buf], 0xd4, g_yuv_surface->Ysize);
+    memset(g_yuv_surface->Uplane[buf], 0x80, g_yuv_surface->Usize);
+    memset(g_yuv_surface->Vplane[buf], 0x80, g_yuv_surface->Vsize);
 }
 
-static void vid_blank_yuv_surface()
+static void vid_blank_yuv_surface(int buf)
 {
     // Blue: YUV#1DEB6B - Black: YUV#108080
     uint8_t Y_value = VIDEO_HAS(YUV_BLUE) ? 0x1d : 0x10;
     uint8_t U_value = VIDEO_HAS(YUV_BLUE) ? 0xeb : 0x80;
     uint8_t V_value = VIDEO_HAS(YUV_BLUE) ? 0x6b : 0x80;
 
-    memset(g_yuv_surface->Yplane, Y_value, g_yuv_surface->Ysize);
-    memset(g_yuv_surface->Uplane, U_value, g_yuv_surface->Usize);
-    memset(g_yuv_surface->Vplane, V_value, g_yuv_surface->Vsize);
+    memset(g_yuv_surface->Yplane[buf], Y_value, g_yuv_surface->Ysize);
+    memset(g_yuv_surface->Uplane[buf], U_value, g_yuv_surface->Usize);
+    memset(g_yuv_surface->Vplane[buf], V_value, g_yuv_surface->Vsize);
 }
 
 static void vid_blank_yuv_texture()
@@ -2135,43 +2323,6 @@ static void vid_blank_yuv_texture()
     free(v_plane);
 }
 
-static inline void blendPlane(const uint8_t *src, uint8_t *dst, int w, int h,
-	int srcPitch, int dstPitch)
-{
-    for (int y = 0; y < h; ++y)
-    {
-        const uint8_t *line0 = src + ((y > 0 ? y - 1 : y) * srcPitch);
-        const uint8_t *line1 = src + ( y * srcPitch);
-        const uint8_t *line2 = src + ((y < h - 1 ? y + 1 : y) * srcPitch);
-        uint8_t *row = dst + y * dstPitch;
-
-        for (int x = 0; x < w; ++x)
-            row[x] = (uint8_t)(((uint32_t)
-		    line0[x] + line1[x] + line2[x] + 1U) * 341U >> 10);
-    }
-}
-
-static inline void lumaControl(const uint8_t *src, uint8_t *dst, int width, int height,
-        int srcPitch, int dstPitch)
-{
-    for (int y = 0; y < height; y++)
-    {
-        const uint8_t *s = src + y * srcPitch;
-        uint8_t *d = dst + y * dstPitch;
-
-        for (int x = 0; x < width; x++)
-        {
-            int yv = s[x];
-            int val = yv + ((yv * g_yuv_luma) >> 3);
-
-            if (val < 0) val = 0;
-            else if (val > 255) val = 255;
-
-            d[x] = (uint8_t)val;
-        }
-    }
-}
-
 static SDL_Texture *vid_create_yuv_texture(int width, int height)
 {
     g_yuv_texture = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_YV12,
@@ -2192,87 +2343,113 @@ static SDL_Texture *vid_create_yuv_texture(int width, int height)
     return g_yuv_texture;
 }
 
+// Swaps the finished back buffer into the mailbox and carries on with whichever
+// buffer was there; if vid_blit() never took that one, it was dropped.
+static void vid_publish_yuv(int buf)
+{
+    int prev = g_yuv_surface->mailbox.exchange(buf | YUV_FRESH,
+                                               std::memory_order_acq_rel);
+    g_yuv_surface->back = prev & ~YUV_FRESH;
+
+    // a dropped frame may still be holding on to a vldp frame
+    vid_release_held_yuv(g_yuv_surface->back);
+
+    g_yuv_published.fetch_add(1, std::memory_order_relaxed);
+    if (prev & YUV_FRESH)
+        g_yuv_dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
 // REMEMBER it updates the YUV surface ONLY: the YUV texture is updated on vid_blit().
 int vid_update_yuv_overlay(uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane,
 	int Ypitch, int Upitch, int Vpitch)
 {
-    // This function is called from the vldp thread, so access to the
-    // yuv surface is protected (mutexed).
-    // As a reminder, mutexes are very simple: this fn tries to lock(=get)
-    // the mutex, but if it's already taken, LockMutex doesn't return
-    // until the mutex is free and we can lock(=get) it here.
+    // This function is called from the vldp thread, which is the only one
+    // that writes to the YUV surface.  It fills the back buffer and then
+    // publishes it to vid_blit() without ever waiting on the main thread.
 
-    SDL_LockMutex(g_yuv_surface->mutex);
+    int buf = g_yuv_surface->back;
 
     switch(g_yuv_display)
     {
     case YUV_BLANK:
-        vid_blank_yuv_surface();
+        vid_blank_yuv_surface(buf);
         break;
     case YUV_SHUTTER:
-        vid_blank_yuv_surface();
+        vid_blank_yuv_surface(buf);
         g_yuv_display = YUV_VISIBLE;
         break;
     case YUV_FLASH:
-        vid_flash_yuv_surface();
+        vid_flash_yuv_surface(buf);
         g_yuv_display = YUV_VISIBLE;
         break;
     default:
-        if (!g_yuv_flags)
-        {
-            copyPlane(g_yuv_surface->Yplane, Yplane,
-                g_yuv_surface->width, g_yuv_surface->height, Ypitch);
-            copyPlane(g_yuv_surface->Uplane, Uplane,
-                g_yuv_surface->width / 2, g_yuv_surface->height / 2, Upitch);
-            copyPlane(g_yuv_surface->Vplane, Vplane,
-                g_yuv_surface->width / 2, g_yuv_surface->height / 2, Vpitch);
-            break;
-        }
+    {
+        int w  = g_yuv_surface->width;
+        int h  = g_yuv_surface->height;
+        int cw = w >> 1;
+        int ch = h >> 1;
+
+        // blend and luma share a single pass over the Y plane
+        int luma = (g_yuv_flags & YUV_FLAG_LUMA) ? g_yuv_luma : 0;
 
         if (g_yuv_flags & YUV_FLAG_BLEND)
-        {
-            blendPlane(Yplane, g_yuv_surface->Yplane, g_yuv_surface->width,
-                g_yuv_surface->height, Ypitch, g_yuv_surface->Ypitch);
-        }
+            yuvkernel::blend_plane(g_yuv_surface->Yplane[buf], g_yuv_surface->Ypitch,
+                Yplane, Ypitch, w, h, luma);
         else
-        {
-            copyPlane(g_yuv_surface->Yplane, Yplane,
-                g_yuv_surface->width, g_yuv_surface->height, Ypitch);
-        }
+            yuvkernel::luma_plane(g_yuv_surface->Yplane[buf], g_yuv_surface->Ypitch,
+                Yplane, Ypitch, w, h, luma);
 
-        if (g_yuv_flags & YUV_FLAG_LUMA)
+        if (g_yuv_flags & YUV_FLAG_GRAYSCALE)
         {
-            lumaControl(Yplane, g_yuv_surface->Yplane, g_yuv_surface->width,
-                g_yuv_surface->height, Ypitch, g_yuv_surface->Ypitch);
+            memset(g_yuv_surface->Uplane[buf], 0x80, g_yuv_surface->Usize);
+            memset(g_yuv_surface->Vplane[buf], 0x80, g_yuv_surface->Vsize);
         }
-
-        if (g_yuv_flags & YUV_FLAG_GRAYSCALE)
+        else if (g_yuv_flags & YUV_FLAG_BLEND)
         {
-            memset(g_yuv_surface->Uplane, 0x80, g_yuv_surface->Usize);
-            memset(g_yuv_surface->Vplane, 0x80, g_yuv_surface->Vsize);
+            yuvkernel::blend_plane(g_yuv_surface->Uplane[buf], g_yuv_surface->Upitch,
+                Uplane, Upitch, cw, ch, 0);
+            yuvkernel::blend_plane(g_yuv_surface->Vplane[buf], g_yuv_surface->Vpitch,
+                Vplane, Vpitch, cw, ch, 0);
         }
         else
         {
-            int w = g_yuv_surface->width  >> 1;
-            int h = g_yuv_surface->height >> 1;
-            blendPlane(Uplane, g_yuv_surface->Uplane, w, h, Upitch, g_yuv_surface->Upitch);
-            blendPlane(Vplane, g_yuv_surface->Vplane, w, h, Vpitch, g_yuv_surface->Vpitch);
+            yuvkernel::copy_plane(g_yuv_surface->Uplane[buf], g_yuv_surface->Upitch,
+                Uplane, Upitch, cw, ch);
+            yuvkernel::copy_plane(g_yuv_surface->Vplane[buf], g_yuv_surface->Vpitch,
+                Vplane, Vpitch, cw, ch);
         }
         break;
     }
+    }
 
-    g_yuv_surface->Ypitch = g_yuv_surface->width;
-    g_yuv_surface->Upitch = g_yuv_surface->width / 2;
-    g_yuv_surface->Vpitch = g_yuv_surface->width / 2;
+    vid_publish_yuv(buf);
+
+    return 0;
+}
+
+int vid_hold_yuv_overlay(uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane,
+	int Ypitch, int Upitch, int Vpitch, void *ref, void (*release)(void *ref))
+{
+    // Anything that changes the picture needs a buffer of our own to do it in
+    if (g_yuv_display != YUV_VISIBLE || (g_yuv_flags &
+            (YUV_FLAG_BLEND | YUV_FLAG_GRAYSCALE | YUV_FLAG_LUMA)))
+    {
+        int result = vid_update_yuv_overlay(Yplane, Uplane, Vplane,
+                                            Ypitch, Upitch, Vpitch);
+        release(ref);
+        return result;
+    }
 
-    g_yuv_video_needs_update = true;
+    int buf = g_yuv_surface->back;
 
-    SDL_UnlockMutex(g_yuv_surface->mutex);
+    g_yuv_surface->held[buf] = (m_yuv_held_t){ref, release, Yplane, Uplane,
+                                              Vplane, Ypitch, Upitch, Vpitch};
+    vid_publish_yuv(buf);
 
     return 0;
 }
 
-void vid_update_overlay_surface(SDL_Surface *overlay)
+void vid_update_overlay_surface(SDL_Surface *overlay, const SDL_Rect *dirty)
 {
     if (VIDEO_HAS(BLOCK_DRIVER_OVERLAY))
         return;
@@ -2293,30 +2470,29 @@ void vid_update_overlay_surface(SDL_Surface *overlay)
     // else texture was updated in driver
     if (VIDEO_HAS(INDEX8))
     {
-        SDL_BlitSurface(overlay, NULL, g_overlay_surface, dst);
-        SDL_UpdateTexture(g_overlay_texture, &src,
-             (void *)g_overlay_surface->pixels, g_overlay_surface->pitch);
+        // Only the part the game reported is looked at, which is only safe
+        // if the last conversion was from an overlay of this size and place.
+        // Within that, palette::convert() skips the rows that didn't change.
+        int dx = dst ? dst->x : 0;
+        int dy = dst ? dst->y : 0;
+        SDL_Rect placed = {dx, dy, overlay->w, overlay->h};
+        SDL_Rect area = src, to;
+        bool fresh = !SDL_RectsEqual(&placed, &g_overlay_converted);
+
+        if (dirty && !fresh && !SDL_GetRectIntersection(dirty, &src, &area))
+            return;
+
+        to = palette::convert(overlay, area, g_overlay_surface, dx, dy, fresh);
+        g_overlay_converted = placed;
+
+        if (fresh) overlay_upload(src);
+        else if (SDL_GetRectIntersection(&to, &src, &to)) overlay_upload(to);
     }
 }
 
 static void take_screenshot()
 {
-    struct       stat info;
-    char         filename[64];
-    int32_t      screenshot_num = 0;
-    const char   dir[12] = "screenshots";
-
-    if (stat(dir, &info ) != 0 )
-    {
-         LOGW << fmt("'%s' directory does not exist.", dir);
-         return;
-    }
-    else if (!(info.st_mode & S_IFDIR))
-    {
-        LOGW << fmt("'%s' is not a directory.", dir);
-        return;
-    }
-    else if (g_display != 0)
+    if (g_display != 0)
     {
          LOGE << "Screenshots require the primary display.";
          return;
@@ -2333,90 +2509,142 @@ static void take_screenshot()
     {
         LOGE << fmt("Cannot ReadPixels - Something bad happened: %s", SDL_GetError());
         set_quitflag();
+        return;
     }
 
-    for (;;)
+    // the PNG is written by the screenshot thread
+    screenshot::queue(screenshot);
+}
+
+// Starts (re)drawing a cached layer: returns false when the layer is
+// already up to date with 'r' and 'key', otherwise leaves the renderer
+// pointed at a cleared, transparent texture of r.w x r.h
+static bool layer_begin(m_layerT *layer, const SDL_Rect &r, uint32_t key)
+{
+    if (layer->t && layer->key == key && SDL_RectsEqual(&layer->r, &r))
+        return false;
+
+    if (r.w <= 0 || r.h <= 0) return false;
+
+    if (!layer->t || layer->r.w != r.w || layer->r.h != r.h)
     {
-        screenshot_num++;
-        snprintf(filename, sizeof(filename), "%s%shypseus-%d.png",
-          dir, PATH_SEPARATOR, screenshot_num);
+        SDL_DestroyTexture(layer->t);
+        layer->t = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_RGBA32,
+            SDL_TEXTUREACCESS_TARGET, r.w, r.h);
 
-        if (!mpo_file_exists(filename))
-            break;
+        if (!layer->t)
+        {
+            LOGE << fmt("Layer texture creation failed: %s", SDL_GetError());
+            return false;
+        }
+
+        SDL_SetTextureBlendMode(layer->t, SDL_BLENDMODE_BLEND);
     }
 
-    if (IMG_SavePNG(screenshot, filename))
-        LOGI << fmt("Wrote screenshot: %s", filename);
-    else
-        LOGE <<  fmt("Could not write screenshot: %s !! - %s", filename, SDL_GetError());
+    layer->r = r;
+    layer->key = key;
+
+    layer->target = SDL_GetRenderTarget(g_renderer);
+    SDL_GetRenderDrawBlendMode(g_renderer, &layer->mode);
+
+    // write the draw color as is, so the alpha survives to the composite
+    SDL_SetRenderTarget(g_renderer, layer->t);
+    SDL_SetRenderDrawBlendMode(g_renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, SDL_ALPHA_TRANSPARENT);
+    SDL_RenderClear(g_renderer);
+
+    return true;
+}
 
-    SDL_DestroySurface(screenshot);
+static void layer_end(m_layerT *layer)
+{
+    SDL_SetRenderTarget(g_renderer, layer->target);
+    SDL_SetRenderDrawBlendMode(g_renderer, layer->mode);
+    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
 }
 
-static void draw_scanlines(int l)
+static void layer_render(m_layerT *layer)
 {
-    int xe = g_scaling_rect.x + g_scaling_rect.w;
-    int ye = g_scaling_rect.y + g_scaling_rect.h;
+    if (!layer->t) return;
 
-    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, g_scanline_alpha);
+    SDL_FRect frect;
+    SDL_RectToFRect(&layer->r, &frect);
+    SDL_RenderTexture(g_renderer, layer->t, NULL, &frect);
+}
 
-    if (g_aspect_ratio == ASPECTPD)
+static void draw_scanlines(int l)
+{
+    uint32_t key = (l & 0xff) | (g_scanline_alpha << 8) |
+                       ((g_aspect_ratio == ASPECTPD) << 16);
+
+    if (layer_begin(&g_scanline_layer, g_scaling_rect, key))
     {
-        for (int i = 0; i < g_scaling_rect.w; i += l)
+        int xe = g_scaling_rect.w;
+        int ye = g_scaling_rect.h;
+
+        SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, g_scanline_alpha);
+
+        if (g_aspect_ratio == ASPECTPD)
         {
-            int x = (int)(g_scaling_rect.x + i);
-            SDL_RenderLine(g_renderer, x, g_scaling_rect.y, x, ye);
+            for (int i = 0; i < g_scaling_rect.w; i += l)
+                SDL_RenderLine(g_renderer, i, 0, i, ye);
         }
-    }
-    else
-    {
-        for (int i = 0; i < g_scaling_rect.h; i += l)
+        else
         {
-            int y = (int)(g_scaling_rect.y + i);
-            SDL_RenderLine(g_renderer, g_scaling_rect.x, y, xe, y);
+            for (int i = 0; i < g_scaling_rect.h; i += l)
+                SDL_RenderLine(g_renderer, 0, i, xe, i);
         }
+
+        layer_end(&g_scanline_layer);
     }
 
-    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+    layer_render(&g_scanline_layer);
 }
 
 static void draw_border(int s, int c)
 {
-    SDL_FRect tb, lb, rb, bb;
-    unsigned char r = 0xff, g = 0xff, b = 0xff;
+    uint32_t key = (s & 0xffff) | ((c & 0xff) << 16);
 
-    switch(c)
+    if (layer_begin(&g_border_layer, g_border_rect, key))
     {
-       case 0x62:
-          r = 0x00; g = 0x66; b = 0xff;
-          break;
-       case 0x67:
-          r = 0x66; g = 0xff; b = 0x40;
-          break;
-       case 0x72:
-          r = 0xff; g = 0x1a; b = 0x1a;
-          break;
-       case 0x78:
-          r = 0x00; g = 0x00; b = 0x00;
-          break;
-    }
+        SDL_FRect tb, lb, rb, bb;
+        unsigned char r = 0xff, g = 0xff, b = 0xff;
+
+        switch(c)
+        {
+           case 0x62:
+              r = 0x00; g = 0x66; b = 0xff;
+              break;
+           case 0x67:
+              r = 0x66; g = 0xff; b = 0x40;
+              break;
+           case 0x72:
+              r = 0xff; g = 0x1a; b = 0x1a;
+              break;
+           case 0x78:
+              r = 0x00; g = 0x00; b = 0x00;
+              break;
+        }
 
-    SDL_SetRenderDrawColor(g_renderer, r, g, b, SDL_ALPHA_OPAQUE);
+        SDL_SetRenderDrawColor(g_renderer, r, g, b, SDL_ALPHA_OPAQUE);
 
-    tb.x = lb.x = bb.x = g_border_rect.x;
-    tb.y = lb.y = rb.y = g_border_rect.y;
-    rb.x = (g_border_rect.w + g_border_rect.x) - s;
-    bb.y = (g_border_rect.h - s) + g_border_rect.y;
-    tb.w = bb.w = g_border_rect.w;
-    tb.h = bb.h = lb.w = rb.w = s;
-    lb.h = rb.h = g_border_rect.h;
+        tb.x = lb.x = bb.x = 0;
+        tb.y = lb.y = rb.y = 0;
+        rb.x = g_border_rect.w - s;
+        bb.y = g_border_rect.h - s;
+        tb.w = bb.w = g_border_rect.w;
+        tb.h = bb.h = lb.w = rb.w = s;
+        lb.h = rb.h = g_border_rect.h;
 
-    SDL_RenderFillRect(g_renderer, &tb);
-    SDL_RenderFillRect(g_renderer, &lb);
-    SDL_RenderFillRect(g_renderer, &rb);
-    SDL_RenderFillRect(g_renderer, &bb);
+        SDL_RenderFillRect(g_renderer, &tb);
+        SDL_RenderFillRect(g_renderer, &lb);
+        SDL_RenderFillRect(g_renderer, &rb);
+        SDL_RenderFillRect(g_renderer, &bb);
 
-    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+        layer_end(&g_border_layer);
+    }
+
+    layer_render(&g_border_layer);
 }
 
 static bool mixTexture(m_textureT *mix)
@@ -2557,8 +2785,8 @@ void vid_blit()
     // need to protect the access to these surfaces or their needs_update booleans.
     // However, since we get here from game::blit(), the yuv "surface" is accessed
     // simultaneously from the vldp thread and from here, the main thread (to update
-    // the YUV texture from the YUV surface), so access to that surface and it's
-    // boolean DO need to be protected with a mutex.
+    // the YUV texture from the YUV surface), so the two only ever meet through
+    // its mailbox (see m_yuv_surface_t).
 
     // Handle any rescaling that occurred.
     switch(g_rescale)
@@ -2573,30 +2801,70 @@ void vid_blit()
        break;
     }
 
+    if (g_rescale)
+    {
+        layer_invalidate(&g_scanline_layer);
+        layer_invalidate(&g_border_layer);
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    // The frame is only composed on the mix texture when it has to be
+    // rotated as a whole, or to be captured, otherwise it goes straight to
+    // the backbuffer, clipped to what the mix texture would have shown.
+    bool mix = g_fRotateDegrees != 0 || VIDEO_HAS(TAKE_SCREENSHOT) ||
+                   VIDEO_HAS(MIX_TARGET);
+
     // Clear the renderer before the SDL_RenderTexture() calls for this frame.
     // Prevents stroboscopic effects on the background in fullscreen mode,
     // and is recommended by SDL_Rendercopy() documentation.
 
-    if (!mixTexture(&g_mix_texture)) return;
+    if (mix)
+    {
+        if (!mixTexture(&g_mix_texture)) return;
+
+        SDL_SetRenderTarget(g_renderer, g_mix_texture.t);
+        SDL_RenderClear(g_renderer);
+    }
+    else
+    {
+        SDL_Rect clip = {0, 0, g_logical_rect.w, g_logical_rect.h};
+        SDL_GetRectIntersection(&clip, &g_scaling_rect, &clip);
 
-    SDL_SetRenderTarget(g_renderer, g_mix_texture.t);
-    SDL_RenderClear(g_renderer);
+        SDL_RenderClear(g_renderer);
+        SDL_SetRenderClipRect(g_renderer, &clip);
+    }
 
     // Does YUV texture need update from the YUV surface
     if (g_yuv_surface)
     {
-        SDL_LockMutex(g_yuv_surface->mutex);
+        bool fresh = (g_yuv_surface->mailbox.load(std::memory_order_relaxed) & YUV_FRESH);
+        bool blank = g_yuv_blank_pending.exchange(false);
 
-        if (g_yuv_video_needs_update)
+        // take the newest complete frame, leaving our old one for the vldp
+        // thread to fill
+        if (fresh)
         {
+            // the texture already has our old frame, vldp can have it back
+            vid_release_held_yuv(g_yuv_surface->front);
+
+            int prev = g_yuv_surface->mailbox.exchange(g_yuv_surface->front,
+                                                       std::memory_order_acq_rel);
+            g_yuv_surface->front = prev & ~YUV_FRESH;
+        }
+        else if (g_yuv_published.load(std::memory_order_relaxed))
+            g_yuv_repeated++;
+
+        if (fresh || blank)
+        {
+            int buf = g_yuv_surface->front;
+
             if (!g_yuv_texture)
             {
                 g_yuv_texture = vid_create_yuv_texture(
                     g_yuv_surface->width, g_yuv_surface->height);
             }
 
-            g_yuv_video_needs_update = false;
-
             if (g_yuv_skip)
             {
                 if (g_yuv_display == YUV_VISIBLE)
@@ -2604,20 +2872,58 @@ void vid_blit()
 
                 vid_blank_yuv_texture();
             }
+            else if (blank) vid_blank_yuv_texture();
+            else if (g_yuv_surface->held[buf].ref)
+            {
+                const m_yuv_held_t *held = &g_yuv_surface->held[buf];
+
+                SDL_UpdateYUVTexture(g_yuv_texture, NULL,
+                    held->Y, held->Ypitch, held->U, held->Upitch,
+                    held->V, held->Vpitch);
+            }
             else SDL_UpdateYUVTexture(g_yuv_texture, NULL,
-                g_yuv_surface->Yplane, g_yuv_surface->Ypitch,
-                g_yuv_surface->Uplane, g_yuv_surface->Upitch,
-                g_yuv_surface->Vplane, g_yuv_surface->Vpitch);
-        }
+                g_yuv_surface->Yplane[buf], g_yuv_surface->Ypitch,
+                g_yuv_surface->Uplane[buf], g_yuv_surface->Upitch,
+                g_yuv_surface->Vplane[buf], g_yuv_surface->Vpitch);
 
-        SDL_UnlockMutex(g_yuv_surface->mutex);
+            g_yuv_shown_blank = g_yuv_skip || blank;
+        }
     }
 
     // Does OVERLAY texture need update from the local surfaces
-    if (VIDEO_HAS(BLOCK_DRIVER_OVERLAY))
+    if (VIDEO_HAS(BLOCK_DRIVER_OVERLAY) && !SDL_RectEmpty(&g_overlay_dirty))
     {
-        SDL_UpdateTexture(g_overlay_texture, &g_local_size_rect,
-	    (void *)g_overlay_surface->pixels, g_overlay_surface->pitch);
+        SDL_Rect r;
+
+        if (SDL_GetRectIntersection(&g_overlay_dirty, &g_local_size_rect, &r))
+            overlay_upload(r);
+
+        g_overlay_dirty = (SDL_Rect){0, 0, 0, 0};
+    }
+
+    // hand what is shown to the capture thread
+    if (g_yuv_surface && capture::is_armed())
+    {
+        int buf = g_yuv_surface->front;
+        bool overlay = capture::get_overlay() && g_overlay_texture;
+
+        const m_yuv_held_t *held = &g_yuv_surface->held[buf];
+
+        if (g_yuv_shown_blank)
+            capture::video_frame(NULL, NULL, NULL, 0, 0, 0,
+                g_yuv_surface->width, g_yuv_surface->height,
+                overlay ? g_overlay_surface : NULL, &g_limit_rect);
+        else if (held->ref)
+            capture::video_frame(held->Y, held->U, held->V,
+                held->Ypitch, held->Upitch, held->Vpitch,
+                g_yuv_surface->width, g_yuv_surface->height,
+                overlay ? g_overlay_surface : NULL, &g_limit_rect);
+        else
+            capture::video_frame(g_yuv_surface->Yplane[buf],
+                g_yuv_surface->Uplane[buf], g_yuv_surface->Vplane[buf],
+                g_yuv_surface->Ypitch, g_yuv_surface->Upitch, g_yuv_surface->Vpitch,
+                g_yuv_surface->width, g_yuv_surface->height,
+                overlay ? g_overlay_surface : NULL, &g_limit_rect);
     }
 
     SDL_RectToFRect(&g_scaling_rect, &fScaleRect);
@@ -2641,14 +2947,18 @@ void vid_blit()
         draw_border(g_game->get_outline_border(),
             g_game->get_outline_border_color());
 
-    SDL_SetRenderTarget(g_renderer, NULL);
-    SDL_RenderClear(g_renderer);
+    if (mix)
+    {
+        SDL_SetRenderTarget(g_renderer, NULL);
+        SDL_RenderClear(g_renderer);
 
-    if (g_fRotateDegrees != 0)
-        SDL_RenderTextureRotated(g_renderer, g_mix_texture.t,  &fScaleRect,
-             &fScaleRect, g_fRotateDegrees, NULL, SDL_FLIP_NONE);
-    else
-        SDL_RenderTexture(g_renderer, g_mix_texture.t, &fScaleRect,  &fScaleRect);
+        if (g_fRotateDegrees != 0)
+            SDL_RenderTextureRotated(g_renderer, g_mix_texture.t,  &fScaleRect,
+                 &fScaleRect, g_fRotateDegrees, NULL, SDL_FLIP_NONE);
+        else
+            SDL_RenderTexture(g_renderer, g_mix_texture.t, &fScaleRect,  &fScaleRect);
+    }
+    else SDL_SetRenderClipRect(g_renderer, NULL);
 
     // If there's a subtitle overlay
     if (g_bSubtitleShown)
@@ -2675,6 +2985,9 @@ void vid_blit()
     }
 
     g_rescale = 0;
+
+    g_blit_count++;
+    g_blit_ticks += SDL_GetPerformanceCounter() - start;
 }
 
 int get_yuv_overlay_width()
@@ -2689,12 +3002,34 @@ int get_yuv_overlay_height()
     return 0;
 }
 
+void get_yuv_mailbox_stats(uint32_t &published, uint32_t &dropped, uint32_t &repeated)
+{
+    published = g_yuv_published;
+    dropped   = g_yuv_dropped;
+    repeated  = g_yuv_repeated;
+}
+
+void get_blit_timing(uint32_t &blits, double &ms, bool reset)
+{
+    blits = g_blit_count;
+    ms = blits ? ((double)g_blit_ticks * 1000.0) /
+             ((double)SDL_GetPerformanceFrequency() * blits) : 0.0;
+
+    if (reset)
+    {
+        g_blit_count = 0;
+        g_blit_ticks = 0;
+    }
+}
+
 bool get_yuv_overlay_ready()
 {
     if (g_yuv_surface && g_yuv_texture) return true;
     return false;
 }
 
+void set_overlay_dirty(const SDL_Rect *rect) { overlay_dirty(rect); }
+
 void set_overlay_offset(int offsetx, int offsety)
 {
     g_limit_rect.x = offsetx;
@@ -2706,10 +3041,10 @@ void notify_stats(int overlaywidth, int overlayheight, const char* input)
     char s[4] = {0};
     if (!VIDEO_HAS(OVERLAY_DYNAMIC)) snprintf(s, sizeof(s), "[s]");
 
-    LOGI << fmt("Viewport Stats:|w:%dx%d|v:%dx%d|o:%dx%d%s|l:%dx%d|%s",
+    LOGI << fmt("Viewport Stats:|w:%dx%d|v:%dx%d|o:%dx%d%s|l:%dx%d|u:%uKB/s|%s",
          g_viewport_width, g_viewport_height, g_probe_width,
            g_probe_height, overlaywidth, overlayheight, s,
-             g_logical_rect.w, g_logical_rect.h, input);
+             g_logical_rect.w, g_logical_rect.h, overlay_upload_rate(), input);
 }
 
 
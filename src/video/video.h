@@ -108,6 +108,17 @@ enum
     B_EMPTY
 }; // bitmaps
 
+// get_text() slots
+static const uint8_t SRT_LINES = 16;
+enum
+{
+    TEXT_SUBTITLE,
+    TEXT_SRT,
+    TEXT_PARSE_FILE = TEXT_SRT + SRT_LINES,
+    TEXT_PARSE_STATUS,
+    TEXT_SLOTS
+};
+
 enum
 {
     YUV_BLANK = 0,
@@ -167,6 +178,7 @@ enum VideoState : uint64_t
     KMSDRM               = 1ull << 33,
     SCALED               = 1ull << 34,
     VERTICAL_ORIENTATION = 1ull << 35,
+    MIX_TARGET           = 1ull << 36,
 };
 
 bool init_display();
@@ -175,10 +187,15 @@ bool deinit_display();
 void vid_setup_yuv_overlay (int width, int height);
 // MAC : REMEMBER, vid_update_yuv_overlay() ONLY updates the YUV surface. The YUV texture is updated on vid_blit()
 int vid_update_yuv_overlay (uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane, int Ypitch, int Upitch, int Vpitch);
+// Same, but when the picture goes up unchanged the planes are uploaded in place
+// and 'ref' is handed to release() once vid_blit() is done with them (or right
+// away if they were copied after all).
+int vid_hold_yuv_overlay (uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane, int Ypitch, int Upitch, int Vpitch, void *ref, void (*release)(void *ref));
 int vid_update_yuv_texture (uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane, int Ypitch, int Upitch, int Vpitch);
 void vid_free_yuv_overlay ();
 
-void vid_update_overlay_surface(SDL_Surface *tx);
+// 'dirty' is the part of the game overlay that changed, NULL for all of it
+void vid_update_overlay_surface(SDL_Surface *tx, const SDL_Rect *dirty);
 void vid_blit();
 // MAC: sdl_video_run thread block ends here
 
@@ -247,6 +264,10 @@ Uint16 get_viewport_height();
 Uint16 get_video_height();
 void set_video_width(Uint16);
 void set_video_height(Uint16);
+// the TTF_Text for 's' in 'slot', only laid out again when the string or font
+// changes; the renderer text engine keeps the glyphs in an atlas texture, so
+// drawing an unchanged string is a single batch of quads
+TTF_Text *get_text(int slot, TTF_Font *font, const char *s);
 void draw_srt(const char*, uint8_t, int);
 void draw_subtitle(const char *, uint8_t, bool);
 void vid_toggle_fullscreen();
@@ -288,6 +309,8 @@ bool draw_annunciator(int which);
 bool get_bezelstatus();
 
 void set_queue_screenshot(bool bEnabled);
+// always compose frames on the intermediate mix texture (benchmark)
+void set_mix_target(bool bEnabled);
 
 unsigned int get_logical_width();
 unsigned int get_logical_height();
@@ -304,6 +327,9 @@ int get_scoreboard_bezel_scale();
 int get_aux_bezel_scale();
 
 void set_overlay_offset(int, int);
+// marks part of the screen LED surface (get_screen_leds) as changed, NULL for
+// all of it; the LED and LDP1450 drawing routines do this themselves
+void set_overlay_dirty(const SDL_Rect *rect);
 int get_yuv_overlay_width();
 int get_yuv_overlay_height();
 void reset_yuv_overlay();
@@ -312,6 +338,11 @@ void notify_stats(int width, int height, const char*);
 void notify_positions();
 
 bool get_yuv_overlay_ready();
+// frames handed over by the vldp thread, frames it replaced before vid_blit()
+// took them, and blits that found no new frame
+void get_yuv_mailbox_stats(uint32_t &published, uint32_t &dropped, uint32_t &repeated);
+// blits and their average cost in ms since the last reset
+void get_blit_timing(uint32_t &blits, double &ms, bool reset);
 
 }
 #endif
@@ -0,0 +1,425 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 DirtBagXon
+ *
+ * This file is part of HYPSEUS, a laserdisc arcade game emulator
+ *
+ * HYPSEUS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "config.h"
+#include "../io/conout.h"
+#include "yuvkernel.h"
+#include <SDL3/SDL.h>
+#include <plog/Log.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define YUVKERNEL_SSE2
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define YUVKERNEL_AVX2
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define YUVKERNEL_NEON
+#endif
+
+namespace yuvkernel
+{
+
+// (l0 + l1 + l2 + 1) / 3 is done as (sum * 341) >> 10, the vector versions
+// use a 16 bit high multiply by 341 << 6 which gives the same result
+#define BLEND_MUL     341U
+#define BLEND_MUL_HI  (BLEND_MUL << 6)
+
+typedef void (*blend_row_t)(uint8_t *, const uint8_t *, const uint8_t *,
+                            const uint8_t *, int, int);
+typedef void (*luma_row_t)(uint8_t *, const uint8_t *, int, int);
+
+struct kernels {
+    const char *name;
+    blend_row_t blend_row;
+    luma_row_t luma_row;
+};
+
+static inline uint8_t clamp_luma(int yv, int luma)
+{
+    int val = yv + ((yv * luma) >> 3);
+
+    if (val < 0) val = 0;
+    else if (val > 255) val = 255;
+
+    return (uint8_t)val;
+}
+
+// the scalar versions also finish off whatever the vector loops leave over,
+// starting from column 'x'
+static inline void blend_tail(uint8_t *d, const uint8_t *l0, const uint8_t *l1,
+                              const uint8_t *l2, int x, int w, int luma)
+{
+    for (; x < w; ++x) {
+        int yv = (int)(((uint32_t)l0[x] + l1[x] + l2[x] + 1U) * BLEND_MUL >> 10);
+        d[x] = luma ? clamp_luma(yv, luma) : (uint8_t)yv;
+    }
+}
+
+static inline void luma_tail(uint8_t *d, const uint8_t *s, int x, int w, int luma)
+{
+    for (; x < w; ++x)
+        d[x] = clamp_luma(s[x], luma);
+}
+
+static void blend_row_c(uint8_t *d, const uint8_t *l0, const uint8_t *l1,
+                        const uint8_t *l2, int w, int luma)
+{
+    blend_tail(d, l0, l1, l2, 0, w, luma);
+}
+
+static void luma_row_c(uint8_t *d, const uint8_t *s, int w, int luma)
+{
+    luma_tail(d, s, 0, w, luma);
+}
+
+#ifdef YUVKERNEL_SSE2
+static void blend_row_sse2(uint8_t *d, const uint8_t *l0, const uint8_t *l1,
+                           const uint8_t *l2, int w, int luma)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one  = _mm_set1_epi16(1);
+    const __m128i mul  = _mm_set1_epi16((short)BLEND_MUL_HI);
+    const __m128i lv   = _mm_set1_epi16((short)luma);
+    int x = 0;
+
+    for (; x + 16 <= w; x += 16) {
+        __m128i a  = _mm_loadu_si128((const __m128i *)(l0 + x));
+        __m128i b  = _mm_loadu_si128((const __m128i *)(l1 + x));
+        __m128i c  = _mm_loadu_si128((const __m128i *)(l2 + x));
+        __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                                 _mm_unpacklo_epi8(b, zero)),
+                                   _mm_add_epi16(_mm_unpacklo_epi8(c, zero), one));
+        __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                                 _mm_unpackhi_epi8(b, zero)),
+                                   _mm_add_epi16(_mm_unpackhi_epi8(c, zero), one));
+        lo = _mm_mulhi_epu16(lo, mul);
+        hi = _mm_mulhi_epu16(hi, mul);
+        if (luma) {
+            lo = _mm_add_epi16(lo, _mm_srai_epi16(_mm_mullo_epi16(lo, lv), 3));
+            hi = _mm_add_epi16(hi, _mm_srai_epi16(_mm_mullo_epi16(hi, lv), 3));
+        }
+        _mm_storeu_si128((__m128i *)(d + x), _mm_packus_epi16(lo, hi));
+    }
+    blend_tail(d, l0, l1, l2, x, w, luma);
+}
+
+static void luma_row_sse2(uint8_t *d, const uint8_t *s, int w, int luma)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lv   = _mm_set1_epi16((short)luma);
+    int x = 0;
+
+    for (; x + 16 <= w; x += 16) {
+        __m128i a  = _mm_loadu_si128((const __m128i *)(s + x));
+        __m128i lo = _mm_unpacklo_epi8(a, zero);
+        __m128i hi = _mm_unpackhi_epi8(a, zero);
+        lo = _mm_add_epi16(lo, _mm_srai_epi16(_mm_mullo_epi16(lo, lv), 3));
+        hi = _mm_add_epi16(hi, _mm_srai_epi16(_mm_mullo_epi16(hi, lv), 3));
+        _mm_storeu_si128((__m128i *)(d + x), _mm_packus_epi16(lo, hi));
+    }
+    luma_tail(d, s, x, w, luma);
+}
+#endif
+
+#ifdef YUVKERNEL_AVX2
+// unpack and pack both work within 128 bit lanes, so the bytes come back out
+// in the order they went in
+__attribute__((target("avx2")))
+static void blend_row_avx2(uint8_t *d, const uint8_t *l0, const uint8_t *l1,
+                           const uint8_t *l2, int w, int luma)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one  = _mm256_set1_epi16(1);
+    const __m256i mul  = _mm256_set1_epi16((short)BLEND_MUL_HI);
+    const __m256i lv   = _mm256_set1_epi16((short)luma);
+    int x = 0;
+
+    for (; x + 32 <= w; x += 32) {
+        __m256i a  = _mm256_loadu_si256((const __m256i *)(l0 + x));
+        __m256i b  = _mm256_loadu_si256((const __m256i *)(l1 + x));
+        __m256i c  = _mm256_loadu_si256((const __m256i *)(l2 + x));
+        __m256i lo = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpacklo_epi8(a, zero),
+                                                       _mm256_unpacklo_epi8(b, zero)),
+                                      _mm256_add_epi16(_mm256_unpacklo_epi8(c, zero), one));
+        __m256i hi = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpackhi_epi8(a, zero),
+                                                       _mm256_unpackhi_epi8(b, zero)),
+                                      _mm256_add_epi16(_mm256_unpackhi_epi8(c, zero), one));
+        lo = _mm256_mulhi_epu16(lo, mul);
+        hi = _mm256_mulhi_epu16(hi, mul);
+        if (luma) {
+            lo = _mm256_add_epi16(lo, _mm256_srai_epi16(_mm256_mullo_epi16(lo, lv), 3));
+            hi = _mm256_add_epi16(hi, _mm256_srai_epi16(_mm256_mullo_epi16(hi, lv), 3));
+        }
+        _mm256_storeu_si256((__m256i *)(d + x), _mm256_packus_epi16(lo, hi));
+    }
+    blend_tail(d, l0, l1, l2, x, w, luma);
+}
+
+__attribute__((target("avx2")))
+static void luma_row_avx2(uint8_t *d, const uint8_t *s, int w, int luma)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i lv   = _mm256_set1_epi16((short)luma);
+    int x = 0;
+
+    for (; x + 32 <= w; x += 32) {
+        __m256i a  = _mm256_loadu_si256((const __m256i *)(s + x));
+        __m256i lo = _mm256_unpacklo_epi8(a, zero);
+        __m256i hi = _mm256_unpackhi_epi8(a, zero);
+        lo = _mm256_add_epi16(lo, _mm256_srai_epi16(_mm256_mullo_epi16(lo, lv), 3));
+        hi = _mm256_add_epi16(hi, _mm256_srai_epi16(_mm256_mullo_epi16(hi, lv), 3));
+        _mm256_storeu_si256((__m256i *)(d + x), _mm256_packus_epi16(lo, hi));
+    }
+    luma_tail(d, s, x, w, luma);
+}
+#endif
+
+#ifdef YUVKERNEL_NEON
+static inline uint16x8_t blend_half_neon(uint8x8_t a, uint8x8_t b, uint8x8_t c)
+{
+    uint16x8_t sum = vaddq_u16(vaddw_u8(vaddl_u8(a, b), c), vdupq_n_u16(1));
+    uint32x4_t p0  = vmull_n_u16(vget_low_u16(sum), BLEND_MUL);
+    uint32x4_t p1  = vmull_n_u16(vget_high_u16(sum), BLEND_MUL);
+    return vcombine_u16(vshrn_n_u32(p0, 10), vshrn_n_u32(p1, 10));
+}
+
+static inline uint8x8_t luma_half_neon(uint16x8_t v, int16_t luma)
+{
+    int16x8_t s = vreinterpretq_s16_u16(v);
+    s = vaddq_s16(s, vshrq_n_s16(vmulq_n_s16(s, luma), 3));
+    return vqmovun_s16(s);
+}
+
+static void blend_row_neon(uint8_t *d, const uint8_t *l0, const uint8_t *l1,
+                           const uint8_t *l2, int w, int luma)
+{
+    int x = 0;
+
+    for (; x + 16 <= w; x += 16) {
+        uint8x16_t a  = vld1q_u8(l0 + x);
+        uint8x16_t b  = vld1q_u8(l1 + x);
+        uint8x16_t c  = vld1q_u8(l2 + x);
+        uint16x8_t lo = blend_half_neon(vget_low_u8(a), vget_low_u8(b), vget_low_u8(c));
+        uint16x8_t hi = blend_half_neon(vget_high_u8(a), vget_high_u8(b), vget_high_u8(c));
+        if (luma)
+            vst1q_u8(d + x, vcombine_u8(luma_half_neon(lo, (int16_t)luma),
+                                        luma_half_neon(hi, (int16_t)luma)));
+        else
+            vst1q_u8(d + x, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+    }
+    blend_tail(d, l0, l1, l2, x, w, luma);
+}
+
+static void luma_row_neon(uint8_t *d, const uint8_t *s, int w, int luma)
+{
+    int x = 0;
+
+    for (; x + 16 <= w; x += 16) {
+        uint8x16_t a = vld1q_u8(s + x);
+        vst1q_u8(d + x, vcombine_u8(luma_half_neon(vmovl_u8(vget_low_u8(a)), (int16_t)luma),
+                                    luma_half_neon(vmovl_u8(vget_high_u8(a)), (int16_t)luma)));
+    }
+    luma_tail(d, s, x, w, luma);
+}
+#endif
+
+static const kernels g_kernels_c = { "c", blend_row_c, luma_row_c };
+
+static kernels select_kernels()
+{
+#ifdef YUVKERNEL_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        kernels k = { "avx2", blend_row_avx2, luma_row_avx2 };
+        return k;
+    }
+#endif
+#if defined(YUVKERNEL_SSE2)
+    kernels k = { "sse2", blend_row_sse2, luma_row_sse2 };
+    return k;
+#elif defined(YUVKERNEL_NEON)
+    kernels k = { "neon", blend_row_neon, luma_row_neon };
+    return k;
+#else
+    return g_kernels_c;
+#endif
+}
+
+static const kernels &get_kernels()
+{
+    static const kernels k = select_kernels();
+    return k;
+}
+
+static void do_blend_plane(const kernels &k, uint8_t *dst, int dstPitch,
+                           const uint8_t *src, int srcPitch, int w, int h, int luma)
+{
+    for (int y = 0; y < h; ++y) {
+        const uint8_t *line0 = src + (size_t)(y > 0 ? y - 1 : y) * srcPitch;
+        const uint8_t *line1 = src + (size_t)y * srcPitch;
+        const uint8_t *line2 = src + (size_t)(y < h - 1 ? y + 1 : y) * srcPitch;
+
+        k.blend_row(dst + (size_t)y * dstPitch, line0, line1, line2, w, luma);
+    }
+}
+
+static void do_luma_plane(const kernels &k, uint8_t *dst, int dstPitch,
+                          const uint8_t *src, int srcPitch, int w, int h, int luma)
+{
+    for (int y = 0; y < h; ++y)
+        k.luma_row(dst + (size_t)y * dstPitch, src + (size_t)y * srcPitch, w, luma);
+}
+
+void copy_plane(uint8_t *dst, int dstPitch, const uint8_t *src, int srcPitch,
+                int w, int h)
+{
+    // memcpy is already vectorized by the C library, and one big copy beats
+    // a row at a time when neither side is padded
+    if (srcPitch == w && dstPitch == w) {
+        memcpy(dst, src, (size_t)w * h);
+    } else {
+        for (int y = 0; y < h; ++y)
+            memcpy(dst + (size_t)y * dstPitch, src + (size_t)y * srcPitch, w);
+    }
+}
+
+void blend_plane(uint8_t *dst, int dstPitch, const uint8_t *src, int srcPitch,
+                 int w, int h, int luma)
+{
+    do_blend_plane(get_kernels(), dst, dstPitch, src, srcPitch, w, h, luma);
+}
+
+void luma_plane(uint8_t *dst, int dstPitch, const uint8_t *src, int srcPitch,
+                int w, int h, int luma)
+{
+    if (!luma) {
+        copy_plane(dst, dstPitch, src, srcPitch, w, h);
+        return;
+    }
+    do_luma_plane(get_kernels(), dst, dstPitch, src, srcPitch, w, h, luma);
+}
+
+const char *get_isa_name()
+{
+    return get_kernels().name;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Microbenchmark
+
+enum { BENCH_COPY, BENCH_BLEND, BENCH_LUMA, BENCH_BLEND_LUMA, BENCH_COUNT };
+
+static const char *g_bench_names[BENCH_COUNT] = { "copy", "blend", "luma", "blend+luma" };
+
+#define BENCH_FRAMES 120
+#define BENCH_LUMA_LEVEL 3
+
+// one displayed frame worth of work, the same as vid_update_yuv_overlay does
+static void bench_frame(const kernels &k, int mode, uint8_t *dst, const uint8_t *src,
+                        int w, int h)
+{
+    int cw = w >> 1, ch = h >> 1;
+    size_t ysize = (size_t)w * h, csize = (size_t)cw * ch;
+
+    for (int p = 0; p < 3; p++) {
+        const uint8_t *s = src + (p ? ysize + (p - 1) * csize : 0);
+        uint8_t *d       = dst + (p ? ysize + (p - 1) * csize : 0);
+        int pw = p ? cw : w, ph = p ? ch : h;
+
+        switch (mode) {
+        case BENCH_BLEND:
+            do_blend_plane(k, d, pw, s, pw, pw, ph, 0);
+            break;
+        case BENCH_LUMA:
+            if (p) copy_plane(d, pw, s, pw, pw, ph);
+            else do_luma_plane(k, d, pw, s, pw, pw, ph, BENCH_LUMA_LEVEL);
+            break;
+        case BENCH_BLEND_LUMA:
+            do_blend_plane(k, d, pw, s, pw, pw, ph, p ? 0 : BENCH_LUMA_LEVEL);
+            break;
+        default:
+            copy_plane(d, pw, s, pw, pw, ph);
+            break;
+        }
+    }
+}
+
+static double bench_run(const kernels &k, int mode, uint8_t *dst, const uint8_t *src,
+                        int w, int h)
+{
+    bench_frame(k, mode, dst, src, w, h); // warm the caches
+
+    Uint64 start = SDL_GetTicksNS();
+    for (int i = 0; i < BENCH_FRAMES; i++)
+        bench_frame(k, mode, dst, src, w, h);
+
+    return (double)(SDL_GetTicksNS() - start) / (1000.0 * BENCH_FRAMES);
+}
+
+void benchmark()
+{
+    static const int sizes[][2] = { { 720, 480 }, { 1920, 1080 } };
+    const kernels &k = get_kernels();
+
+    for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        int w = sizes[i][0], h = sizes[i][1];
+        size_t size = (size_t)w * h * 3 / 2;
+        uint8_t *src = (uint8_t *)malloc(size);
+        uint8_t *ref = (uint8_t *)malloc(size);
+        uint8_t *dst = (uint8_t *)malloc(size);
+
+        if (!src || !ref || !dst) {
+            LOGW << "yuvkernel benchmark: out of memory";
+            free(src); free(ref); free(dst);
+            return;
+        }
+
+        Uint32 seed = 0x12345678;
+        for (size_t n = 0; n < size; n++) {
+            seed   = seed * 1103515245 + 12345;
+            src[n] = (uint8_t)(seed >> 16);
+        }
+
+        for (int mode = 0; mode < BENCH_COUNT; mode++) {
+            double c_us    = bench_run(g_kernels_c, mode, ref, src, w, h);
+            double simd_us = bench_run(k, mode, dst, src, w, h);
+
+            LOGI << fmt("yuvkernel %dx%d %-10s c: %8.1f us/frame, %s: %8.1f us/frame (%.2fx)%s",
+                        w, h, g_bench_names[mode], c_us, k.name, simd_us,
+                        simd_us > 0 ? c_us / simd_us : 0.0,
+                        memcmp(ref, dst, size) ? " MISMATCH" : "");
+        }
+
+        free(src);
+        free(ref);
+        free(dst);
+    }
+}
+
+}
@@ -0,0 +1,55 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 DirtBagXon
+ *
+ * This file is part of HYPSEUS, a laserdisc arcade game emulator
+ *
+ * HYPSEUS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Per-plane kernels used to post-process the decoded mpeg picture before it
+// is handed to the YUV texture (-blend, luma and grayscale).
+
+#ifndef YUVKERNEL_H
+#define YUVKERNEL_H
+
+#include <stdint.h>
+
+namespace yuvkernel
+{
+// straight copy of a w x h plane
+void copy_plane(uint8_t *dst, int dstPitch, const uint8_t *src, int srcPitch,
+                int w, int h);
+
+// 3-tap vertical blend of a w x h plane, with the luma adjustment applied to
+// the blended result in the same pass when 'luma' is non-zero
+// (val = yv + ((yv * luma) >> 3), clamped)
+void blend_plane(uint8_t *dst, int dstPitch, const uint8_t *src, int srcPitch,
+                 int w, int h, int luma);
+
+// luma adjustment only
+void luma_plane(uint8_t *dst, int dstPitch, const uint8_t *src, int srcPitch,
+                int w, int h, int luma);
+
+// which implementation the dispatcher picked ("avx2", "sse2", "neon" or "c")
+const char *get_isa_name();
+
+// times the scalar and the dispatched kernels on 720x480 and 1920x1080
+// frames and logs the per frame cost
+void benchmark();
+}
+
+#endif // YUVKERNEL_H
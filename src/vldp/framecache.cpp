@@ -0,0 +1,160 @@
+/*
+ * ____ VLDP COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2001 Matt Ownby
+ *
+ * This file is part of VLDP, a virtual laserdisc player.
+ *
+ * VLDP is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * VLDP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// LRU cache of decoded still frames (see framecache.h)
+
+#include <stdlib.h>
+#include <string.h>
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "framecache.h"
+
+namespace framecache
+{
+struct entry {
+    uint32_t uFile;
+    uint32_t uFrame;
+    uint64_t uBytes; // size of the planes buffer
+    frame f;         // f.Y is the start of the single planes allocation
+};
+
+typedef std::list<entry> lru_list; // most recently used at the front
+typedef std::pair<uint32_t, uint32_t> frame_key;
+
+static lru_list g_lru;
+static std::map<frame_key, lru_list::iterator> g_index;
+static std::map<std::string, uint32_t> g_file_ids; // mpeg name -> file id
+
+static uint64_t g_uBudget  = 0;
+static uint64_t g_uUsed    = 0;
+static uint32_t g_uCurFile = 0;
+static uint32_t g_uHits    = 0;
+static uint32_t g_uMisses  = 0;
+
+// frees the least recently used frame
+static void evict_one()
+{
+    entry &e = g_lru.back();
+    g_index.erase(frame_key(e.uFile, e.uFrame));
+    g_uUsed -= e.uBytes;
+    free(e.f.Y);
+    g_lru.pop_back();
+}
+
+void set_budget(uint64_t uBytes)
+{
+    g_uBudget = uBytes;
+    while (!g_lru.empty() && (g_uUsed > g_uBudget)) {
+        evict_one();
+    }
+}
+
+void set_file(const char *cpszFilename)
+{
+    std::map<std::string, uint32_t>::iterator mi = g_file_ids.find(cpszFilename);
+
+    if (mi != g_file_ids.end()) {
+        g_uCurFile = mi->second;
+    } else {
+        g_uCurFile = (uint32_t)g_file_ids.size();
+        g_file_ids[cpszFilename] = g_uCurFile;
+    }
+}
+
+const frame *lookup(uint32_t uFrame)
+{
+    const frame *result = NULL;
+
+    if (g_uBudget > 0) {
+        std::map<frame_key, lru_list::iterator>::iterator mi =
+            g_index.find(frame_key(g_uCurFile, uFrame));
+
+        if (mi != g_index.end()) {
+            // move to the front of the LRU list (iterators stay valid)
+            g_lru.splice(g_lru.begin(), g_lru, mi->second);
+            result = &mi->second->f;
+            ++g_uHits;
+        } else {
+            ++g_uMisses;
+        }
+    }
+
+    return result;
+}
+
+void store(uint32_t uFrame, const uint8_t *Y, const uint8_t *U, const uint8_t *V,
+           int width, int height, int chroma_width, int chroma_height)
+{
+    uint64_t uYSize  = (uint64_t)width * height;
+    uint64_t uUVSize = (uint64_t)chroma_width * chroma_height;
+    uint64_t uBytes  = uYSize + (uUVSize << 1);
+    frame_key key(g_uCurFile, uFrame);
+
+    // a frame that doesn't fit the budget on its own is never cached
+    if ((uBytes == 0) || (uBytes > g_uBudget)) return;
+
+    // already have it (can happen if a search was interrupted before the
+    // frame was shown)
+    if (g_index.find(key) != g_index.end()) return;
+
+    while (!g_lru.empty() && (g_uUsed + uBytes > g_uBudget)) {
+        evict_one();
+    }
+
+    uint8_t *ptrBuf = (uint8_t *)malloc((size_t)uBytes);
+    if (!ptrBuf) return; // not fatal, the search just won't be cached
+
+    entry e;
+    e.uFile           = g_uCurFile;
+    e.uFrame          = uFrame;
+    e.uBytes          = uBytes;
+    e.f.Y             = ptrBuf;
+    e.f.U             = ptrBuf + uYSize;
+    e.f.V             = e.f.U + uUVSize;
+    e.f.width         = width;
+    e.f.height        = height;
+    e.f.chroma_width  = chroma_width;
+    e.f.chroma_height = chroma_height;
+
+    memcpy(e.f.Y, Y, (size_t)uYSize);
+    memcpy(e.f.U, U, (size_t)uUVSize);
+    memcpy(e.f.V, V, (size_t)uUVSize);
+
+    g_lru.push_front(e);
+    g_index[key] = g_lru.begin();
+    g_uUsed += uBytes;
+}
+
+void clear()
+{
+    while (!g_lru.empty()) {
+        evict_one();
+    }
+}
+
+uint32_t get_hits() { return g_uHits; }
+
+uint32_t get_misses() { return g_uMisses; }
+}
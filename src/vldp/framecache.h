@@ -0,0 +1,65 @@
+/*
+ * ____ VLDP COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2001 Matt Ownby
+ *
+ * This file is part of VLDP, a virtual laserdisc player.
+ *
+ * VLDP is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * VLDP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// LRU cache of decoded still frames, so that repeated searches to the same
+// frame (death scenes, attract mode) don't have to seek and decode again.
+// Should only be used by the vldp private thread!
+
+#ifndef VLDP_FRAMECACHE_H
+#define VLDP_FRAMECACHE_H
+
+#include <stdint.h>
+
+namespace framecache
+{
+struct frame {
+    uint8_t *Y;
+    uint8_t *U;
+    uint8_t *V;
+    int width;        // luma pitch (and width)
+    int height;
+    int chroma_width; // chroma pitch (and width)
+    int chroma_height;
+};
+
+// sets the memory budget (in bytes), evicting frames if needed. 0 disables
+void set_budget(uint64_t uBytes);
+
+// selects which mpeg the following frame numbers refer to
+void set_file(const char *cpszFilename);
+
+// returns the cached frame for 'uFrame' of the current file, or NULL on a miss
+const frame *lookup(uint32_t uFrame);
+
+// copies a decoded frame into the cache, evicting the least recently used
+// frames to stay within the budget
+void store(uint32_t uFrame, const uint8_t *Y, const uint8_t *U, const uint8_t *V,
+           int width, int height, int chroma_width, int chroma_height);
+
+// frees every cached frame (the budget and counters are kept)
+void clear();
+
+uint32_t get_hits();
+uint32_t get_misses();
+}
+
+#endif // VLDP_FRAMECACHE_H
@@ -60,13 +60,29 @@ Sample mpeg2 byte sequence: 00 00 01 B5 25 06 06 06 0B 42 0F 00
 
 #include <stdio.h>
 #include <stdlib.h> // for malloc
+#include <string.h>
+#include <atomic>
+#include <vector>
 #include "mpegscan.h"
 #include "vldp_internal.h"
 
-#ifdef VLDP_DEBUG
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MPEGSCAN_SSE2
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define MPEGSCAN_AVX2
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MPEGSCAN_NEON
+#endif
+
 #include "../io/conout.h"
 #include <plog/Log.h>
-#endif
 
 namespace mpegscan
 {
@@ -184,26 +200,17 @@ void add_to_last_three(unsigned char val, uint64_t pos)
     }
 }
 
-// parses from file stream, length # of bytes
-// writes results to the open datafile
+// parses the 'bytes_read' bytes of 'buf', which were read as a chunk of
+// 'length' bytes (so fewer means EOF), writes results to the open datafile
 // returns stat codes
-int parse(FILE *datafile, unsigned int length)
+static int parse_buffer(FILE *datafile, const unsigned char *buf, size_t bytes_read,
+                        unsigned int length)
 {
     int result               = IN_PROGRESS;
     int ch                   = 0;
     uint64_t start_pos       = g_filepos;
     const int64_t minus_one  = -1;
     unsigned int buf_index   = 0;
-    size_t bytes_read        = 0;
-    unsigned char *buf       = (unsigned char *)malloc(length); // allocate a chunk of
-                                                          // memory to read in
-                                                          // file
-
-    if (!buf) {
-        return ERROR;
-    }
-
-    bytes_read = io_read(buf, length); // read in a chunk
 
     // parse this chunk of video
     while ((unsigned int)(g_filepos - start_pos) < length) {
@@ -367,8 +374,608 @@ int parse(FILE *datafile, unsigned int length)
 
     } // end while we're not done with video stream
 
-    free(buf); // de-allocate buffer
+    return result;
+}
+
+// parses from file stream, length # of bytes
+// writes results to the open datafile
+// returns stat codes
+int parse(FILE *datafile, unsigned int length)
+{
+    int result         = ERROR;
+    unsigned char *buf = (unsigned char *)malloc(length); // allocate a chunk of
+                                                          // memory to read in
+                                                          // file
+
+    if (buf) {
+        size_t bytes_read = io_read(buf, length); // read in a chunk
+        result = parse_buffer(datafile, buf, bytes_read, length);
+        free(buf); // de-allocate buffer
+    }
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Start code search
+
+static const unsigned char *find_start_code_scalar(const unsigned char *p,
+                                                   const unsigned char *end)
+{
+    // we only need to look at every third byte until we find a zero, since
+    // any start code prefix must contain a zero at one of them
+    while (p + 2 < end) {
+        if (p[2] > 1) {
+            p += 3;
+        } else if (p[2] == 1) {
+            if ((p[1] == 0) && (p[0] == 0)) return p;
+            p += 3;
+        } else {
+            p++;
+        }
+    }
+    return end;
+}
+
+#ifdef MPEGSCAN_SSE2
+static const unsigned char *find_start_code_sse2(const unsigned char *p,
+                                                 const unsigned char *end)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one  = _mm_set1_epi8(1);
+
+    // compare 16 candidate positions at once, each block needs 2 bytes of
+    // look ahead for the rest of the prefix
+    while (p + 18 <= end) {
+        __m128i b0 = _mm_loadu_si128((const __m128i *)p);
+        __m128i b1 = _mm_loadu_si128((const __m128i *)(p + 1));
+        __m128i b2 = _mm_loadu_si128((const __m128i *)(p + 2));
+        __m128i m  = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, zero),
+                                                 _mm_cmpeq_epi8(b1, zero)),
+                                   _mm_cmpeq_epi8(b2, one));
+        int mask   = _mm_movemask_epi8(m);
+        if (mask) {
+            int i = 0;
+            while (!(mask & 1)) {
+                mask >>= 1;
+                i++;
+            }
+            return p + i;
+        }
+        p += 16;
+    }
+    return find_start_code_scalar(p, end);
+}
+#endif
+
+#ifdef MPEGSCAN_AVX2
+__attribute__((target("avx2")))
+static const unsigned char *find_start_code_avx2(const unsigned char *p,
+                                                 const unsigned char *end)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one  = _mm256_set1_epi8(1);
+
+    while (p + 34 <= end) {
+        __m256i b0 = _mm256_loadu_si256((const __m256i *)p);
+        __m256i b1 = _mm256_loadu_si256((const __m256i *)(p + 1));
+        __m256i b2 = _mm256_loadu_si256((const __m256i *)(p + 2));
+        __m256i m  = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(b0, zero),
+                                                       _mm256_cmpeq_epi8(b1, zero)),
+                                      _mm256_cmpeq_epi8(b2, one));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(m);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return find_start_code_scalar(p, end);
+}
+#endif
+
+#ifdef MPEGSCAN_NEON
+static const unsigned char *find_start_code_neon(const unsigned char *p,
+                                                 const unsigned char *end)
+{
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one  = vdupq_n_u8(1);
+
+    while (p + 18 <= end) {
+        uint8x16_t m = vandq_u8(vandq_u8(vceqq_u8(vld1q_u8(p), zero),
+                                         vceqq_u8(vld1q_u8(p + 1), zero)),
+                                vceqq_u8(vld1q_u8(p + 2), one));
+#ifdef __aarch64__
+        if (vmaxvq_u8(m)) {
+#else
+        uint8x8_t h = vorr_u8(vget_low_u8(m), vget_high_u8(m));
+        if (vget_lane_u64(vreinterpret_u64_u8(h), 0)) {
+#endif
+            // there is a match in this block, let the scalar code pin it down
+            return find_start_code_scalar(p, p + 18);
+        }
+        p += 16;
+    }
+    return find_start_code_scalar(p, end);
+}
+#endif
+
+typedef const unsigned char *(*find_func_t)(const unsigned char *, const unsigned char *);
+
+static find_func_t select_find_start_code()
+{
+#ifdef MPEGSCAN_AVX2
+    if (__builtin_cpu_supports("avx2")) return find_start_code_avx2;
+#endif
+#if defined(MPEGSCAN_SSE2)
+    return find_start_code_sse2;
+#elif defined(MPEGSCAN_NEON)
+    return find_start_code_neon;
+#else
+    return find_start_code_scalar;
+#endif
+}
+
+const unsigned char *find_start_code(const unsigned char *p, const unsigned char *end)
+{
+    static const find_func_t func = select_find_start_code();
+    return func(p, end);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Parallel parser
+
+#define SCAN_CHUNK 1048576        // how much each worker reads in at a time
+#define SCAN_LOOKAHEAD 8          // bytes needed past a prefix to decode it
+#define SCAN_MIN_RANGE 16777216   // don't bother splitting smaller than this
+#define SCAN_MAX_WORKERS 16
+#define SCAN_GOP_WINDOW 4194304   // how far we look for a GOP to split at
+
+struct scan_range {
+    const char *filename;
+    uint64_t start;   // first start code prefix this worker owns
+    uint64_t end;     // first start code prefix the next worker owns
+    uint64_t length;  // length of the whole file
+    uint64_t chunk;   // how much to read in at a time
+    std::vector<uint64_t> frames; // .DAT entries in file order
+    int fields_detected;
+    int frames_detected;
+    int ok;
+    std::atomic<uint64_t> *progress;    // bytes parsed by all workers
+    std::atomic<unsigned int> *finished; // workers that have returned
+};
+
+static FILE *scan_open(const char *filename, uint64_t pos)
+{
+    FILE *F = fopen(filename, "rb");
+
+    if (F) {
+#if defined(_FILE_OFFSET_BITS) && _FILE_OFFSET_BITS == 64
+        int res = fseeko64(F, pos, SEEK_SET);
+#elif defined(__WIN32)
+        int res = _fseeki64(F, pos, SEEK_SET);
+#else
+        int res = fseek(F, pos, SEEK_SET);
+#endif
+        if (res != 0) {
+            fclose(F);
+            F = NULL;
+        }
+    }
+    return F;
+}
+
+// Handles the header whose type byte lives at 'code' (absolute position).
+// 'p' points at that byte, and 'avail' is how many bytes are valid from 'p'.
+// This mirrors the state machine in parse(), which will not look for a new
+// header until it has consumed the bytes of a picture header (2 bytes) or
+// extension header (3 bytes). 'allowed' tracks that.
+static void scan_header(scan_range *r, const unsigned char *p, uint64_t avail,
+                        uint64_t code, uint64_t header_pos, uint64_t &allowed)
+{
+    const uint64_t minus_one = (uint64_t)-1;
+
+    if (code < allowed) return;
+
+    switch (p[0]) {
+    case 0: // video frame
+        allowed = code + 3;
+        if (avail > 2) {
+            unsigned int type = (((p[1] << 8) | p[2]) >> 3) & 3;
+            r->frames.push_back((type == 1) ? header_pos : minus_one);
+        }
+        break;
+    case 0xB5: // extension header
+        allowed = code + 4;
+        if ((avail > 3) && ((p[1] >> 4) == 8)) {
+            unsigned char u8Val = p[3] & 3;
+            if ((u8Val == 1) || (u8Val == 2)) {
+                r->fields_detected = 1;
+            } else if (u8Val == 3) {
+                r->frames_detected = 1;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static int scan_worker(void *data)
+{
+    scan_range *r = (scan_range *)data;
+    uint64_t pos     = r->start;
+    uint64_t allowed = r->start;
+    unsigned char *buf = (unsigned char *)malloc((size_t)r->chunk + SCAN_LOOKAHEAD);
+    FILE *F = scan_open(r->filename, pos);
+
+    if (!buf || !F) {
+        free(buf);
+        if (F) fclose(F);
+        r->finished->fetch_add(1);
+        return 0;
+    }
+
+    while (pos < r->end) {
+        uint64_t chunk_end = pos + r->chunk;
+        if (chunk_end > r->end) chunk_end = r->end;
+
+        uint64_t want = chunk_end - pos + SCAN_LOOKAHEAD;
+        if (want > r->length - pos) want = r->length - pos;
+
+        if (fread(buf, 1, (size_t)want, F) != want) {
+            break;
+        }
+
+        // the parse() state machine starts out as if it had already read
+        // three zeros, so a stream starting with 01 or 00 01 gets a header
+        if (pos == 0) {
+            if ((want > 1) && (buf[0] == 1)) {
+                scan_header(r, buf + 1, want - 1, 1, 0, allowed);
+            } else if ((want > 2) && (buf[0] == 0) && (buf[1] == 1)) {
+                scan_header(r, buf + 2, want - 2, 2, 0, allowed);
+            }
+        }
+
+        // we only own prefixes starting before chunk_end, the rest of the
+        // buffer is just look ahead
+        const unsigned char *scan_end = buf + (chunk_end - pos) + 2;
+        if (scan_end > buf + want) scan_end = buf + want;
+
+        const unsigned char *p = buf;
+        for (;;) {
+            p = find_start_code(p, scan_end);
+            if (p >= scan_end) break;
+
+            uint64_t off = p - buf;
+            if (off + 3 < want) {
+                scan_header(r, p + 3, want - off - 3, pos + off + 3, pos + off, allowed);
+            }
+            p++;
+        }
+
+        r->progress->fetch_add(chunk_end - pos);
+        pos = chunk_end;
+
+        // we read past the end of the chunk for look ahead, so rewind
+#if defined(_FILE_OFFSET_BITS) && _FILE_OFFSET_BITS == 64
+        fseeko64(F, pos, SEEK_SET);
+#elif defined(__WIN32)
+        _fseeki64(F, pos, SEEK_SET);
+#else
+        fseek(F, pos, SEEK_SET);
+#endif
+    }
+
+    r->ok = (pos >= r->end);
+
+    fclose(F);
+    free(buf);
+    r->finished->fetch_add(1);
+    return 0;
+}
+
+// finds the first GOP start code at or after 'pos', returns 0 if none could
+// be found nearby
+static uint64_t scan_find_gop(const char *filename, uint64_t pos, uint64_t length)
+{
+    uint64_t result = 0;
+    uint64_t want   = SCAN_GOP_WINDOW;
+    FILE *F         = NULL;
+
+    if (pos >= length) return 0;
+    if (want > length - pos) want = length - pos;
+
+    F = scan_open(filename, pos);
+    if (F) {
+        unsigned char *buf = (unsigned char *)malloc((size_t)want);
+        if (buf && (fread(buf, 1, (size_t)want, F) == want)) {
+            const unsigned char *end = buf + want;
+            const unsigned char *p   = buf;
+            for (;;) {
+                p = find_start_code(p, end);
+                if (p + 3 >= end) break;
+                if (p[3] == 0xB8) {
+                    result = pos + (p - buf);
+                    break;
+                }
+                p++;
+            }
+        }
+        free(buf);
+        fclose(F);
+    }
+    return result;
+}
+
+// parse_parallel() with the number of workers and the size they read in at a
+// time chosen by the caller
+static int parse_ranges(const char *mpegfile, uint64_t length, FILE *datafile,
+                        void (*report)(double), unsigned int workers, uint64_t chunk)
+{
+    int result = ERROR;
+    std::atomic<uint64_t> progress(0);
+    std::atomic<unsigned int> finished(0);
+    std::vector<uint64_t> splits;
+    unsigned int i       = 0;
+
+    // Split the stream at GOP boundaries. Any start code prefix is a safe
+    // place to split: the bytes following 00 00 01 B8 can't belong to a
+    // header the previous worker is still in the middle of.
+    splits.push_back(0);
+    for (i = 1; i < workers; i++) {
+        uint64_t gop = scan_find_gop(mpegfile, (length / workers) * i, length);
+        if (gop > splits.back()) splits.push_back(gop);
+    }
+    splits.push_back(length);
+
+    std::vector<scan_range> ranges(splits.size() - 1);
+    std::vector<SDL_Thread *> threads(ranges.size(), (SDL_Thread *)NULL);
+
+    for (i = 0; i < ranges.size(); i++) {
+        ranges[i].filename        = mpegfile;
+        ranges[i].start           = splits[i];
+        ranges[i].end             = splits[i + 1];
+        ranges[i].length          = length;
+        ranges[i].chunk           = chunk;
+        ranges[i].fields_detected = 0;
+        ranges[i].frames_detected = 0;
+        ranges[i].ok              = 0;
+        ranges[i].progress        = &progress;
+        ranges[i].finished        = &finished;
+    }
+
+    for (i = 0; i < ranges.size(); i++) {
+        threads[i] = SDL_CreateThread(scan_worker, "mpegscan", &ranges[i]);
+        if (!threads[i]) scan_worker(&ranges[i]);
+    }
+
+    // keep the user informed while the pool does the work
+    while (report && (finished.load() < ranges.size())) {
+        if (report) report((double)progress.load() / length);
+        SDL_Delay(100);
+    }
+
+    for (i = 0; i < ranges.size(); i++) {
+        if (threads[i]) SDL_WaitThread(threads[i], NULL);
+    }
+
+    // merge everything back together in file order
+    int fields_detected = 0;
+    int frames_detected = 0;
+    bool ok = true;
+
+    for (i = 0; i < ranges.size(); i++) {
+        ok = ok && ranges[i].ok;
+        fields_detected |= ranges[i].fields_detected;
+        frames_detected |= ranges[i].frames_detected;
+    }
+
+    if (ok) {
+        for (i = 0; i < ranges.size(); i++) {
+            std::vector<uint64_t> &f = ranges[i].frames;
+            if (!f.empty() && (fwrite(f.data(), sizeof(uint64_t), f.size(), datafile) != f.size())) {
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    if (ok) {
+        // same rules as parse() applies at EOF
+        if (fields_detected && !frames_detected) {
+            result = FINISHED_FIELDS;
+        } else if (!fields_detected) {
+            result = FINISHED_FRAMES;
+        }
+    }
 
     return result;
 }
+
+int parse_parallel(const char *mpegfile, uint64_t length, FILE *datafile,
+                   void (*report)(double))
+{
+    unsigned int workers = SDL_GetNumLogicalCPUCores();
+
+    if (workers > SCAN_MAX_WORKERS) workers = SCAN_MAX_WORKERS;
+    if (workers > length / SCAN_MIN_RANGE) workers = (unsigned int)(length / SCAN_MIN_RANGE);
+    if (workers < 1) workers = 1;
+
+    return parse_ranges(mpegfile, length, datafile, report, workers, SCAN_CHUNK);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Self check
+
+#define CHECK_GOPS 48
+
+// builds a small stream out of sequence, GOP, picture, extension and slice
+// headers separated by filler of every length from 0 up, so that start codes
+// land on every alignment relative to the 16 and 32 byte SIMD blocks.  The
+// filler is full of zeros but never forms a start code prefix by itself.
+static void check_build_stream(std::vector<unsigned char> &s)
+{
+    static const unsigned char seq[]     = {0, 0, 1, 0xB3, 0x2D, 0x00, 0xF0, 0x34,
+                                            0xFF, 0xFF, 0xE0, 0x18};
+    static const unsigned char seq_ext[] = {0, 0, 1, 0xB5, 0x14, 0x8A, 0x00, 0x01,
+                                            0x00, 0x00};
+    uint32_t seed = 12345;
+    unsigned int filler = 0;
+
+    s.insert(s.end(), seq, seq + sizeof(seq));
+    s.insert(s.end(), seq_ext, seq_ext + sizeof(seq_ext));
+
+    for (unsigned int gop = 0; gop < CHECK_GOPS; gop++) {
+        const unsigned char gop_hdr[] = {0, 0, 1, 0xB8, 0x00, 0x08, 0x00, 0x40};
+        s.insert(s.end(), gop_hdr, gop_hdr + sizeof(gop_hdr));
+
+        for (unsigned int pic = 0; pic < 6; pic++) {
+            // I, then P and B pictures (the type is bits 3-5 of the 2nd byte)
+            unsigned char type = (pic == 0) ? 1 : ((pic % 3) == 1) ? 2 : 3;
+            const unsigned char pic_hdr[] = {0, 0, 1, 0x00, (unsigned char)(pic << 6),
+                                             (unsigned char)(type << 3)};
+            const unsigned char pic_ext[] = {0, 0, 1, 0xB5, 0x83, 0x4F, 0xF3, 0x59,
+                                             0x80};
+            const unsigned char slice[]   = {0, 0, 1, 0x01, 0x13};
+
+            s.insert(s.end(), pic_hdr, pic_hdr + sizeof(pic_hdr));
+            s.insert(s.end(), pic_ext, pic_ext + sizeof(pic_ext));
+            s.insert(s.end(), slice, slice + sizeof(slice));
+
+            for (unsigned int i = 0; i < filler; i++) {
+                seed = (seed * 1103515245) + 12345;
+                unsigned char b = ((seed >> 16) % 3) ? 0 : (unsigned char)(seed >> 24);
+                size_t n = s.size();
+
+                // 00 00 01 would be a start code
+                if ((b == 1) && (s[n - 1] == 0) && (s[n - 2] == 0)) b = 2;
+                s.push_back(b);
+            }
+            filler = (filler + 7) % 71;
+        }
+    }
+}
+
+// checks 'func' against a byte at a time search, from every position of 's'
+// to the end and to a short distance past it (so that prefixes are also cut
+// off by 'end' and every block tail length comes up)
+static bool check_find_start_code(find_func_t func, const std::vector<unsigned char> &s)
+{
+    const unsigned char *buf = s.data();
+    size_t n = s.size();
+
+    for (size_t start = 0; start < n; start++) {
+        size_t ends[2] = {n, start + (start % 67)};
+
+        for (unsigned int e = 0; e < 2; e++) {
+            const unsigned char *end = buf + ((ends[e] < n) ? ends[e] : n);
+            const unsigned char *expect = end;
+
+            for (const unsigned char *p = buf + start; p + 2 < end; p++) {
+                if ((p[0] == 0) && (p[1] == 0) && (p[2] == 1)) {
+                    expect = p;
+                    break;
+                }
+            }
+
+            if (func(buf + start, end) != expect) return false;
+        }
+    }
+    return true;
+}
+
+// reads the whole of a temporary file into 'v'
+static void check_read_back(FILE *F, std::vector<unsigned char> &v)
+{
+    unsigned char tmp[4096];
+    size_t n;
+
+    rewind(F);
+    while ((n = fread(tmp, 1, sizeof(tmp), F)) > 0) {
+        v.insert(v.end(), tmp, tmp + n);
+    }
+}
+
+bool self_check(const char *tmpfilename)
+{
+    std::vector<unsigned char> s;
+    std::vector<unsigned char> serial;
+    bool ok = true;
+    int serial_result = IN_PROGRESS;
+
+    check_build_stream(s);
+
+    // every scanner that can run here against the plain one
+    ok = ok && check_find_start_code(find_start_code_scalar, s);
+#ifdef MPEGSCAN_SSE2
+    ok = ok && check_find_start_code(find_start_code_sse2, s);
+#endif
+#ifdef MPEGSCAN_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        ok = ok && check_find_start_code(find_start_code_avx2, s);
+    }
+#endif
+#ifdef MPEGSCAN_NEON
+    ok = ok && check_find_start_code(find_start_code_neon, s);
+#endif
+    if (!ok) {
+        LOGE << "mpegscan: start code scanners disagree";
+        return false;
+    }
+
+    // the serial parser, fed in chunks that don't line up with anything
+    FILE *F = tmpfile();
+    if (!F) return false;
+
+    init();
+    for (size_t pos = 0; serial_result == IN_PROGRESS; pos += 97) {
+        size_t avail = (pos < s.size()) ? s.size() - pos : 0;
+        serial_result = parse_buffer(F, s.data() + pos, (avail < 97) ? avail : 97, 97);
+    }
+    check_read_back(F, serial);
+    fclose(F);
+
+    // it should have found every picture
+    if ((serial_result != FINISHED_FRAMES) || (serial.size() != CHECK_GOPS * 6 * 8)) {
+        LOGE << "mpegscan: serial parser failed its self check";
+        return false;
+    }
+
+    F = fopen(tmpfilename, "wb");
+    if (!F) {
+        LOGE << fmt("mpegscan: could not create %s for the self check", tmpfilename);
+        return false;
+    }
+    ok = (fwrite(s.data(), 1, s.size(), F) == s.size());
+    if (fclose(F) != 0) ok = false;
+
+    // the parallel parser, split at different GOPs and reading in chunks small
+    // enough that headers are cut off by them
+    static const uint64_t chunks[] = {5, 64, 97, SCAN_CHUNK};
+    for (unsigned int workers = 1; ok && (workers <= 5); workers++) {
+        for (unsigned int c = 0; ok && (c < sizeof(chunks) / sizeof(chunks[0])); c++) {
+            std::vector<unsigned char> parallel;
+            int result = ERROR;
+
+            F = tmpfile();
+            if (!F) {
+                ok = false;
+                break;
+            }
+            result = parse_ranges(tmpfilename, s.size(), F, NULL, workers, chunks[c]);
+            check_read_back(F, parallel);
+            fclose(F);
+
+            if ((result != serial_result) || (parallel != serial)) {
+                LOGE << fmt("mpegscan: parallel parser (%u workers, %u byte chunks) "
+                            "disagrees with the serial one",
+                            workers, (unsigned int)chunks[c]);
+                ok = false;
+            }
+        }
+    }
+
+    remove(tmpfilename);
+    return ok;
+}
 }
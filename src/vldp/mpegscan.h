@@ -26,4 +26,22 @@ enum { ERROR, IN_PROGRESS, FINISHED_FRAMES, FINISHED_FIELDS };
 
 void init();
 int parse(FILE *datafile, unsigned int length);
+
+// returns a pointer to the first 00 00 01 start code prefix found between
+// 'p' and 'end', or 'end' if there is none
+const unsigned char *find_start_code(const unsigned char *p, const unsigned char *end);
+
+// parses the whole of 'mpegfile' (which is 'length' bytes long) on a pool of
+// worker threads, split at GOP boundaries, and writes the same frame entries
+// to 'datafile' that the serial parse() would have written.
+// 'report' (may be NULL) receives progress updates between 0 and 1.
+// Returns one of the FINISHED_ codes, or ERROR.
+int parse_parallel(const char *mpegfile, uint64_t length, FILE *datafile,
+                   void (*report)(double));
+
+// Checks the SIMD start code scanners against the scalar one, and
+// parse_parallel() against parse() with several splits and read sizes, on a
+// small made-up stream that is written to 'tmpfilename' (and removed again).
+// Returns false, after logging why, if any of them disagree.
+bool self_check(const char *tmpfilename);
 }
@@ -26,6 +26,7 @@
 #include <string.h>
 #include "vldp.h"
 #include "vldp_common.h"
+#include "vldp_internal.h"
 
 #ifdef VLDP_DEBUG
 #include "../io/conout.h"
@@ -149,6 +150,7 @@ void vldp_shutdown()
         vldp_cmd(VLDP_REQ_QUIT);
         SDL_WaitThread(private_thread, NULL); // wait for private thread to
                                               // terminate
+        ivldp_index_shutdown();
     }
     p_initialized = 0;
 }
@@ -353,6 +355,26 @@ VLDP_BOOL vldp_unlock(unsigned int uTimeoutMs)
     return result;
 }
 
+unsigned int vldp_load_indexes(const char **filenames, unsigned int uCount)
+{
+    unsigned int result = 0;
+
+    if (p_initialized) {
+        result = ivldp_load_indexes(filenames, uCount);
+    }
+    return result;
+}
+
+VLDP_BOOL vldp_get_file_info(const char *filename, struct vldp_file_info *info)
+{
+    VLDP_BOOL result = VLDP_FALSE;
+
+    if (p_initialized) {
+        result = ivldp_get_file_info(filename, info);
+    }
+    return result;
+}
+
 // This comes at the end so I can avoid putting function declarations in vldp.h
 // I want to keep these functions hidden and force the user to use the callbacks
 const struct vldp_out_info *vldp_init(const struct vldp_in_info *in_info)
@@ -378,6 +400,11 @@ const struct vldp_out_info *vldp_init(const struct vldp_in_info *in_info)
     g_out_info.speedchange      = vldp_speedchange;
     g_out_info.lock             = vldp_lock;
     g_out_info.unlock           = vldp_unlock;
+    g_out_info.load_indexes     = vldp_load_indexes;
+    g_out_info.get_file_info    = vldp_get_file_info;
+    g_out_info.release_frame    = ivldp_release_frame;
+
+    ivldp_index_init();
 
     private_thread = SDL_CreateThread(idle_handler, "vldp", (void *)NULL); // start our internal
                                                            // thread
@@ -386,6 +413,8 @@ const struct vldp_out_info *vldp_init(const struct vldp_in_info *in_info)
     if (private_thread) {
         p_initialized = 1;
         result        = &g_out_info;
+    } else {
+        ivldp_index_shutdown();
     }
 
     return result;
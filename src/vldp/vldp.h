@@ -51,6 +51,15 @@ struct yuv_buf {
 // since this is C and not C++, we can't use booleans ...
 enum { VLDP_FALSE = 0, VLDP_TRUE = 1 } typedef VLDP_BOOL;
 
+// stream information VLDP keeps resident for each mpeg it has indexed
+struct vldp_file_info {
+    Uint32 w;               // width of the mpeg video
+    Uint32 h;               // height of the mpeg video
+    unsigned int uFpks;     // frames per kilosecond
+    Uint8 uses_fields;      // whether the video uses fields or not
+    uint32_t uTotalFrames;  // number of frames (or fields) in the index
+};
+
 // callback functions and state information provided to VLDP from the parent
 // thread
 struct vldp_in_info {
@@ -64,6 +73,12 @@ struct vldp_in_info {
     // This returns 1 if the frame was prepared successfully, or 0 on error
     int (*prepare_frame)(uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane, int Ypitch, int Upitch, int Vpitch);
 
+    // Optional, used instead of prepare_frame for frames that VLDP can lend
+    // out by reference.  The planes stay valid until 'ref' is handed to
+    // release_frame, which must happen exactly once for every call (right
+    // away if the planes were copied).
+    int (*prepare_held_frame)(uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane, int Ypitch, int Upitch, int Vpitch, void *ref);
+
     // VLDP calls this when it wants the frame that was earlier prepared to be
     // displayed
     // ASAP
@@ -96,6 +111,9 @@ struct vldp_in_info {
     // this function instead)
     unsigned int (*GetTicksFunc)();
     const char *Uid;
+
+    // memory budget (in megabytes) for caching decoded search frames (0 = off)
+    unsigned int uFrameCacheMB;
 };
 
 // functions and state information provided to the parent thread from VLDP
@@ -183,6 +201,21 @@ struct vldp_out_info {
     // or false if we timed out.
     VLDP_BOOL (*unlock)(unsigned int uTimeoutMs);
 
+    // Loads the frame indexes of the given mpegs into memory (in parallel),
+    // so that opening them later doesn't have to read their .DAT files.
+    // Files whose .DAT is missing or outdated are skipped; they get parsed
+    // when they are opened, as before.
+    // Blocks until done and returns how many indexes were loaded.
+    unsigned int (*load_indexes)(const char **filenames, unsigned int uCount);
+
+    // Fills in 'info' for an mpeg whose index has been loaded.
+    // Returns VLDP_FALSE if the index isn't resident.
+    VLDP_BOOL (*get_file_info)(const char *filename, struct vldp_file_info *info);
+
+    // Gives back a frame that was lent out through prepare_held_frame.
+    // Safe to call from any thread.
+    void (*release_frame)(void *ref);
+
     ////////////////////////////////////////////////////////////
 
     // State information for the parent thread's benefit
@@ -197,6 +230,8 @@ struct vldp_out_info {
                                 // are on
     unsigned int uLastCachedIndex; // the index of the file that was last
                                    // precached (if any)
+    uint32_t uFrameCacheHits;   // searches served from the decoded frame cache
+    uint32_t uFrameCacheMisses; // searches that had to seek and decode
 
 };
 
@@ -25,15 +25,25 @@
 #include <stdio.h>
 #include <stdlib.h> // for malloc/free
 #include <string.h>
+#include <assert.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 //#include <unistd.h>
+#if !defined(WIN32) && !defined(__WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#define VLDP_MMAP
+#else
+#include <windows.h> // for MoveFileEx
+#endif
 //#include "inttypesreplace.h"
 #include <SDL3/SDL.h>
 
 #include "vldp_internal.h"
 #include "vldp_common.h"
 #include "mpegscan.h"
+#include "framecache.h"
 #include "../video/video.h"
 #include "../io/conout.h"
 
@@ -41,7 +51,12 @@
 
 #include <inttypes.h>
 
+#include <atomic>
+#include <map>
+#include <string>
+
 #include <mpeg2.h>
+#include <zlib.h>
 
 #ifdef VLDP_DEBUG
 #define FRAMELOG "frame_report.txt"
@@ -57,7 +72,7 @@ int s_step_forward   = 0; // whether to step 1 frame forward
 int s_blanked        = 0; // whether the mpeg video is to be blanked
 int s_frames_to_skip = 0; // how many frames to skip before rendering the next
                           // frame (used for P and B frames seeking)
-int s_frames_to_skip_with_inc = 0; // // how many frames to skip while
+int s_frames_to_skip_with_inc = 0; // how many frames to skip while
                                    // increasing the frame number (for
                                    // multi-speed playback)
 int s_skip_all = 0; // if we are to skip any frame to be displayed (to avoid
@@ -99,21 +114,122 @@ struct precache_entry_s s_sPreCacheEntries[MAX_PRECACHE_FILES]; // struct array
                                                                 // holding
                                                                 // precache data
 
-#define MAX_LDP_FRAMES 512000
-
 static FILE *g_mpeg_handle     = NULL; // mpeg file we currently have open
+
+// when io_open() manages to map the file, it is read from here instead of
+// g_mpeg_handle and the page cache does the job of the old buffered reads
+static VLDP_BOOL s_bMapEnabled = VLDP_FALSE;
+static struct precache_entry_s s_sMapEntry;
+
+// how far ahead of a seek target we ask the kernel to fault in
+#define SEARCH_READAHEAD 1048576
+
+// the part of s_sMapEntry that the last search took out of sequential
+// read-ahead (see io_advise_willneed)
+static uint64_t s_uRandomStart = 0;
+static uint64_t s_uRandomLen   = 0;
+
+// when a search misses the frame cache, the first frame drawn afterwards
+// (the one we searched to) is stored in the cache under this frame number
+static VLDP_BOOL s_bCacheCapture = VLDP_FALSE;
+static uint32_t s_uCacheCaptureFrame = 0;
+
 static mpeg2dec_t *g_mpeg_data = NULL; // structure for libmpeg2's state
-static uint64_t g_frame_position[MAX_LDP_FRAMES] = {0}; // the file position of
-                                                      // each I frame
+static const struct file_index_s *g_cur_index = NULL; // frame index of the
+                                                     // current mpeg
 static Uint32 g_totalframes = 0; // total # of frames in the current mpeg
 
 #define BUFFER_SIZE 262144
 static Uint8 g_buffer[BUFFER_SIZE]; // buffer to hold mpeg2 file as we read it
                                     // in
 
+// Decoding runs on its own thread so that a slow frame doesn't eat into the
+// time the private thread spends waiting to show the next one.  Finished
+// pictures are passed through this ring; the private thread still does all of
+// the timing and command handling.  The decoder thread only touches
+// g_mpeg_data and the io_* layer while a render is in progress, the rest of
+// the time (opens, searches, rewinds) they belong to the private thread.
+#define VLDP_FRAME_RING 4
+static struct vldp_frame_s g_frame_ring[VLDP_FRAME_RING];
+static unsigned int g_uRingHead  = 0; // oldest frame in the ring
+static unsigned int g_uRingCount = 0; // how many frames are in the ring
+
+// libmpeg2 decodes straight into these (its custom fbuf mode) so that a
+// finished picture goes into the ring by reference rather than being copied.
+// A buffer is free once libmpeg2 has given up the frame slot it was in and no
+// ring entry points at it.  libmpeg2 has three slots, the ring can point at
+// VLDP_FRAME_RING other buffers, the parent thread can hold on to
+// VLDP_FBUF_HELD more that it is showing in place (see prepare_held_frame,
+// anything past that is copied), and one more is taken before the slot it
+// goes into lets go of its old one, so the pool can never run dry.
+#define VLDP_FBUF_SLOTS 3
+#define VLDP_FBUF_HELD  2
+#define VLDP_FBUF_POOL  10
+SDL_COMPILE_TIME_ASSERT(vldp_fbuf_pool,
+                        VLDP_FBUF_POOL == VLDP_FRAME_RING + VLDP_FBUF_SLOTS + VLDP_FBUF_HELD + 1);
+struct vldp_fbuf_s {
+    Uint8 *buf;             // Y, U and V planes (allocated by mpeg2_malloc)
+    size_t uBufSize;        // size of buf
+    VLDP_BOOL bDecoder;     // libmpeg2 has it in one of its frame slots
+    unsigned int uQueued;   // how many ring entries (or parent thread holds)
+                            // point at it
+};
+static struct vldp_fbuf_s g_fbuf_pool[VLDP_FBUF_POOL];
+static const mpeg2_fbuf_t *g_fbuf_slot[VLDP_FBUF_SLOTS];  // libmpeg2's slots
+static struct vldp_fbuf_s *g_fbuf_slot_buf[VLDP_FBUF_SLOTS]; // and what's in them
+static unsigned int g_uFbufHeld = 0; // how many the parent thread is holding
+
+enum { DECODE_IDLE, DECODE_RUN, DECODE_QUIT };
+static int g_decode_state           = DECODE_IDLE;
+static VLDP_BOOL g_bDecodeAbort     = VLDP_FALSE; // throw away what's left of the
+                                                  // current chunk and go idle
+static VLDP_BOOL g_bDecodeFailed    = VLDP_FALSE; // libmpeg2 couldn't be given a
+                                                  // frame buffer
+static SDL_Thread *g_decode_thread  = NULL;
+static SDL_Mutex *g_decode_mutex    = NULL;
+static SDL_Condition *g_decode_cond = NULL;
+
+// the decoder thread's guess at which frames are going to be thrown away (see
+// ivldp_frame_fate); the anchor and skip count are set by draw_frame()
+enum { FRAME_SHOW, FRAME_LEAD_SKIP, FRAME_DROP };
+static uint32_t g_uDecodeOutputs  = 0; // frames output since the render began
+static uint32_t g_uDecodeLeadSkip = 0; // s_frames_to_skip when it began
+static uint32_t g_uDecodeAnchor   = 0; // last frame draw_frame() counted as shown
+static unsigned int g_uDecodeSkipPerFrame = 0; // s_skip_per_frame as of then
+
 #define HEADER_BUF_SIZE 200
-static Uint8 g_header_buf[HEADER_BUF_SIZE];
-static uint32_t g_header_buf_size = 0; // size of the header buffer
+static const Uint8 *g_header_buf = NULL; // sequence header of current mpeg
+static uint32_t g_header_buf_size = 0;   // size of the header buffer
+
+// Everything we learn about an mpeg when it is first opened.  These are kept
+// for the life of VLDP so that switching back to a file (multi-segment
+// framefiles do this on nearly every search) only has to swap pointers.
+struct file_index_s {
+    const Uint8 *dat_buf;       // .DAT file image (see dat_index_header)
+    uint64_t dat_size;          // size of dat_buf
+    VLDP_BOOL bDatMapped;       // whether dat_buf is mapped (else malloc'd)
+    const uint64_t *gop_base;   // these point into dat_buf
+    const uint32_t *gop_delta;
+    const uint32_t *gop_frame;
+    uint32_t gop_count;         // how many I frames there are
+    uint32_t total_frames;      // how many frames there are
+    uint64_t length;                   // length of the m2v stream
+    Uint8 uses_fields;                 // whether the stream uses fields
+    Uint8 header_buf[HEADER_BUF_SIZE]; // beginning of the stream
+    uint32_t header_buf_size;          // bytes before the first GOP
+};
+
+static void ivldp_free_index(struct file_index_s *idx);
+
+// keyed by mpeg filename; the loader threads and the private thread both use
+// it, so it is protected by g_index_mutex
+static std::map<std::string, struct file_index_s *> g_file_indexes;
+static SDL_Mutex *g_index_mutex = NULL;
+
+enum { DAT_OK, DAT_MISSING, DAT_OUTDATED };
+
+// how many .DAT files are still being upgraded in the background
+static std::atomic<unsigned int> g_uDatUpgrades(0);
 
 // how many frames we will stall after beginning playback (should be 1, because
 // presumably before we start playing, the disc has been paused showing the same
@@ -123,6 +239,9 @@ static uint32_t g_header_buf_size = 0; // size of the header buffer
 // future research.)
 #define PLAY_FRAME_STALL 1
 
+static void ivldp_decode_init();
+static void ivldp_decode_shutdown();
+
 ////////////////////////////////////////////////
 
 // this is our video thread which gets called
@@ -131,6 +250,8 @@ int idle_handler(void *surface)
     int done = 0;
 
     g_mpeg_data = mpeg2_init();
+    framecache::set_budget(((uint64_t)g_in_info->uFrameCacheMB) << 20);
+    ivldp_decode_init();
 
     // unless we are drawing video to the screen, we just sit here
     // and listen for orders from the parent thread
@@ -203,12 +324,21 @@ int idle_handler(void *surface)
     */
 
     g_out_info.status = STAT_ERROR;
+    ivldp_decode_shutdown();
     mpeg2_close(g_mpeg_data);              // shutdown libmpeg2
+    framecache::clear();
 
     // de-allocate any files that have been precached
     while (s_uPreCacheIdxCount > 0) {
         --s_uPreCacheIdxCount;
-        free(s_sPreCacheEntries[s_uPreCacheIdxCount].ptrBuf);
+        struct precache_entry_s *entry = &s_sPreCacheEntries[s_uPreCacheIdxCount];
+#ifdef VLDP_MMAP
+        if (entry->bMapped) {
+            munmap(entry->ptrBuf, (size_t)entry->uLength);
+            continue;
+        }
+#endif
+        free(entry->ptrBuf);
     }
 
     ivldp_ack_command(); // acknowledge quit command
@@ -372,48 +502,138 @@ void play_handler()
 
 // sets the framerate inside our info structure based upon the framerate code
 // received
-void ivldp_set_framerate(Uint8 frame_rate_code)
+// returns the frames per kilosecond for an mpeg2 frame_rate_code, or 0 if the
+// code is invalid
+static unsigned int ivldp_get_fpks(Uint8 frame_rate_code)
 {
-    // now to compute the framerate
+    unsigned int uFpks = 0;
 
     switch (frame_rate_code) {
     case 1:
-        g_out_info.uFpks = 23976;
+        uFpks = 23976;
         break;
     case 2:
-        g_out_info.uFpks = 24000;
+        uFpks = 24000;
         break;
     case 3:
-        g_out_info.uFpks = 25000;
+        uFpks = 25000;
         break;
     case 4:
-        g_out_info.uFpks = 29970;
+        uFpks = 29970;
         break;
     case 5:
-        g_out_info.uFpks = 30000;
+        uFpks = 30000;
         break;
     case 6:
-        g_out_info.uFpks = 50000;
+        uFpks = 50000;
         break;
     case 7:
-        g_out_info.uFpks = 59940;
+        uFpks = 59940;
         break;
     case 8:
-        g_out_info.uFpks = 60000;
+        uFpks = 60000;
         break;
     default:
-        // else we got an invalid frame rate code
-        LOGE << "ERROR : Invalid frame rate code!";
-        g_out_info.uFpks = 1000; // to avoid divide by 0 error
         break;
     } // end switch
 
+    return uFpks;
+}
+
+void ivldp_set_framerate(Uint8 frame_rate_code)
+{
+    // now to compute the framerate
+    g_out_info.uFpks = ivldp_get_fpks(frame_rate_code);
+
+    // else we got an invalid frame rate code
+    if (g_out_info.uFpks == 0) {
+        LOGE << "ERROR : Invalid frame rate code!";
+        g_out_info.uFpks = 1000; // to avoid divide by 0 error
+    }
+
     // precalculate values that we use over and over again
     g_out_info.u2milDivFpks = 2000000 / g_out_info.uFpks;
 }
 
+// Hands libmpeg2 a free buffer from the pool for the picture (or, at the start
+// of a sequence, the reference frame) it is about to decode.  Called from
+// decode_mpeg2() on whichever thread is decoding.
+// Returns VLDP_FALSE if there is no buffer to give it, in which case the
+// decode is aborted.
+static VLDP_BOOL ivldp_fbuf_set(const mpeg2_info_t *info)
+{
+    struct vldp_fbuf_s *fbuf = NULL;
+    Uint8 *planes[3];
+    size_t uLumaSize   = (size_t)info->sequence->width * info->sequence->height;
+    size_t uChromaSize = (size_t)info->sequence->chroma_width * info->sequence->chroma_height;
+    size_t uSize       = uLumaSize + (uChromaSize << 1);
+    unsigned int u     = 0;
+
+    SDL_LockMutex(g_decode_mutex);
+    for (u = 0; u < VLDP_FBUF_POOL; u++) {
+        if (!g_fbuf_pool[u].bDecoder && (g_fbuf_pool[u].uQueued == 0)) {
+            fbuf = &g_fbuf_pool[u];
+            break;
+        }
+    }
+    assert(fbuf != NULL); // VLDP_FBUF_POOL is too small
+    if (fbuf) fbuf->bDecoder = VLDP_TRUE;
+    SDL_UnlockMutex(g_decode_mutex);
+
+    // nobody else can be looking at a free buffer, so it can be resized
+    // without the lock
+    if (fbuf && (fbuf->uBufSize < uSize)) {
+        mpeg2_free(fbuf->buf);
+        fbuf->buf      = (Uint8 *)mpeg2_malloc(uSize, MPEG2_ALLOC_YUV);
+        fbuf->uBufSize = fbuf->buf ? uSize : 0;
+    }
+
+    if (!fbuf || !fbuf->buf) {
+        LOGE << (fbuf ? "VLDP : out of memory allocating frame buffers"
+                      : "VLDP : ran out of frame buffers");
+
+        // libmpeg2 can't be left to decode into a slot it wasn't given a
+        // buffer for, so it forgets the sequence and the rest of this render
+        // is thrown away
+        SDL_LockMutex(g_decode_mutex);
+        if (fbuf) fbuf->bDecoder = VLDP_FALSE;
+        g_bDecodeFailed = VLDP_TRUE;
+        g_bDecodeAbort  = VLDP_TRUE;
+        SDL_BroadcastCondition(g_decode_cond);
+        SDL_UnlockMutex(g_decode_mutex);
+        mpeg2_reset(g_mpeg_data, 1);
+        return VLDP_FALSE;
+    }
+
+    planes[0] = fbuf->buf;
+    planes[1] = planes[0] + uLumaSize;
+    planes[2] = planes[1] + uChromaSize;
+    mpeg2_set_buf(g_mpeg_data, planes, fbuf);
+
+    // current_fbuf is now the slot our buffer went into, whatever was in it
+    // before belongs to the pool again (slots are only ever added to the end
+    // of g_fbuf_slot, the first time libmpeg2 uses them)
+    SDL_LockMutex(g_decode_mutex);
+    for (u = 0; u < VLDP_FBUF_SLOTS - 1; u++) {
+        if (!g_fbuf_slot[u] || (g_fbuf_slot[u] == info->current_fbuf)) break;
+    }
+    if (g_fbuf_slot_buf[u] && (g_fbuf_slot_buf[u] != fbuf)) {
+        g_fbuf_slot_buf[u]->bDecoder = VLDP_FALSE;
+    }
+    g_fbuf_slot[u]     = info->current_fbuf;
+    g_fbuf_slot_buf[u] = fbuf;
+    SDL_UnlockMutex(g_decode_mutex);
+
+    return VLDP_TRUE;
+}
+
 // decode_mpeg2 function taken from mpeg2dec.c and optimized a bit
-static void decode_mpeg2(uint8_t *current, uint8_t *end)
+// 'output' is handed every picture that is ready to be displayed (pass NULL
+// to throw them away), 'skip' is asked whether each new picture needs to be
+// decoded at all (NULL decodes everything)
+static void decode_mpeg2(uint8_t *current, uint8_t *end,
+                         int (*skip)(const mpeg2_info_t *info),
+                         void (*output)(const mpeg2_info_t *info))
 {
     const mpeg2_info_t *info;
     mpeg2_state_t state;
@@ -428,14 +648,26 @@ static void decode_mpeg2(uint8_t *current, uint8_t *end)
         case STATE_BUFFER:
             return;
         case STATE_SEQUENCE:
+            // libmpeg2 forgets this on every full reset
+            mpeg2_custom_fbuf(g_mpeg_data, 1);
+            if (!ivldp_fbuf_set(info) || !ivldp_fbuf_set(info)) return;
+            break;
+        case STATE_PICTURE:
+            if (!ivldp_fbuf_set(info)) return;
+
+            // the picture still gets output (so frame counting is unaffected),
+            // its contents are just never filled in
+            if (skip) {
+                mpeg2_skip(g_mpeg_data, skip(info));
+            }
             break;
         case STATE_SLICE:
         case STATE_END:
         case STATE_INVALID_END:
             /* draw current picture */
             /* might free frame buffer */
-            if (info->display_fbuf) {
-                draw_frame(info);
+            if (info->display_fbuf && output) {
+                output(info);
             }
             break;
         default:
@@ -444,56 +676,480 @@ static void decode_mpeg2(uint8_t *current, uint8_t *end)
     }     // end endless for loop
 }
 
-/////////////////
+// Guesses what draw_frame() will do with the frame the decoder thread outputs
+// 'uOutput'th in this render (g_decode_mutex must be held).  draw_frame()
+// runs a few frames behind and has the final say: it throws away the first
+// s_frames_to_skip frames, and during multi-speed playback the
+// s_skip_per_frame frames after each one it shows, which it reports through
+// ivldp_decode_anchor().  The guess only decides which B pictures go
+// undecoded; when it turns out wrong, the frame is still counted and the
+// previous picture just stays up for it.
+static int ivldp_frame_fate(uint32_t uOutput)
+{
+    if (uOutput < g_uDecodeLeadSkip) {
+        return FRAME_LEAD_SKIP;
+    }
 
-// Pre-caches sequence header so that vldp_process_sequence_header (and thus any
-// seeks) are faster
-// NOTE: this does change the file position
-void vldp_cache_sequence_header()
+    if ((g_uDecodeSkipPerFrame == 0) || (uOutput <= g_uDecodeAnchor)) {
+        return FRAME_SHOW;
+    }
+
+    return ((uOutput - g_uDecodeAnchor) % (g_uDecodeSkipPerFrame + 1)) ? FRAME_DROP
+                                                                       : FRAME_SHOW;
+}
+
+// called by draw_frame() for each frame it counts as shown, so the decoder
+// thread can line its guesses up with what actually happened
+static void ivldp_decode_anchor(uint32_t uOutput, unsigned int uSkipPerFrame)
 {
-    uint32_t val       = 0;
-    uint32_t index     = 0;
+    SDL_LockMutex(g_decode_mutex);
+    g_uDecodeAnchor       = uOutput;
+    g_uDecodeSkipPerFrame = uSkipPerFrame;
+    SDL_UnlockMutex(g_decode_mutex);
+}
 
-    io_seek(0);                             // start at beginning
-    io_read(g_header_buf, HEADER_BUF_SIZE); // assume that we must find the
-                                            // first frame in this chunk of
-                                            // bytes
-    // if not, we'll have to increase the number
+// called on the decoder thread at the start of each picture, returns 1 if
+// nobody is going to see it
+static int ivldp_skip_picture(const mpeg2_info_t *info)
+{
+    int skip = 0;
+
+    // I and P pictures are needed to decode the ones that follow them
+    if (!info->current_picture ||
+        ((info->current_picture->flags & PIC_MASK_CODING_TYPE) != PIC_FLAG_CODING_TYPE_B)) {
+        return 0;
+    }
+
+    // B pictures are displayed as soon as they are decoded, so this is the
+    // next frame out
+    SDL_LockMutex(g_decode_mutex);
+    skip = (g_bDecodeAbort || (ivldp_frame_fate(g_uDecodeOutputs) != FRAME_SHOW));
+    SDL_UnlockMutex(g_decode_mutex);
+
+    return skip;
+}
+
+// called on the decoder thread for each finished picture; waits for room in
+// the ring and puts a reference to the picture's frame buffer in it
+static void ivldp_ring_push(const mpeg2_info_t *info)
+{
+    struct vldp_frame_s *frame = NULL;
+    uint32_t uOutput = g_uDecodeOutputs++;
+
+    SDL_LockMutex(g_decode_mutex);
+    while ((g_uRingCount == VLDP_FRAME_RING) && !g_bDecodeAbort) {
+        SDL_WaitCondition(g_decode_cond, g_decode_mutex);
+    }
+
+    // nobody wants the rest of this chunk
+    if (g_bDecodeAbort) {
+        SDL_UnlockMutex(g_decode_mutex);
+        return;
+    }
+
+    // the private thread never looks past g_uRingCount, so this slot is ours
+    frame = &g_frame_ring[(g_uRingHead + g_uRingCount) % VLDP_FRAME_RING];
+
+    frame->uOutput = uOutput;
+    frame->bEOF    = VLDP_FALSE;
+
+    // pictures that were never decoded still go through the ring so
+    // draw_frame() can count them
+    if (info->display_picture && (info->display_picture->flags & PIC_FLAG_SKIP)) {
+        frame->fbuf = NULL;
+    } else {
+        // libmpeg2 is finished writing to the buffer by the time it's
+        // displayed, and it stays out of the pool until the ring entry is
+        // popped
+        frame->fbuf = (struct vldp_fbuf_s *)info->display_fbuf->id;
+        ++frame->fbuf->uQueued;
+        frame->Y             = info->display_fbuf->buf[0];
+        frame->U             = info->display_fbuf->buf[1];
+        frame->V             = info->display_fbuf->buf[2];
+        frame->width         = info->sequence->width;
+        frame->height        = info->sequence->height;
+        frame->chroma_width  = info->sequence->chroma_width;
+        frame->chroma_height = info->sequence->chroma_height;
+    }
+
+    ++g_uRingCount;
+    SDL_BroadcastCondition(g_decode_cond);
+    SDL_UnlockMutex(g_decode_mutex);
+}
+
+// gives a ring entry's frame buffer back to the pool (g_decode_mutex must be
+// held)
+static void ivldp_ring_release(struct vldp_frame_s *frame)
+{
+    if (frame->fbuf) {
+        --frame->fbuf->uQueued;
+        frame->fbuf = NULL;
+    }
+}
+
+// gives back a frame buffer that prepare_held_frame was handed (called from
+// the parent thread, or from whichever thread frees the YUV overlay)
+void ivldp_release_frame(void *ref)
+{
+    struct vldp_fbuf_s *fbuf = (struct vldp_fbuf_s *)ref;
+
+    SDL_LockMutex(g_decode_mutex);
+    --fbuf->uQueued;
+    --g_uFbufHeld;
+    SDL_UnlockMutex(g_decode_mutex);
+}
+
+// hands a frame to the parent thread to be shown; frame buffers from the pool
+// are lent out by reference when the parent thread can take them that way
+static int ivldp_prepare_frame(const struct vldp_frame_s *frame)
+{
+    VLDP_BOOL bHold = VLDP_FALSE;
+
+    // stays out of the pool until ivldp_release_frame(), as long as the
+    // parent thread isn't already holding as many as the pool allows for
+    SDL_LockMutex(g_decode_mutex);
+    if (frame->fbuf && g_in_info->prepare_held_frame && (g_uFbufHeld < VLDP_FBUF_HELD)) {
+        ++frame->fbuf->uQueued;
+        ++g_uFbufHeld;
+        bHold = VLDP_TRUE;
+    }
+    SDL_UnlockMutex(g_decode_mutex);
+
+    if (bHold) {
+        return g_in_info->prepare_held_frame(frame->Y, frame->U, frame->V,
+                                             frame->width, frame->chroma_width,
+                                             frame->chroma_width, frame->fbuf);
+    }
+
+    return g_in_info->prepare_frame(frame->Y, frame->U, frame->V, frame->width,
+                                    frame->chroma_width, frame->chroma_width);
+}
+
+// Reads and decodes the stream from wherever it is positioned whenever
+// ivldp_decode_start() asks it to, until the end of the stream or until
+// ivldp_decode_stop().
+static int ivldp_decode_thread(void *data)
+{
+    SDL_LockMutex(g_decode_mutex);
+
+    for (;;) {
+        Uint8 *start            = g_buffer;
+        unsigned int uBytesRead = 0;
+
+        while (g_decode_state == DECODE_IDLE) {
+            SDL_WaitCondition(g_decode_cond, g_decode_mutex);
+        }
+
+        if (g_decode_state == DECODE_QUIT) break;
+
+        SDL_UnlockMutex(g_decode_mutex);
+
+        // memory-backed streams hand back a pointer into the mapping or
+        // precache buffer, file streams are read into g_buffer
+        uBytesRead = io_read_direct(&start, BUFFER_SIZE);
+
+        // A chunk is always decoded to the end, even when we've been told to
+        // stop, so that libmpeg2 is left in the same state it would have been
+        // in if the frames had been shown.
+        if (uBytesRead != 0) {
+            decode_mpeg2(start, start + uBytesRead, ivldp_skip_picture,
+                         ivldp_ring_push);
+        }
+
+        SDL_LockMutex(g_decode_mutex);
+
+        // let the private thread know once it has shown everything before this
+        if (uBytesRead != BUFFER_SIZE) {
+            while ((g_uRingCount == VLDP_FRAME_RING) && !g_bDecodeAbort) {
+                SDL_WaitCondition(g_decode_cond, g_decode_mutex);
+            }
+
+            if (!g_bDecodeAbort) {
+                struct vldp_frame_s *frame =
+                    &g_frame_ring[(g_uRingHead + g_uRingCount) % VLDP_FRAME_RING];
+                frame->fbuf = NULL;
+                frame->bEOF = VLDP_TRUE;
+                ++g_uRingCount;
+            }
+        }
+
+        if ((uBytesRead != BUFFER_SIZE) || g_bDecodeAbort) {
+            g_decode_state = DECODE_IDLE;
+            SDL_BroadcastCondition(g_decode_cond);
+        }
+    }
+
+    SDL_UnlockMutex(g_decode_mutex);
+
+    return 0;
+}
+
+static void ivldp_decode_init()
+{
+    g_decode_mutex  = SDL_CreateMutex();
+    g_decode_cond   = SDL_CreateCondition();
+    g_decode_state  = DECODE_IDLE;
+    g_decode_thread = SDL_CreateThread(ivldp_decode_thread, "vldp decode", NULL);
+
+    if (!g_decode_thread) {
+        LOGE << fmt("VLDP : could not create decoder thread: %s", SDL_GetError());
+    }
+}
+
+static void ivldp_decode_shutdown()
+{
+    unsigned int u = 0;
+
+    if (g_decode_thread) {
+        SDL_LockMutex(g_decode_mutex);
+        g_decode_state = DECODE_QUIT;
+        SDL_BroadcastCondition(g_decode_cond);
+        SDL_UnlockMutex(g_decode_mutex);
+        SDL_WaitThread(g_decode_thread, NULL);
+        g_decode_thread = NULL;
+    }
+
+    // libmpeg2 never frees buffers it was handed with mpeg2_set_buf
+    for (u = 0; u < VLDP_FBUF_POOL; u++) {
+        mpeg2_free(g_fbuf_pool[u].buf);
+        g_fbuf_pool[u].buf      = NULL;
+        g_fbuf_pool[u].uBufSize = 0;
+    }
+
+    SDL_DestroyCondition(g_decode_cond);
+    SDL_DestroyMutex(g_decode_mutex);
+    g_decode_cond  = NULL;
+    g_decode_mutex = NULL;
+}
+
+// starts decoding from the current stream position into an empty ring
+static void ivldp_decode_start()
+{
+    SDL_LockMutex(g_decode_mutex);
+    g_uRingHead       = 0;
+    g_uRingCount      = 0;
+    g_uDecodeOutputs  = 0;
+    g_uDecodeLeadSkip = (s_frames_to_skip > 0) ? (uint32_t)s_frames_to_skip : 0;
+    g_uDecodeAnchor   = g_uDecodeLeadSkip;
+    g_uDecodeSkipPerFrame = s_skip_per_frame;
+    g_bDecodeAbort    = VLDP_FALSE;
+    g_bDecodeFailed   = VLDP_FALSE;
+    g_decode_state    = DECODE_RUN;
+    SDL_BroadcastCondition(g_decode_cond);
+    SDL_UnlockMutex(g_decode_mutex);
+}
+
+// waits for the decoder thread to go idle and throws away anything it decoded
+// that hasn't been shown.  Afterwards g_mpeg_data and the io_* layer are the
+// private thread's again.
+static void ivldp_decode_stop()
+{
+    if (!g_decode_thread) return;
+
+    SDL_LockMutex(g_decode_mutex);
+    g_bDecodeAbort = VLDP_TRUE;
+    SDL_BroadcastCondition(g_decode_cond);
+    while (g_decode_state != DECODE_IDLE) {
+        SDL_WaitCondition(g_decode_cond, g_decode_mutex);
+    }
+    while (g_uRingCount > 0) {
+        ivldp_ring_release(&g_frame_ring[g_uRingHead]);
+        g_uRingHead = (g_uRingHead + 1) % VLDP_FRAME_RING;
+        --g_uRingCount;
+    }
+    g_uRingHead = 0;
+    SDL_UnlockMutex(g_decode_mutex);
+}
+
+// returns the oldest frame in the ring, waiting up to 'timeout_ms' for the
+// decoder thread if the ring is empty, or NULL if there still isn't one
+static const struct vldp_frame_s *ivldp_ring_front(Sint32 timeout_ms)
+{
+    const struct vldp_frame_s *frame = NULL;
+
+    SDL_LockMutex(g_decode_mutex);
+    if (g_uRingCount == 0) {
+        SDL_WaitConditionTimeout(g_decode_cond, g_decode_mutex, timeout_ms);
+    }
+    if (g_uRingCount != 0) {
+        frame = &g_frame_ring[g_uRingHead];
+    }
+    SDL_UnlockMutex(g_decode_mutex);
+
+    return frame;
+}
+
+// returns VLDP_TRUE if the decoder thread gave up because libmpeg2 couldn't be
+// given a frame buffer
+static VLDP_BOOL ivldp_decode_failed()
+{
+    VLDP_BOOL bFailed;
+
+    SDL_LockMutex(g_decode_mutex);
+    bFailed = g_bDecodeFailed;
+    SDL_UnlockMutex(g_decode_mutex);
+
+    return bFailed;
+}
+
+// we are done with the frame that ivldp_ring_front() returned
+static void ivldp_ring_pop()
+{
+    SDL_LockMutex(g_decode_mutex);
+    ivldp_ring_release(&g_frame_ring[g_uRingHead]);
+    g_uRingHead = (g_uRingHead + 1) % VLDP_FRAME_RING;
+    --g_uRingCount;
+    SDL_BroadcastCondition(g_decode_cond);
+    SDL_UnlockMutex(g_decode_mutex);
+}
+
+/////////////////
+
+// Finds how many bytes of the stream come before the first GOP, which is
+// what vldp_process_sequence_header needs to feed libmpeg2 before any seek.
+// Returns VLDP_FALSE if the first GOP isn't within 'uSize' bytes.
+static VLDP_BOOL ivldp_find_first_gop(const Uint8 *buf, uint32_t uSize,
+                                      uint32_t *puHeaderSize)
+{
+    uint32_t val   = 0;
+    uint32_t index = 0;
 
     // go until we have found the first frame or we run out of data
     while (val != 0x000001B8) {
+        if (index >= uSize) return VLDP_FALSE;
         val = val << 8;
-        val |= g_header_buf[index]; // add newest byte to bottom of val
-        index++;                    // advance the end pointer
-        if (index > HEADER_BUF_SIZE) {
-            LOGE << fmt("VLDP : Could not find first frame in 0x%x bytes.  "
-                            "Modify source code to increase buffer!",
-                    HEADER_BUF_SIZE);
-            break;
-        }
+        val |= buf[index]; // add newest byte to bottom of val
+        index++;           // advance the end pointer
     }
 
     // subtract 4 because we stopped when we found the 4 byte header of the
     // first frame
-    g_header_buf_size = index - 4;
+    *puHeaderSize = index - 4;
+    return VLDP_TRUE;
+}
+
+// Pre-caches sequence header so that vldp_process_sequence_header (and thus any
+// seeks) are faster
+// NOTE: this does change the file position
+static void vldp_cache_sequence_header(struct file_index_s *idx)
+{
+    io_seek(0);                                 // start at beginning
+    io_read(idx->header_buf, HEADER_BUF_SIZE);  // assume that we must find
+                                                // the first frame in this
+                                                // chunk of bytes
+    // if not, we'll have to increase the number
+    if (!ivldp_find_first_gop(idx->header_buf, HEADER_BUF_SIZE, &idx->header_buf_size)) {
+        LOGE << fmt("VLDP : Could not find first frame in 0x%x bytes.  "
+                        "Modify source code to increase buffer!",
+                HEADER_BUF_SIZE);
+        idx->header_buf_size = 0;
+    }
 }
 
-// feeds libmpeg2 the beginning of the file up to the first Group of Picture
-// It needs this info to get setup to play from an arbitrary position in the
-// file that isn't the beginning
-// In other words, this is ONLY used when we are seeking to an arbitrary frame
 void vldp_process_sequence_header()
 {
     // decode the pre-cached sequence header
-    decode_mpeg2(g_header_buf, g_header_buf + g_header_buf_size);
+    decode_mpeg2((Uint8 *)g_header_buf, (Uint8 *)g_header_buf + g_header_buf_size,
+                 NULL, NULL);
+}
+
+// Reads the width, height, framerate and aspect ratio out of the sequence
+// header at the start of an mpeg and passes them on.
+// Returns VLDP_FALSE if 'buf' doesn't start with a sequence header.
+static VLDP_BOOL ivldp_apply_stream_header(const Uint8 *buf)
+{
+    int sAspect         = 0;
+    int dCurAspectRatio = 0;
+
+    if (((buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | buf[3]) != 0x000001B3) {
+        return VLDP_FALSE;
+    }
+
+    g_out_info.w = (buf[4] << 4) | (buf[5] >> 4);          // get mpeg width
+    g_out_info.h = ((buf[5] & 0x0F) << 8) | buf[6];        // get mpeg height
+    ivldp_set_framerate(buf[7] & 0xF);                     // set the framerate
+
+    // Look for aspect ratio meta field - thanks to walknight
+    sAspect = buf[7] >> 4;
+
+    switch (sAspect) {
+    case 2:
+       dCurAspectRatio = ASPECTSD;
+       video::set_aspect_change((g_out_info.h * 4) / 3, g_out_info.h);
+       break;
+    case 3:
+       dCurAspectRatio = ASPECTWS;
+       video::set_aspect_change((g_out_info.h * 16) / 9, g_out_info.h);
+       break;
+    default:
+       dCurAspectRatio = (int)(((double)g_out_info.w / g_out_info.h) * 100);
+       break;
+    }
+
+    // Send media info to video::
+    video::set_aspect_ratio(dCurAspectRatio);
+    video::set_detected_height((int)g_out_info.h);
+    video::set_detected_width((int)g_out_info.w);
+
+    return VLDP_TRUE;
+}
+
+// returns the resident index for 'mpeg_name', or NULL if we don't have one
+// (or the file has changed length since it was indexed)
+static struct file_index_s *ivldp_find_index(const char *mpeg_name, uint64_t mpeg_size)
+{
+    struct file_index_s *idx = NULL;
+
+    SDL_LockMutex(g_index_mutex);
+    std::map<std::string, struct file_index_s *>::iterator mi =
+        g_file_indexes.find(mpeg_name);
+    if ((mi != g_file_indexes.end()) && (mi->second->length == mpeg_size)) {
+        idx = mi->second;
+    }
+    SDL_UnlockMutex(g_index_mutex);
+
+    return idx;
+}
+
+// Makes 'idx' the resident index for 'mpeg_name', taking ownership of it.
+// Only the private thread may replace an existing entry (it is the only one
+// that could be using it); otherwise 'idx' is discarded if one exists.
+// Returns VLDP_TRUE if 'idx' was stored.
+static VLDP_BOOL ivldp_store_index(const char *mpeg_name, struct file_index_s *idx,
+                                   VLDP_BOOL bReplace)
+{
+    VLDP_BOOL bStored = VLDP_TRUE;
+
+    SDL_LockMutex(g_index_mutex);
+    struct file_index_s *&slot = g_file_indexes[mpeg_name];
+    if (!slot) {
+        slot = idx;
+    } else if (bReplace) {
+        ivldp_free_index(slot);
+        slot = idx;
+    } else {
+        ivldp_free_index(idx);
+        bStored = VLDP_FALSE;
+    }
+    SDL_UnlockMutex(g_index_mutex);
+
+    return bStored;
+}
+
+// points the seeking code at 'idx'
+static void ivldp_select_index(const struct file_index_s *idx)
+{
+    g_cur_index            = idx;
+    g_totalframes          = idx->total_frames;
+    g_out_info.uses_fields = idx->uses_fields;
+    g_header_buf           = idx->header_buf;
+    g_header_buf_size      = idx->header_buf_size;
 }
 
 // opens a new mpeg2 file
 // The file is positioned at the beginning
 void idle_handler_open()
 {
-    int sAspect = 0;
-    int dCurAspectRatio = 0;
     char req_file[STRSIZE] = {0};
     uint32_t req_idx  = g_req_idx;
     VLDP_BOOL req_precache = g_req_precache;
@@ -531,73 +1187,66 @@ void idle_handler_open()
         bSuccess = io_open_precached(req_idx);
     }
 
+    // frame cache entries are kept per file, so switching back is still a hit
+    if (bSuccess) framecache::set_file(req_file);
+
     // If file was opened successfully, check to make sure it's a video stream
     // and also get framerate
     if (bSuccess) {
-        Uint8 small_buf[8];
-        io_read(small_buf, sizeof(small_buf)); // 1st 8 bytes reveal much
-
-        // if we find the proper mpeg2 video header at the beginning of the file
-        if (((small_buf[0] << 24) | (small_buf[1] << 16) | (small_buf[2] << 8) |
-             small_buf[3]) == 0x000001B3) {
-            g_out_info.w =
-                (small_buf[4] << 4) | (small_buf[5] >> 4); // get mpeg width
-            g_out_info.h =
-                ((small_buf[5] & 0x0F) << 8) | small_buf[6]; // get mpeg height
-            ivldp_set_framerate(small_buf[7] & 0xF); // set the framerate
-
-            // Look for aspect ratio meta field - thanks to walknight
-            sAspect = small_buf[7] >> 4;
-
-            switch (sAspect) {
-            case 2:
-               dCurAspectRatio = ASPECTSD;
-               video::set_aspect_change((g_out_info.h * 4) / 3, g_out_info.h);
-               break;
-            case 3:
-               dCurAspectRatio = ASPECTWS;
-               video::set_aspect_change((g_out_info.h * 16) / 9, g_out_info.h);
-               break;
-            default:
-               dCurAspectRatio = (int)(((double)g_out_info.w / g_out_info.h) * 100);
-               break;
-            }
+        struct file_index_s *idx = ivldp_find_index(req_file, io_length());
 
-            // Send media info to video::
-            video::set_aspect_ratio(dCurAspectRatio);
-            video::set_detected_height((int)g_out_info.h);
-            video::set_detected_width((int)g_out_info.w);
-
-            io_seek(0); // go back to beginning for parser's benefit
+        // if we've seen this file before, everything we need is resident
+        if (idx) {
+            ivldp_apply_stream_header(idx->header_buf);
+        }
+        else {
+            Uint8 small_buf[8];
+            io_read(small_buf, sizeof(small_buf)); // 1st 8 bytes reveal much
+
+            // if we find the proper mpeg2 video header at the beginning of the
+            // file
+            if (ivldp_apply_stream_header(small_buf)) {
+                idx = new struct file_index_s();
+
+                vldp_cache_sequence_header(idx); // cache sequence header for
+                                                 // faster seeking
+
+                io_seek(0); // go back to beginning for parser's benefit
+
+                // load/parse all the frame locations in the file for super
+                // fast seeking
+                if (ivldp_get_mpeg_frame_offsets(req_file, idx)) {
+                    ivldp_store_index(req_file, idx, VLDP_TRUE);
+                } else {
+                    ivldp_free_index(idx);
+                    idx = NULL;
+                    io_close();
+                    LOGE << "VLDP PARSE ERROR : Is the video stream damaged?";
+                    g_out_info.status = STAT_ERROR; // change from BUSY to ERROR
+                }
+            } // end if a proper mpeg header was found
 
-            // load/parse all the frame locations in the file for super fast
-            // seeking
-            if (ivldp_get_mpeg_frame_offsets(req_file)) {
-                g_in_info->report_mpeg_dimensions(g_out_info.w, g_out_info.h); // this function creates the video overlay.
-                // We want to make sure we do this _after_ the frame offsets are
-                // loaded in because graphics are drawn to the main screen if
-                // parsing needs to be done.
+            // if the file had a bad header
+            else {
+                io_close();
+                LOGE << "VLDP ERROR : Did not find expected header.  Is "
+                                "this mpeg stream demultiplexed??";
+                g_out_info.status = STAT_ERROR;
+            }
+        }
 
-                vldp_cache_sequence_header(); // cache sequence header for
-                                              // faster seeking
+        if (idx) {
+            ivldp_select_index(idx);
 
-                io_seek(0); // seek back to beginning of file
+            g_in_info->report_mpeg_dimensions(g_out_info.w, g_out_info.h); // this function creates the video overlay.
+            // We want to make sure we do this _after_ the frame offsets are
+            // loaded in because graphics are drawn to the main screen if
+            // parsing needs to be done.
 
-                g_out_info.status = STAT_STOPPED; // now that the file is open,
-                                                  // we're ready to play
-            } else {
-                io_close();
-                LOGE << "VLDP PARSE ERROR : Is the video stream damaged?";
-                g_out_info.status = STAT_ERROR; // change from BUSY to ERROR
-            }
-        } // end if a proper mpeg header was found
+            io_seek(0); // seek back to beginning of file
 
-        // if the file had a bad header
-        else {
-            io_close();
-            LOGE << "VLDP ERROR : Did not find expected header.  Is "
-                            "this mpeg stream demultiplexed??";
-            g_out_info.status = STAT_ERROR;
+            g_out_info.status = STAT_STOPPED; // now that the file is open,
+                                              // we're ready to play
         }
     } // end if file exists
     else {
@@ -625,75 +1274,111 @@ void idle_handler_precache()
 
     // if we still have room in our array to precache ...
     if (s_uPreCacheIdxCount < MAX_PRECACHE_FILES) {
-        // GET LENGTH OF ACTUAL FILE
-        FILE *F = fopen(req_file, "rb");
-        if (F) {
-            struct stat filestats;
-            fstat(fileno(F), &filestats); // get stats for file to get file
-                                          // length
-            s_sPreCacheEntries[s_uPreCacheIdxCount].uLength = filestats.st_size;
-            s_sPreCacheEntries[s_uPreCacheIdxCount].uPos    = 0; // start at the
-                                                                 // beginning
-
-            // allocate RAM to hold file ...
-            s_sPreCacheEntries[s_uPreCacheIdxCount].ptrBuf = malloc(filestats.st_size);
-
-            // if malloc succeeded
-            if (s_sPreCacheEntries[s_uPreCacheIdxCount].ptrBuf) {
-                unsigned char *u8Ptr =
-                    (unsigned char *)s_sPreCacheEntries[s_uPreCacheIdxCount].ptrBuf;
-                unsigned int uTotalBytesRead = 0;
-                const unsigned int READ_SIZE = 1048576; // how many bytes to
-                                                        // read in at a time
-
-                g_in_info->report_parse_progress(-1); // notify other thread
-                                                      // that we're starting
-
-                // load in the file ...
-                for (;;) {
-                    unsigned int uBytesRead   = 0;
-                    unsigned int uBytesToRead = READ_SIZE;
-                    unsigned int uBytesLeft   = filestats.st_size - uTotalBytesRead;
-
-                    // don't overflow
-                    if (uBytesToRead > uBytesLeft) uBytesToRead = uBytesLeft;
-
-                    uBytesRead = (unsigned int)fread(u8Ptr + uTotalBytesRead, 1,
-                                                     uBytesToRead, F);
-                    uTotalBytesRead += uBytesRead;
-
-                    // if we're done ...
-                    if (uTotalBytesRead >= (unsigned int)filestats.st_size) {
-                        break;
-                    }
+        struct precache_entry_s *entry = &s_sPreCacheEntries[s_uPreCacheIdxCount];
+        const uint64_t READ_SIZE = 1048576; // how many bytes to read (or
+                                            // fault in) at a time
+        uint64_t uTotalBytesRead = 0;
 
-                    // update user on our precache progress
-                    g_in_info->report_parse_progress(
-                        (double)uTotalBytesRead /
-                        s_sPreCacheEntries[s_uPreCacheIdxCount].uLength);
-                }
+        entry->uPos = 0; // start at the beginning
 
-                g_in_info->report_parse_progress(1); // notify other thread that
-                                                     // we're done ...
+        g_in_info->report_parse_progress(-1); // notify other thread that
+                                              // we're starting
 
-                // notify other thread of which index we've used to precache
-                // this file
-                g_out_info.uLastCachedIndex = s_uPreCacheIdxCount;
+        // Try to map the file first.  The page cache then holds the precached
+        // data, so we only need to touch each page once to get it resident.
+        entry->ptrBuf = io_map_file(req_file, &entry->uLength);
+        entry->bMapped = (entry->ptrBuf != NULL) ? VLDP_TRUE : VLDP_FALSE;
 
-                // we're done with this entry, so the count increases
-                // (this must be done after we've read in the file so that the
-                // index is correct for that operation)
-                ++s_uPreCacheIdxCount;
+#ifdef VLDP_MMAP
+        if (entry->bMapped) {
+            volatile const unsigned char *u8Ptr = (const unsigned char *)entry->ptrBuf;
+            long lPage = sysconf(_SC_PAGESIZE);
+            uint64_t uPage = (lPage > 0) ? (uint64_t)lPage : 4096;
+            unsigned char u8Sum = 0;
+
+            madvise(entry->ptrBuf, (size_t)entry->uLength, MADV_WILLNEED);
+
+            while (uTotalBytesRead < entry->uLength) {
+                uint64_t uChunkEnd = uTotalBytesRead + READ_SIZE;
+                if (uChunkEnd > entry->uLength) uChunkEnd = entry->uLength;
+
+                // touch one byte per page to fault the chunk in
+                for (uint64_t u = uTotalBytesRead; u < uChunkEnd; u += uPage) {
+                    u8Sum += u8Ptr[u];
+                }
+                uTotalBytesRead = uChunkEnd;
 
-                g_out_info.status = STAT_STOPPED; // success
+                // update user on our precache progress
+                g_in_info->report_parse_progress((double)uTotalBytesRead /
+                                                 entry->uLength);
             }
-            // else malloc failed
-            else {
-                g_out_info.status = STAT_ERROR;
+            (void)u8Sum;
+        }
+#endif
+
+        // else fall back to reading the whole file into RAM
+        if (!entry->bMapped) {
+            FILE *F = fopen(req_file, "rb");
+            if (F) {
+                struct stat filestats;
+                fstat(fileno(F), &filestats); // get stats for file to get file
+                                              // length
+                entry->uLength = filestats.st_size;
+
+                // allocate RAM to hold file (if it fits in our address space)
+                if (entry->uLength == (uint64_t)(size_t)entry->uLength) {
+                    entry->ptrBuf = malloc((size_t)entry->uLength);
+                }
+
+                // if malloc succeeded
+                if (entry->ptrBuf) {
+                    unsigned char *u8Ptr = (unsigned char *)entry->ptrBuf;
+
+                    // load in the file ...
+                    while (uTotalBytesRead < entry->uLength) {
+                        uint64_t uBytesToRead = entry->uLength - uTotalBytesRead;
+
+                        // don't overflow
+                        if (uBytesToRead > READ_SIZE) uBytesToRead = READ_SIZE;
+
+                        size_t uBytesRead = fread(u8Ptr + uTotalBytesRead, 1,
+                                                  (size_t)uBytesToRead, F);
+
+                        // short read means the file shrank or an error occurred
+                        if (uBytesRead == 0) break;
+                        uTotalBytesRead += uBytesRead;
+
+                        // update user on our precache progress
+                        g_in_info->report_parse_progress((double)uTotalBytesRead /
+                                                         entry->uLength);
+                    }
+
+                    // don't expose a partially read buffer
+                    if (uTotalBytesRead < entry->uLength) {
+                        free(entry->ptrBuf);
+                        entry->ptrBuf = NULL;
+                    }
+                }
+                fclose(F);
             }
-            fclose(F);
         }
-        // else we couldn't open the file
+
+        g_in_info->report_parse_progress(1); // notify other thread that
+                                             // we're done ...
+
+        if (entry->ptrBuf) {
+            // notify other thread of which index we've used to precache
+            // this file
+            g_out_info.uLastCachedIndex = s_uPreCacheIdxCount;
+
+            // we're done with this entry, so the count increases
+            // (this must be done after we've read in the file so that the
+            // index is correct for that operation)
+            ++s_uPreCacheIdxCount;
+
+            g_out_info.status = STAT_STOPPED; // success
+        }
+        // else we couldn't open, map or allocate the file
         else {
             g_out_info.status = STAT_ERROR;
         }
@@ -721,6 +1406,7 @@ void idle_handler_play()
 void ivldp_respond_req_play()
 {
     s_timer = g_req_timer;
+    io_advise_sequential(); // playback reads straight through the stream
 #ifdef VLDP_DEBUG
     LOGI << fmt("ivldp_respond_req_play() : g_req_timer is %u, and "
                     "uMstimer is %u",
@@ -773,8 +1459,8 @@ void ivldp_respond_req_speedchange()
 // search both use this function.
 void ivldp_render()
 {
-    Uint8 *end          = NULL;
     int render_finished = 0;
+    int reached_eof     = 0;
 
 #ifdef VLDP_BENCHMARK
     Uint32 render_start_time  = SDL_GetTicks(); // keep track of when we started
@@ -801,32 +1487,39 @@ void ivldp_render()
                         "none was open!";
         g_out_info.status = STAT_ERROR;
     }
+    // nothing would ever show up in the frame ring
+    else if (!g_decode_thread) {
+        render_finished   = 1;
+        g_out_info.status = STAT_ERROR;
+    }
+
+    if (!render_finished) {
+        ivldp_decode_start();
+    }
 
     // while we're not finished playing and pausing
     while (!render_finished) {
-        // end = g_buffer + fread (g_buffer, 1, BUFFER_SIZE, g_mpeg_handle);
-        end = g_buffer + io_read(g_buffer, BUFFER_SIZE);
-
-        // safety check, they could be equal if we were already at EOF before we
-        // tried this
-        if (g_buffer != end) {
-            // read chunk of video stream
-            decode_mpeg2(g_buffer, end); // display it to the screen
+        // wait (briefly, so commands still get looked at) for the decoder
+        // thread to hand us a frame
+        const struct vldp_frame_s *frame = ivldp_ring_front(1);
+
+        if (frame) {
+            // if we've read to the end of the mpeg2 file, then we can't play
+            // anymore, so we pause on last frame
+            if (frame->bEOF) {
+                g_out_info.status = STAT_STOPPED; // it's a toss-up between this
+                                                  // and STAT_PAUSED
+                render_finished = 1;
+                reached_eof     = 1;
+            } else {
+                draw_frame(frame); // display it to the screen
+            }
+            ivldp_ring_pop();
         }
-
-        // if we've read to the end of the mpeg2 file, then we can't play
-        // anymore, so we pause on last frame
-        if (end != (g_buffer + BUFFER_SIZE)) {
-            g_out_info.status = STAT_STOPPED; // it's a toss-up between this and
-                                              // STAT_PAUSED
-            render_finished = 1;
-
-            // reset libmpeg2 so it is prepared to begin reading from the
-            // beginning of the file
-            mpeg2_reset(g_mpeg_data, 1);
-            io_seek(0);                   // seek to the beginning of the file
-            g_out_info.current_frame = 0; // set frame # to beginning of file
-                                          // where it belongs
+        // nothing more is coming
+        else if (ivldp_decode_failed()) {
+            g_out_info.status = STAT_ERROR;
+            render_finished   = 1;
         }
 
         // if a new command is coming in, check to see if we need to stop
@@ -849,6 +1542,18 @@ void ivldp_render()
         }     // end if they got a new command
     }         // end while
 
+    // libmpeg2 and the stream are ours again once this returns
+    ivldp_decode_stop();
+
+    if (reached_eof) {
+        // reset libmpeg2 so it is prepared to begin reading from the
+        // beginning of the file
+        mpeg2_reset(g_mpeg_data, 1);
+        io_seek(0);                   // seek to the beginning of the file
+        g_out_info.current_frame = 0; // set frame # to beginning of file
+                                      // where it belongs
+    }
+
 #ifdef VLDP_BENCHMARK
     fprintf(F, "Benchmarking result:\n");
     total_frames  = g_out_info.current_frame - render_start_frame;
@@ -866,15 +1571,141 @@ void ivldp_render()
 #endif              // UNIX
 #endif              // VLDP_DEBUG
 
-// searches to any arbitrary frame, be it I, P, or B, and renders it
-// if skip is set, it will do a laserdisc skip instead of a search (ie it will
-// go a frame, resume playback,
-// and not adjust any timers)
-void idle_handler_search(int skip)
+// positions the stream at the I frame that 'uAdjustedReqFrame' must be decoded
+// from, and sets s_frames_to_skip to the number of frames in between
+// (uAdjustedReqFrame must already be bounds checked)
+static void ivldp_seek_to_frame(uint32_t uAdjustedReqFrame)
 {
+    const struct file_index_s *idx = g_cur_index;
+    uint32_t uGop = 0;
     uint64_t proposed_pos = 0;
-    Uint32 req_frame    = g_req_frame; // after we acknowledge the command,
-                                       // g_req_frame could become clobbered
+
+    s_frames_to_skip = s_frames_to_skip_with_inc =
+        0; // the below problem is no longer a problem
+
+    if (idx->gop_count > 0) {
+        // find the last I frame at or before the frame we want
+        uint32_t lo = 0, hi = idx->gop_count;
+        while (hi - lo > 1) {
+            uint32_t mid = lo + ((hi - lo) >> 1);
+            if (idx->gop_frame[mid] <= uAdjustedReqFrame) lo = mid;
+            else hi = mid;
+        }
+        uGop = lo;
+
+        if (idx->gop_frame[uGop] <= uAdjustedReqFrame) {
+            s_frames_to_skip = uAdjustedReqFrame - idx->gop_frame[uGop];
+        }
+
+        // if we are only 2 frames away from an I frame, we will get a
+        // corrupted image and need to go back to
+        // the I frame before this one
+        if ((s_frames_to_skip < 3) && (uGop > 0)) {
+            uGop--;
+            s_frames_to_skip = uAdjustedReqFrame - idx->gop_frame[uGop];
+        }
+
+        proposed_pos = idx->gop_base[uGop / DAT_GOP_BLOCK] + idx->gop_delta[uGop];
+    }
+
+#ifdef VLDP_DEBUG
+    LOGI << fmt("frames_to_skip is %d, I frame is %u", s_frames_to_skip, uGop);
+    LOGI << fmt("position in mpeg2 stream we are seeking to : %" PRIu64, proposed_pos);
+#endif
+
+    io_seek(proposed_pos);
+    io_advise_willneed(proposed_pos);
+}
+
+// Presents a frame found in the frame cache instead of seeking and decoding
+// it, then waits paused like paused_handler() would.  The stream is only
+// positioned (behind the scenes) once playback or stepping resumes.
+static void ivldp_search_cached(const framecache::frame *cached, uint32_t req_frame,
+                                uint32_t uAdjustedReqFrame, Uint32 min_seek_ms)
+{
+    VLDP_BOOL bDone = VLDP_FALSE;
+
+    s_paused  = 1;
+    s_blanked = 0;
+    s_frames_to_skip = s_frames_to_skip_with_inc = 0;
+
+    // if we are to blank during searches ...
+    if (g_in_info->blank_during_searches) {
+        g_in_info->render_blank_frame();
+    }
+
+    // still honor any seek delay the parent thread asked for
+    s_timer = g_in_info->uMsTimer;
+    while (((g_in_info->uMsTimer - s_timer) < min_seek_ms) && !ivldp_got_new_command()) {
+        SDL_Delay(1);
+    }
+
+    if (g_in_info->prepare_frame(cached->Y, cached->U, cached->V, cached->width,
+                                 cached->chroma_width, cached->chroma_width)) {
+        g_in_info->display_frame();
+    }
+
+    g_out_info.current_frame = req_frame;
+    s_uPendingSkipFrame      = 0;
+
+    // same as paused_handler() does after rendering the still frame
+    g_out_info.status        = STAT_PAUSED;
+    s_timer                  = g_in_info->uMsTimer;
+    s_uFramesShownSinceTimer = 1;
+
+    while (!bDone) {
+        if (ivldp_got_new_command()) {
+            switch (g_req_cmdORcount & 0xF0) {
+            case VLDP_REQ_PLAY:
+            case VLDP_REQ_STEP_FORWARD:
+                // now we need the decoder after all; the frame we are on is
+                // already shown so skip it too
+                mpeg2_reset(g_mpeg_data, 0);
+                vldp_process_sequence_header();
+                ivldp_seek_to_frame(uAdjustedReqFrame);
+                s_frames_to_skip++;
+
+                if ((g_req_cmdORcount & 0xF0) == VLDP_REQ_PLAY) {
+                    idle_handler_play();
+                } else {
+                    // still paused, so the next frame drawn is where we stop
+                    ivldp_ack_command();
+                    ivldp_render();
+                }
+                bDone = VLDP_TRUE;
+                break;
+            // let the idle handler take care of these
+            case VLDP_REQ_STOP:
+            case VLDP_REQ_QUIT:
+            case VLDP_REQ_OPEN:
+            case VLDP_REQ_SEARCH:
+            case VLDP_REQ_SKIP:
+                bDone = VLDP_TRUE;
+                break;
+            case VLDP_REQ_SPEEDCHANGE:
+                ivldp_respond_req_speedchange();
+                break;
+            case VLDP_REQ_LOCK:
+                ivldp_lock_handler();
+                break;
+            default: // we're already paused
+                ivldp_ack_command();
+                break;
+            }
+        } else {
+            SDL_Delay(1);
+        }
+    }
+}
+
+// searches to any arbitrary frame, be it I, P, or B, and renders it
+// if skip is set, it will do a laserdisc skip instead of a search (ie it will
+// go a frame, resume playback,
+// and not adjust any timers)
+void idle_handler_search(int skip)
+{
+    Uint32 req_frame    = g_req_frame; // after we acknowledge the command,
+                                       // g_req_frame could become clobbered
     Uint32 min_seek_ms = g_req_min_seek_ms; // g_req_min_seek_ms can be
                                             // clobbered at any time after we
                                             // acknowledge command
@@ -882,9 +1713,6 @@ void idle_handler_search(int skip)
     // adjusted req frame is the requested frame with fields taken into account
     uint32_t uAdjustedReqFrame = 0;
 
-    uint32_t actual_frame      = 0;
-    int skipped_I              = 0;
-
     // status must be changed before acknowledging command, because previous
     // status could be STAT_ERROR, which causes problems with *_and_block vldp
     // API commands.
@@ -935,6 +1763,31 @@ void idle_handler_search(int skip)
 
     ivldp_ack_command(); // acknowledge search/skip command
 
+    s_bCacheCapture = VLDP_FALSE; // a previous search may not have finished
+
+    // adjusted req frame is the requested frame with fields taken into account
+    uAdjustedReqFrame = req_frame;
+
+    // if we're using fields, then the requested frame must be doubled (2 fields
+    // per frame)
+    if (g_out_info.uses_fields) uAdjustedReqFrame <<= 1;
+
+    // still frame searches can be served straight from the frame cache
+    if (!skip && (uAdjustedReqFrame < g_totalframes)) {
+        const framecache::frame *cached = framecache::lookup(uAdjustedReqFrame);
+
+        g_out_info.uFrameCacheHits   = framecache::get_hits();
+        g_out_info.uFrameCacheMisses = framecache::get_misses();
+
+        if (cached) {
+            ivldp_search_cached(cached, req_frame, uAdjustedReqFrame, min_seek_ms);
+            return;
+        }
+
+        s_bCacheCapture      = VLDP_TRUE;
+        s_uCacheCaptureFrame = uAdjustedReqFrame;
+    }
+
     // reset libmpeg2 so it is prepared to start from a new spot
     mpeg2_reset(g_mpeg_data, 0);
 
@@ -982,56 +1835,10 @@ void idle_handler_search(int skip)
         }
     }
 
-    // adjusted req frame is the requested frame with fields taken into account
-    uAdjustedReqFrame = req_frame;
-
-    // if we're using fields, then the requested frame must be doubled (2 fields
-    // per frame)
-    if (g_out_info.uses_fields) uAdjustedReqFrame <<= 1;
-
-    actual_frame = uAdjustedReqFrame;
-
     // do a bounds check
     if (uAdjustedReqFrame < g_totalframes) {
-        proposed_pos = g_frame_position[uAdjustedReqFrame]; // get the proposed
-                                                            // position
-
-#ifdef VLDP_DEBUG
-        LOGI << fmt("Initial proposed position is : %ld", proposed_pos);
-#endif
-
-        s_frames_to_skip = s_frames_to_skip_with_inc =
-            0; // the below problem is no longer a problem
-
-        // loop until we find which position in the file to seek to
-        for (;;) {
-            // if the frame we want is not an I frame, go backward until we find
-            // an I frame, and increase # of frames to skip forward
-            while ((proposed_pos == 0xFFFFFFFFFFFFFFFF) && (actual_frame > 0)) {
-                s_frames_to_skip++;
-                actual_frame--;
-                proposed_pos = g_frame_position[actual_frame];
-            }
-            skipped_I++;
-
-            // if we are only 2 frames away from an I frame, we will get a
-            // corrupted image and need to go back to
-            // the I frame before this one
-            if ((skipped_I < 2) && (s_frames_to_skip < 3) && (actual_frame > 0)) {
-                proposed_pos = 0xFFFFFFFFFFFFFFFF;
-            } else {
-                break;
-            }
-        }
-
-#ifdef VLDP_DEBUG
-        LOGI << fmt("frames_to_skip is %d, skipped_I is %d", s_frames_to_skip, skipped_I);
-        LOGI << fmt("position in mpeg2 stream we are seeking to : %ld", proposed_pos);
-#endif
-
-        io_seek(proposed_pos);
         // go to the place in the stream where the I frame begins
-        // fseek(g_mpeg_handle, proposed_pos, SEEK_SET);
+        ivldp_seek_to_frame(uAdjustedReqFrame);
 
         // if we're seeking, we can change the frame right now ...
         if (!skip) {
@@ -1060,14 +1867,279 @@ void idle_handler_search(int skip)
 
 // parses an mpeg video stream to get its frame offsets, or if the parsing had
 // taken place earlier
-VLDP_BOOL ivldp_get_mpeg_frame_offsets(char *mpeg_name)
+// computes where each array of a DAT_VERSION 4 file starts, returns its size
+static uint64_t ivldp_dat_layout(uint32_t uGopCount, uint64_t *puBase,
+                                 uint64_t *puDelta, uint64_t *puFrame)
+{
+    uint64_t uBlocks = ((uint64_t)uGopCount + DAT_GOP_BLOCK - 1) / DAT_GOP_BLOCK;
+
+    *puBase  = sizeof(struct dat_header) + sizeof(struct dat_index_header);
+    *puDelta = *puBase + (uBlocks * 8);
+    *puFrame = *puDelta + ((uint64_t)uGopCount * 4);
+    return *puFrame + ((uint64_t)uGopCount * 4);
+}
+
+// frees a .DAT image, whether it is mapped or not
+static void ivldp_free_dat(const Uint8 *buf, uint64_t uSize, VLDP_BOOL bMapped)
+{
+    if (!buf) return;
+#ifdef VLDP_MMAP
+    if (bMapped) {
+        munmap((void *)buf, (size_t)uSize);
+        return;
+    }
+#endif
+    free((void *)buf);
+}
+
+static void ivldp_free_index(struct file_index_s *idx)
+{
+    if (idx) {
+        ivldp_free_dat(idx->dat_buf, idx->dat_size, idx->bDatMapped);
+        delete idx;
+    }
+}
+
+// Points 'idx' at the arrays inside a DAT_VERSION 4 image (taking ownership of
+// it) if the image is complete and matches the mpeg.
+static VLDP_BOOL ivldp_attach_dat(struct file_index_s *idx, const Uint8 *buf,
+                                  uint64_t uSize, VLDP_BOOL bMapped,
+                                  uint64_t mpeg_size, uint32_t header_crc)
+{
+    const struct dat_header *header = (const struct dat_header *)buf;
+    const struct dat_index_header *index =
+        (const struct dat_index_header *)(buf + sizeof(struct dat_header));
+    uint64_t uBase, uDelta, uFrame;
+
+    if ((uSize < sizeof(*header) + sizeof(*index)) || (header->version != DAT_VERSION) ||
+        (header->finished != 1) || (header->length != mpeg_size) ||
+        (index->header_crc != header_crc) ||
+        (ivldp_dat_layout(index->gop_count, &uBase, &uDelta, &uFrame) != uSize)) {
+        return VLDP_FALSE;
+    }
+
+    ivldp_free_dat(idx->dat_buf, idx->dat_size, idx->bDatMapped);
+    idx->dat_buf      = buf;
+    idx->dat_size     = uSize;
+    idx->bDatMapped   = bMapped;
+    idx->gop_base     = (const uint64_t *)(buf + uBase);
+    idx->gop_delta    = (const uint32_t *)(buf + uDelta);
+    idx->gop_frame    = (const uint32_t *)(buf + uFrame);
+    idx->gop_count    = index->gop_count;
+    idx->total_frames = index->total_frames;
+    idx->length       = mpeg_size;
+    idx->uses_fields  = header->uses_fields;
+
+    return VLDP_TRUE;
+}
+
+// Converts the per-frame entries of a DAT_VERSION_FRAMES file (0xFFFFFFFFFFFFFFFF
+// for anything that isn't an I frame) into a DAT_VERSION 4 image.
+// Returns a malloc'd image, or NULL on failure.
+static Uint8 *ivldp_convert_dat(const struct dat_header *old_header,
+                                const uint64_t *positions, uint32_t uFrames,
+                                uint32_t header_crc, uint64_t *puSize)
+{
+    uint32_t uGopCount = 0;
+    uint32_t i         = 0;
+    uint64_t uBase, uDelta, uFrame;
+
+    for (i = 0; i < uFrames; i++) {
+        if (positions[i] != 0xFFFFFFFFFFFFFFFF) uGopCount++;
+    }
+
+    *puSize = ivldp_dat_layout(uGopCount, &uBase, &uDelta, &uFrame);
+    Uint8 *buf = (Uint8 *)calloc(1, (size_t)*puSize);
+    if (!buf) return NULL;
+
+    struct dat_header *header       = (struct dat_header *)buf;
+    struct dat_index_header *index  = (struct dat_index_header *)(buf + sizeof(*header));
+    uint64_t *gop_base              = (uint64_t *)(buf + uBase);
+    uint32_t *gop_delta             = (uint32_t *)(buf + uDelta);
+    uint32_t *gop_frame             = (uint32_t *)(buf + uFrame);
+    uint32_t uGop                   = 0;
+
+    header->version      = DAT_VERSION;
+    header->finished     = 1;
+    header->uses_fields  = old_header->uses_fields;
+    header->length       = old_header->length;
+    index->header_crc    = header_crc;
+    index->total_frames  = uFrames;
+    index->gop_count     = uGopCount;
+
+    for (i = 0; i < uFrames; i++) {
+        if (positions[i] == 0xFFFFFFFFFFFFFFFF) continue;
+
+        // each block of I frames is stored relative to its first entry
+        if ((uGop % DAT_GOP_BLOCK) == 0) {
+            gop_base[uGop / DAT_GOP_BLOCK] = positions[i];
+        }
+
+        uint64_t uOffset = positions[i] - gop_base[uGop / DAT_GOP_BLOCK];
+
+        // I frames have to be in order and no more than 4GB apart per block
+        if ((positions[i] < gop_base[uGop / DAT_GOP_BLOCK]) || (uOffset > 0xFFFFFFFF)) {
+            LOGE << "VLDP : frame index can't be stored in the compact .DAT format";
+            free(buf);
+            return NULL;
+        }
+
+        gop_delta[uGop] = (uint32_t)uOffset;
+        gop_frame[uGop] = i;
+        uGop++;
+    }
+
+    return buf;
+}
+
+// writes a .DAT image next to 'datafilename' and then swaps it in, so that
+// whatever was there before stays usable if we get interrupted
+static VLDP_BOOL ivldp_write_dat(const char *datafilename, const Uint8 *buf, uint64_t uSize)
+{
+    char tmpfilename[STRSIZE + 4] = {0};
+    VLDP_BOOL result = VLDP_FALSE;
+    FILE *F = NULL;
+
+    snprintf(tmpfilename, sizeof(tmpfilename), "%s.tmp", datafilename);
+    F = fopen(tmpfilename, "wb");
+
+    if (F) {
+        size_t uWritten = fwrite(buf, 1, (size_t)uSize, F);
+        if ((fclose(F) == 0) && (uWritten == uSize)) {
+#ifdef WIN32
+            // rename won't replace a file on win32
+            result = MoveFileExA(tmpfilename, datafilename, MOVEFILE_REPLACE_EXISTING)
+                         ? VLDP_TRUE : VLDP_FALSE;
+#else
+            result = (rename(tmpfilename, datafilename) == 0) ? VLDP_TRUE : VLDP_FALSE;
+#endif
+        }
+        if (!result) remove(tmpfilename);
+    }
+
+    return result;
+}
+
+struct dat_upgrade_s {
+    char datafilename[STRSIZE];
+    Uint8 *buf;
+    uint64_t uSize;
+};
+
+// rewrites a DAT_VERSION_FRAMES file in the current format
+static int ivldp_dat_upgrade_thread(void *data)
+{
+    struct dat_upgrade_s *job = (struct dat_upgrade_s *)data;
+
+    if (!ivldp_write_dat(job->datafilename, job->buf, job->uSize)) {
+        LOGW << fmt("VLDP : could not replace %s", job->datafilename);
+    }
+
+    free(job->buf);
+    delete job;
+    --g_uDatUpgrades;
+    return 0;
+}
+
+// Reads 'datafilename' into 'idx', provided the .DAT is complete and was made
+// from an mpeg of 'mpeg_size' bytes whose first HEADER_BUF_SIZE bytes have a
+// CRC32 of 'header_crc'.  Current files are mapped and used in place; files
+// in the older per-frame format are converted and rewritten in the background.
+// Returns DAT_OK, DAT_MISSING or DAT_OUTDATED.
+static int ivldp_read_dat(const char *datafilename, uint64_t mpeg_size,
+                          uint32_t header_crc, struct file_index_s *idx)
+{
+    int result       = DAT_OUTDATED;
+    uint64_t uSize   = 0;
+    VLDP_BOOL bMapped = VLDP_TRUE;
+    Uint8 *buf       = (Uint8 *)io_map_file(datafilename, &uSize);
+
+    // fall back to reading it in if it can't be mapped
+    if (!buf) {
+        FILE *data_file = fopen(datafilename, "rb"); // check to see if
+                                                     // datafile exists
+        struct stat filestats;
+
+        if (!data_file) {
+            return DAT_MISSING;
+        }
+
+        bMapped = VLDP_FALSE;
+        if (fstat(fileno(data_file), &filestats) == 0) {
+            uSize = filestats.st_size;
+            buf   = (Uint8 *)malloc((size_t)uSize + 1); // +1 so empty works
+            if (buf && (fread(buf, 1, (size_t)uSize, data_file) != uSize)) {
+                free(buf);
+                buf = NULL;
+            }
+        }
+        fclose(data_file);
+
+        if (!buf) return DAT_OUTDATED;
+    }
+
+    const struct dat_header *header = (const struct dat_header *)buf;
+
+    // if version, file size, or finished are wrong, the dat file is no
+    // good and has to be regenerated
+    if (ivldp_attach_dat(idx, buf, uSize, bMapped, mpeg_size, header_crc)) {
+        return DAT_OK;
+    }
+    else if ((uSize >= sizeof(*header)) && (header->version == DAT_VERSION_FRAMES) &&
+             (header->finished == 1) && (header->length == mpeg_size)) {
+        // the frame positions are everything after the header
+        uint64_t uFrames      = (uSize - sizeof(*header)) / 8;
+        uint64_t uNewSize     = 0;
+        Uint8 *newbuf = NULL;
+
+        if (uFrames <= 0xFFFFFFFF) {
+            newbuf = ivldp_convert_dat(header, (const uint64_t *)(buf + sizeof(*header)),
+                                       (uint32_t)uFrames, header_crc, &uNewSize);
+        }
+
+        if (newbuf && ivldp_attach_dat(idx, newbuf, uNewSize, VLDP_FALSE, mpeg_size,
+                                       header_crc)) {
+            struct dat_upgrade_s *job = new struct dat_upgrade_s;
+
+            SAFE_STRCPY(job->datafilename, datafilename, sizeof(job->datafilename));
+            job->uSize = uNewSize;
+            job->buf   = (Uint8 *)malloc((size_t)uNewSize);
+
+            if (job->buf) {
+                memcpy(job->buf, newbuf, (size_t)uNewSize);
+                ++g_uDatUpgrades;
+
+                SDL_Thread *thread =
+                    SDL_CreateThread(ivldp_dat_upgrade_thread, "vldp dat", job);
+                if (thread) {
+                    SDL_DetachThread(thread);
+                } else {
+                    ivldp_dat_upgrade_thread(job);
+                }
+            } else {
+                delete job;
+            }
+            result = DAT_OK;
+        } else {
+            free(newbuf);
+        }
+    }
+#ifdef VLDP_DEBUG
+    else {
+        LOGI << fmt("DAT version is %d", header->version);
+    }
+#endif
+
+    ivldp_free_dat(buf, uSize, bMapped);
+    return result;
+}
+
+VLDP_BOOL ivldp_get_mpeg_frame_offsets(char *mpeg_name, struct file_index_s *idx)
 {
     char datafilename[320]       = {0};
     VLDP_BOOL mpeg_datafile_good = VLDP_FALSE;
-    FILE *data_file              = NULL;
     VLDP_BOOL result             = VLDP_TRUE;
     uint64_t mpeg_size           = 0;
-    struct dat_header header;
 
     // GET LENGTH OF ACTUAL FILE
     mpeg_size = io_length();
@@ -1076,194 +2148,413 @@ VLDP_BOOL ivldp_get_mpeg_frame_offsets(char *mpeg_name)
     SAFE_STRCPY(datafilename, mpeg_name, sizeof(datafilename));
     strcpy(&datafilename[strlen(mpeg_name) - 3], "dat");
 
+    // the .DAT remembers a checksum of the stream header, so that a different
+    // m2v of the same length isn't mistaken for the one it was made from
+    uint32_t header_crc = (uint32_t)crc32(0L, idx->header_buf, HEADER_BUF_SIZE);
+
     // loop until we get a good datafile or until we get an error
     while (!mpeg_datafile_good && result) {
-        data_file = fopen(datafilename, "rb"); // check to see if datafile
-                                               // exists
-
+        switch (ivldp_read_dat(datafilename, mpeg_size, header_crc, idx)) {
         // If file cannot be opened, try to create it.
         // Most likely the file cannot be opened because it doesn't exist.
-        if (!data_file) {
-            result = ivldp_parse_mpeg_frame_offsets(datafilename, mpeg_size);
-            // we could open the file here, but there is no need to because we
-            // will loop back through and open the file anyway
+        case DAT_MISSING:
+            result = ivldp_parse_mpeg_frame_offsets(datafilename, mpeg_name, mpeg_size,
+                                                    header_crc);
+            // we could read the file here, but there is no need to because we
+            // will loop back through and read the file anyway
+            break;
+        case DAT_OUTDATED:
+            LOGW << fmt("MPEG data file %s is outdated and has "
+                        "to be created again!", datafilename);
+
+            // try to delete obsolete .DAT file so we can create a modern
+            // one
+            if (remove(datafilename) == -1) {
+                LOGE << "Couldn't delete obsolete .DAT file!";
+                result = VLDP_FALSE;
+            }
+            break;
+        default:
+            mpeg_datafile_good = VLDP_TRUE; // escape the loop
+            break;
         }
+    }     // end while we don't have a good datafile and haven't gotten an error
 
-        // else if the file has been opened
-        else {
-            // now that file exists and we have it open, we have to read it
-
-            fseek(data_file, 0L, SEEK_SET);
-            // read .DAT file header
-            size_t sizeRead = fread(&header, sizeof(header), 1, data_file);
-
-            // if version, file size, or finished are wrong, the dat file is no
-            // good and has to be regenerated
-            if ((sizeRead != 1) || (header.length != mpeg_size) ||
-                (header.version != DAT_VERSION) || (header.finished != 1)) {
 #ifdef VLDP_DEBUG
-                LOGI << fmt("DAT version is %d", header.version);
+    if (result) {
+        FILE *tmp_F = fopen(FRAMELOG, "wb");
+        for (uint32_t i = 0; tmp_F && (i < idx->gop_count); i++) {
+            fprintf(tmp_F, "Frame %u has offset of %" PRIu64 "\n", idx->gop_frame[i],
+                    idx->gop_base[i / DAT_GOP_BLOCK] + idx->gop_delta[i]);
+        }
+        if (tmp_F) fclose(tmp_F);
+        LOGI << fmt("*** total frames is %u, I frames %u", idx->total_frames,
+                    idx->gop_count);
+    }
 #endif
-                LOGW << fmt("MPEG data file %s is outdated and has "
-                            "to be created again!", datafilename);
-                fclose(data_file);
-                data_file = NULL;
-
-                // try to delete obsolete .DAT file so we can create a modern
-                // one
-                if (remove(datafilename) == -1) {
-                    LOGE << "Couldn't delete obsolete .DAT file!";
-                    result = VLDP_FALSE;
-                }
-            } else {
-                g_out_info.uses_fields = header.uses_fields;
-                mpeg_datafile_good     = VLDP_TRUE; // escape the loop
-            }
-        } // end if mpeg parsing was not necessary
-    }     // end while we don't have a good datafile and haven't gotten an error
 
-    // if we didn't exit the loop because of an error, then we need to read the
-    // datafile
-    if (result && data_file) {
-        g_totalframes = 0;
+    return result;
+}
 
-#ifdef VLDP_DEBUG
-        unlink(FRAMELOG);
-#endif
+// builds the index for an mpeg that already has a current .DAT file, without
+// going through the private thread (so it can be done from any thread).
+// Returns NULL if the file can't be read or still needs to be parsed.
+static struct file_index_s *ivldp_load_file_index(const char *mpeg_name)
+{
+    struct file_index_s *idx = NULL;
+    char datafilename[STRSIZE] = {0};
+    FILE *F = fopen(mpeg_name, "rb");
+    struct stat filestats;
 
-        // read all the frame positions
-        // if we don't read 8 bytes, it means we've hit the EOF and we're done
-        while (fread(&g_frame_position[g_totalframes], 8, 1, data_file) == 1) {
-#ifdef VLDP_DEBUG
-            FILE *tmp_F = fopen(FRAMELOG, "ab");
-            fprintf(tmp_F, "Frame %d has offset of %ld\n", g_totalframes,
-                    g_frame_position[g_totalframes]);
-            fclose(tmp_F);
-#endif
-            g_totalframes++;
-
-            // safety check, it is possible to make mpegs with too many frames
-            // to fit onto one CAV laserdisc
-            // (in fact I did this, and it caused a lot of problems in the debug
-            // stages hehe)
-            if (g_totalframes >= MAX_LDP_FRAMES) {
-                LOGE << fmt("ERROR : Current mpeg has a huge number of frames, "
-                                "VLDP will ignore any frame above %u",
-                                MAX_LDP_FRAMES);
-                break;
-            }
+    if (!F) return NULL;
+
+    idx = new struct file_index_s();
+
+    SAFE_STRCPY(datafilename, mpeg_name, sizeof(datafilename));
+    strcpy(&datafilename[strlen(datafilename) - 3], "dat");
+
+    if ((fstat(fileno(F), &filestats) != 0) ||
+        (fread(idx->header_buf, 1, HEADER_BUF_SIZE, F) != HEADER_BUF_SIZE) ||
+        (((idx->header_buf[0] << 24) | (idx->header_buf[1] << 16) |
+          (idx->header_buf[2] << 8) | idx->header_buf[3]) != 0x000001B3) ||
+        !ivldp_find_first_gop(idx->header_buf, HEADER_BUF_SIZE, &idx->header_buf_size) ||
+        (ivldp_read_dat(datafilename, filestats.st_size,
+                        (uint32_t)crc32(0L, idx->header_buf, HEADER_BUF_SIZE),
+                        idx) != DAT_OK)) {
+        ivldp_free_index(idx);
+        idx = NULL;
+    }
+
+    fclose(F);
+    return idx;
+}
+
+struct index_job_s {
+    const char **filenames;
+    unsigned int uCount;
+    std::atomic<unsigned int> uNext;   // next filename to be loaded
+    std::atomic<unsigned int> uLoaded; // how many indexes were stored
+};
+
+static int ivldp_index_worker(void *data)
+{
+    struct index_job_s *job = (struct index_job_s *)data;
+    unsigned int i;
+
+    while ((i = job->uNext++) < job->uCount) {
+        // if it is already resident, the one we load gets discarded
+        struct file_index_s *idx = ivldp_load_file_index(job->filenames[i]);
+        if (idx && ivldp_store_index(job->filenames[i], idx, VLDP_FALSE)) {
+            ++job->uLoaded;
         }
-#ifdef VLDP_DEBUG
-        LOGI << fmt("*** g_totalframes is %u", g_totalframes);
-        LOGI << fmt("And frame 0's offset is %ld", g_frame_position[0]);
-#endif
     }
 
-    // close any files that are still open
-    if (data_file) {
-        fclose(data_file);
+    return 0;
+}
+
+// Loads the indexes of all the given mpegs on a few worker threads
+// (called from the parent thread)
+unsigned int ivldp_load_indexes(const char **filenames, unsigned int uCount)
+{
+    const unsigned int MAX_INDEX_WORKERS = 8;
+    SDL_Thread *workers[MAX_INDEX_WORKERS];
+    unsigned int uWorkers = 0;
+    unsigned int i        = 0;
+    struct index_job_s job;
+    int iCores = SDL_GetNumLogicalCPUCores();
+
+    job.filenames = filenames;
+    job.uCount    = uCount;
+    job.uNext     = 0;
+    job.uLoaded   = 0;
+
+    uWorkers = (iCores > 1) ? (unsigned int)iCores : 1;
+    if (uWorkers > MAX_INDEX_WORKERS) uWorkers = MAX_INDEX_WORKERS;
+    if (uWorkers > uCount) uWorkers = uCount;
+
+    for (i = 0; i < uWorkers; i++) {
+        workers[i] = SDL_CreateThread(ivldp_index_worker, "vldp index", &job);
     }
 
-    return result;
+    // if a thread couldn't be created, its share gets done by the others
+    // (or by us)
+    ivldp_index_worker(&job);
+
+    for (i = 0; i < uWorkers; i++) {
+        if (workers[i]) SDL_WaitThread(workers[i], NULL);
+    }
+
+    return job.uLoaded;
 }
 
-VLDP_BOOL ivldp_parse_mpeg_frame_offsets(char *datafilename, uint64_t mpeg_size)
+// returns the stream information of an mpeg whose index is resident
+VLDP_BOOL ivldp_get_file_info(const char *filename, struct vldp_file_info *info)
 {
-    VLDP_BOOL result = VLDP_TRUE;
-    FILE *data_file  = fopen(datafilename, "wb"); // create file
-    struct dat_header header; // header to put inside .DAT file
+    VLDP_BOOL bResult = VLDP_FALSE;
 
-    // if we could create the file successfully, then we need to populate it
-    if (data_file) {
-        uint64_t pos     = 0; // position in the file
-        int count        = 0;
-        int parse_result = 0;
+    SDL_LockMutex(g_index_mutex);
+    std::map<std::string, struct file_index_s *>::iterator mi =
+        g_file_indexes.find(filename);
+    if (mi != g_file_indexes.end()) {
+        const Uint8 *buf   = mi->second->header_buf;
+        info->w            = (buf[4] << 4) | (buf[5] >> 4);
+        info->h            = ((buf[5] & 0x0F) << 8) | buf[6];
+        info->uFpks        = ivldp_get_fpks(buf[7] & 0xF);
+        info->uses_fields  = mi->second->uses_fields;
+        info->uTotalFrames = mi->second->total_frames;
+        bResult            = VLDP_TRUE;
+    }
+    SDL_UnlockMutex(g_index_mutex);
 
-        header.version     = DAT_VERSION;
-        header.finished    = 0;
-        header.uses_fields = 0;
-        header.length = mpeg_size;
-        fwrite(&header, sizeof(header), 1, data_file);
-        // first thing that goes in the file is the .DAT header
-        // That way we can re-use the file another time with confidence that
-        // it's the right one
+    return bResult;
+}
 
-        mpegscan::init();
+void ivldp_index_init()
+{
+    g_index_mutex = SDL_CreateMutex();
+}
 
-        g_in_info->report_parse_progress(-1); // notify other thread that we're
-                                              // starting
+// frees all the resident indexes (the private thread must have exited)
+void ivldp_index_shutdown()
+{
+    std::map<std::string, struct file_index_s *>::iterator mi;
+
+    for (mi = g_file_indexes.begin(); mi != g_file_indexes.end(); ++mi) {
+        ivldp_free_index(mi->second);
+    }
+    g_file_indexes.clear();
+    g_cur_index  = NULL;
+    g_header_buf = NULL;
+
+    // let any .DAT upgrades finish so we don't leave them half written
+    while (g_uDatUpgrades > 0) {
+        SDL_Delay(1);
+    }
+
+    SDL_DestroyMutex(g_index_mutex);
+    g_index_mutex = NULL;
+}
 
-        // keep reading the file while there is a file left to be read
-        do {
 #define PARSE_CHUNK 200000
 
-            parse_result = mpegscan::parse(data_file, PARSE_CHUNK);
-            pos += PARSE_CHUNK;
+#ifdef VLDP_BENCHMARK
+// runs both the original byte-by-byte parser and the parallel scanner over
+// the open mpeg, checks that they agree and reports how fast each one was
+static void ivldp_benchmark_mpeg_parse(const char *mpeg_name, uint64_t mpeg_size)
+{
+    FILE *ref_file   = tmpfile();
+    FILE *par_file   = tmpfile();
+    Uint64 ref_ms    = 0;
+    Uint64 par_ms    = 0;
+    int ref_result   = 0;
+    int par_result   = 0;
+    bool identical   = true;
+
+    if (ref_file && par_file) {
+        Uint64 start = SDL_GetTicks();
+        mpegscan::init();
+        io_seek(0);
+        do {
+            ref_result = mpegscan::parse(ref_file, PARSE_CHUNK);
+        } while (ref_result == mpegscan::IN_PROGRESS);
+        ref_ms = SDL_GetTicks() - start;
 
-            // we want to give the user updates but don't want to flood them
-            if (count > 10) {
-                count = 0;
+        start      = SDL_GetTicks();
+        par_result = mpegscan::parse_parallel(mpeg_name, mpeg_size, par_file, NULL);
+        par_ms     = SDL_GetTicks() - start;
 
-                // report progress to parent thread
-                g_in_info->report_parse_progress((double)pos / mpeg_size);
+        rewind(ref_file);
+        rewind(par_file);
+        for (;;) {
+            int a = getc(ref_file);
+            if (a != getc(par_file)) {
+                identical = false;
+                break;
+            }
+            if (a == EOF) break;
+        }
+
+        double mb = mpeg_size / 1048576.0;
+        LOGI << fmt("mpeg parse benchmark: serial %.1f MB/s (%u ms), parallel "
+                    "%.1f MB/s (%u ms), results %s",
+                    ref_ms ? (mb * 1000.0) / ref_ms : 0.0, (unsigned int)ref_ms,
+                    par_ms ? (mb * 1000.0) / par_ms : 0.0, (unsigned int)par_ms,
+                    (identical && (ref_result == par_result)) ? "identical" : "DIFFER");
+    }
+
+    if (ref_file) fclose(ref_file);
+    if (par_file) fclose(par_file);
+}
+#endif
+
+VLDP_BOOL ivldp_parse_mpeg_frame_offsets(char *datafilename, const char *mpeg_name,
+                                         uint64_t mpeg_size, uint32_t header_crc)
+{
+    VLDP_BOOL result = VLDP_FALSE;
+    FILE *frame_file = tmpfile(); // the parser's per-frame entries go here
+    struct dat_header header; // describes the entries to ivldp_convert_dat
+
+    if (frame_file) {
+        int parse_result = 0;
+
+        g_in_info->report_parse_progress(-1); // notify other thread that we're
+                                              // starting
+
+        // the parallel scanner has to agree with the original parser before we
+        // trust it with the stream (this only takes a few ms)
+        static int s_iParallelOK = -1;
+        if (s_iParallelOK < 0) {
+            char chkfilename[STRSIZE + 4] = {0};
+            snprintf(chkfilename, sizeof(chkfilename), "%s.chk", datafilename);
+            s_iParallelOK = mpegscan::self_check(chkfilename) ? 1 : 0;
+            if (!s_iParallelOK) {
+                LOGW << "VLDP : parallel mpeg parser failed its self check, "
+                        "using the serial one";
             }
-            count++;
+        }
 
-        } while (parse_result == mpegscan::IN_PROGRESS);
+        if (s_iParallelOK) {
+            // scan the whole stream for start codes on a pool of worker threads
+            parse_result = mpegscan::parse_parallel(mpeg_name, mpeg_size, frame_file,
+                                                    g_in_info->report_parse_progress);
+        } else {
+            uint64_t pos = 0;
+
+            mpegscan::init();
+            io_seek(0);
+            do {
+                parse_result = mpegscan::parse(frame_file, PARSE_CHUNK);
+                pos += PARSE_CHUNK;
+                g_in_info->report_parse_progress((double)pos / mpeg_size);
+            } while (parse_result == mpegscan::IN_PROGRESS);
+        }
+
+#ifdef VLDP_BENCHMARK
+        ivldp_benchmark_mpeg_parse(mpeg_name, mpeg_size);
+#endif
 
         g_in_info->report_parse_progress(1); // notify other thread that we're
                                              // done
 
-        // if parse finished, then we have to update the header
         if (parse_result != mpegscan::ERROR) {
+            long lSize       = ftell(frame_file);
+            uint64_t *positions = (lSize > 0) ? (uint64_t *)malloc((size_t)lSize) : NULL;
+            uint32_t uFrames = (uint32_t)(lSize / 8);
+            uint64_t uSize   = 0;
+            Uint8 *buf       = NULL;
+
+            header.version     = DAT_VERSION_FRAMES;
             header.finished    = 1;
-            header.uses_fields = 0;
-            if (parse_result == mpegscan::FINISHED_FIELDS) {
-                header.uses_fields = 1;
+            header.uses_fields = (parse_result == mpegscan::FINISHED_FIELDS) ? 1 : 0;
+            header.length      = mpeg_size;
+
+            // only the I frames are kept, in the compact format that gets mapped
+            rewind(frame_file);
+            if (positions && (fread(positions, 8, uFrames, frame_file) == uFrames)) {
+                buf = ivldp_convert_dat(&header, positions, uFrames, header_crc, &uSize);
+            }
+
+            if (buf) {
+                result = ivldp_write_dat(datafilename, buf, uSize);
+                if (!result) {
+                    LOGE << fmt("Could not create file %s", datafilename);
+                    LOGE << "This probably means you don't have permission to "
+                                    "create the file";
+                }
+            } else {
+                LOGE << "Couldn't build the .DAT index for the MPEG file.";
             }
-            fseek(data_file, 0L, SEEK_SET);
-            fwrite(&header, sizeof(header), 1, data_file); // save changes
+
+            free(buf);
+            free(positions);
         }
 
-        // we have to close data file because it's write-only
-        // and it needs to be re-opened read-only
-        fclose(data_file);
-        data_file = NULL;
+        fclose(frame_file);
 
         // if the mpeg did not finish parsing gracefully, we've got problems
-        /* NOTE: I separated this from the other if above to guarantee that the
-         * file gets closed
-         */
         if (parse_result == mpegscan::ERROR) {
             LOGE << "There was an error parsing the MPEG file.";
             LOGE << "Either there is a bug in the parser or the MPEG "
                             "file is corrupt.";
             LOGE << "OR the user aborted the decoding process :)";
-            result = VLDP_FALSE;
-            remove(datafilename);
         }
-    } // end if we could create the file successfully
-
-    // we couldn't create data file which means no write permission probably
-    // this is probably a good time to shut VLDP down =]
+    }
     else {
-        LOGE << fmt("Could not create file %s", datafilename);
-        LOGE << "This probably means you don't have permission to "
-                        "create the file";
-        result = VLDP_FALSE;
+        LOGE << "Could not create a temporary file to parse the MPEG file into";
     }
 
     return result;
 }
 
+// maps a whole file read-only, returns NULL if it can't be mapped
+void *io_map_file(const char *cpszFilename, uint64_t *puLength)
+{
+    void *ptrMap = NULL;
+
+#ifdef VLDP_MMAP
+    int fd = open(cpszFilename, O_RDONLY);
+    if (fd != -1) {
+        struct stat filestats;
+
+        // empty files can't be mapped, and neither can files larger than our
+        // address space (32-bit builds)
+        if ((fstat(fd, &filestats) == 0) && (filestats.st_size > 0) &&
+            ((uint64_t)filestats.st_size == (uint64_t)(size_t)filestats.st_size)) {
+            ptrMap = mmap(NULL, (size_t)filestats.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptrMap == MAP_FAILED) {
+                ptrMap = NULL;
+            } else {
+                *puLength = filestats.st_size;
+            }
+        }
+        close(fd); // the mapping stays valid after the descriptor is closed
+    }
+#else
+    (void)cpszFilename;
+    (void)puLength;
+#endif
+
+    return ptrMap;
+}
+
+// returns the memory-backed stream we are reading from, or NULL if we are
+// reading from g_mpeg_handle (or nothing is open)
+static struct precache_entry_s *io_mem_entry()
+{
+    struct precache_entry_s *entry = NULL;
+
+    if (s_bPreCacheEnabled) {
+        entry = &s_sPreCacheEntries[s_uCurPreCacheIdx];
+    } else if (s_bMapEnabled) {
+        entry = &s_sMapEntry;
+    }
+    return entry;
+}
+
 VLDP_BOOL io_open(const char *cpszFilename)
 {
     VLDP_BOOL bResult = VLDP_FALSE;
 
     // make sure everything is closed
-    if ((!s_bPreCacheEnabled) && (!g_mpeg_handle)) {
-        g_mpeg_handle = fopen(cpszFilename, "rb");
-        if (g_mpeg_handle) bResult = VLDP_TRUE;
+    if (!io_is_open()) {
+        s_sMapEntry.ptrBuf = io_map_file(cpszFilename, &s_sMapEntry.uLength);
+
+        if (s_sMapEntry.ptrBuf) {
+            s_sMapEntry.uPos    = 0;
+            s_sMapEntry.bMapped = VLDP_TRUE;
+            s_bMapEnabled       = VLDP_TRUE;
+            bResult             = VLDP_TRUE;
+            s_uRandomLen        = 0;
+#ifdef VLDP_MMAP
+            // playback streams through it, searches are the exception
+            madvise(s_sMapEntry.ptrBuf, (size_t)s_sMapEntry.uLength, MADV_SEQUENTIAL);
+#endif
+        }
+        // else fall back to buffered reads
+        else {
+            g_mpeg_handle = fopen(cpszFilename, "rb");
+            if (g_mpeg_handle) bResult = VLDP_TRUE;
+        }
     }
     return bResult;
 }
@@ -1273,7 +2564,7 @@ VLDP_BOOL io_open_precached(uint32_t uIdx)
     VLDP_BOOL bResult = VLDP_FALSE;
 
     // make sure everything is closed
-    if ((!g_mpeg_handle) && (!s_bPreCacheEnabled)) {
+    if (!io_is_open()) {
         // make sure index is within range ...
         if (uIdx < s_uPreCacheIdxCount) {
             bResult                                    = VLDP_TRUE;
@@ -1289,23 +2580,39 @@ VLDP_BOOL io_open_precached(uint32_t uIdx)
 
 unsigned int io_read(void *buf, unsigned int uBytesToRead)
 {
-    unsigned int uBytesRead = 0;
+    Uint8 *ptrSrc           = (Uint8 *)buf;
+    unsigned int uBytesRead = io_read_direct(&ptrSrc, uBytesToRead);
+
+    // memory-backed streams don't copy, so do it here
+    if (ptrSrc != buf) {
+        memcpy(buf, ptrSrc, uBytesRead);
+    }
+
+    return uBytesRead;
+}
+
+// Reads up to uBytesToRead bytes of the stream.  File streams are read into
+// *ppBuf; memory-backed streams (mapped or precached) instead point *ppBuf
+// straight at the data, which stays valid until io_close().
+unsigned int io_read_direct(Uint8 **ppBuf, unsigned int uBytesToRead)
+{
+    unsigned int uBytesRead        = 0;
+    struct precache_entry_s *entry = io_mem_entry();
 
     // if we're reading from a file stream
     if (g_mpeg_handle) {
-        uBytesRead = (unsigned int)fread(buf, 1, uBytesToRead, g_mpeg_handle);
+        uBytesRead = (unsigned int)fread(*ppBuf, 1, uBytesToRead, g_mpeg_handle);
     }
-    // else we're reading from a precache stream
-    else {
-        struct precache_entry_s *entry = &s_sPreCacheEntries[s_uCurPreCacheIdx];
-        unsigned int uBytesLeft        = entry->uLength - entry->uPos;
+    // else we're reading from memory
+    else if (entry) {
+        uint64_t uBytesLeft = entry->uLength - entry->uPos;
 
         // if we're trying to read beyond our means ...
         if (uBytesToRead > uBytesLeft) {
-            uBytesToRead = uBytesLeft;
+            uBytesToRead = (unsigned int)uBytesLeft;
         }
 
-        memcpy(buf, ((unsigned char *)entry->ptrBuf) + entry->uPos, uBytesToRead);
+        *ppBuf     = ((Uint8 *)entry->ptrBuf) + entry->uPos;
         uBytesRead = uBytesToRead;
         entry->uPos += uBytesRead;
     }
@@ -1315,7 +2622,8 @@ unsigned int io_read(void *buf, unsigned int uBytesToRead)
 
 VLDP_BOOL io_seek(uint64_t uPos)
 {
-    VLDP_BOOL bResult = VLDP_FALSE;
+    VLDP_BOOL bResult              = VLDP_FALSE;
+    struct precache_entry_s *entry = io_mem_entry();
 
     if (g_mpeg_handle) {
 #if defined(_FILE_OFFSET_BITS) && _FILE_OFFSET_BITS == 64
@@ -1327,9 +2635,7 @@ VLDP_BOOL io_seek(uint64_t uPos)
 #endif
             bResult = VLDP_TRUE;
         }
-    } else {
-        struct precache_entry_s *entry = &s_sPreCacheEntries[s_uCurPreCacheIdx];
-
+    } else if (entry) {
         // if we're seeking within bounds ...
         if (uPos < entry->uLength) {
             entry->uPos = uPos;
@@ -1346,6 +2652,12 @@ void io_close()
         g_mpeg_handle = NULL;
     } else if (s_bPreCacheEnabled) {
         s_bPreCacheEnabled = VLDP_FALSE;
+    } else if (s_bMapEnabled) {
+#ifdef VLDP_MMAP
+        munmap(s_sMapEntry.ptrBuf, (size_t)s_sMapEntry.uLength);
+#endif
+        s_sMapEntry.ptrBuf = NULL;
+        s_bMapEnabled      = VLDP_FALSE;
     }
     // else nothing is open ...
 }
@@ -1353,7 +2665,7 @@ void io_close()
 VLDP_BOOL io_is_open()
 {
     VLDP_BOOL bResult = VLDP_FALSE;
-    if ((g_mpeg_handle) || (s_bPreCacheEnabled)) {
+    if ((g_mpeg_handle) || (s_bPreCacheEnabled) || (s_bMapEnabled)) {
         bResult = VLDP_TRUE;
     }
     return bResult;
@@ -1361,26 +2673,89 @@ VLDP_BOOL io_is_open()
 
 uint64_t io_length()
 {
-    uint64_t uResult = 0;
+    uint64_t uResult               = 0;
+    struct precache_entry_s *entry = io_mem_entry();
 
     if (g_mpeg_handle) {
         struct stat the_stat;
         fstat(fileno(g_mpeg_handle), &the_stat);
         uResult = the_stat.st_size;
-    } else if (s_bPreCacheEnabled) {
-        uResult = s_sPreCacheEntries[s_uCurPreCacheIdx].uLength;
+    } else if (entry) {
+        uResult = entry->uLength;
     }
 
     return uResult;
 }
 
-void draw_frame(const mpeg2_info_t *info)
+#ifdef VLDP_MMAP
+// returns the mapping of the open stream, or NULL if it isn't mapped or is
+// precached (precached files are already resident, so advice is wasted on them)
+static struct precache_entry_s *io_stream_map()
+{
+    return (s_bMapEnabled && !s_bPreCacheEnabled) ? &s_sMapEntry : NULL;
+}
+#endif
+
+// tells the kernel we are about to stream through the mapping from here on
+void io_advise_sequential()
+{
+#ifdef VLDP_MMAP
+    struct precache_entry_s *entry = io_stream_map();
+
+    // only the window a search changed needs to be put back
+    if (entry && (s_uRandomLen != 0)) {
+        madvise((Uint8 *)entry->ptrBuf + s_uRandomStart, (size_t)s_uRandomLen,
+                MADV_SEQUENTIAL);
+        s_uRandomLen = 0;
+    }
+#endif
+}
+
+// asks the kernel to start faulting in the pages following a seek target so
+// the decoder doesn't stall on them one at a time
+void io_advise_willneed(uint64_t uPos)
+{
+#ifdef VLDP_MMAP
+    struct precache_entry_s *entry = io_stream_map();
+
+    if (entry && (uPos < entry->uLength)) {
+        static long s_lPage = 0;
+        if (s_lPage <= 0) s_lPage = sysconf(_SC_PAGESIZE);
+        if (s_lPage <= 0) s_lPage = 4096;
+
+        uint64_t uStart = uPos - (uPos % (uint64_t)s_lPage); // must be page aligned
+        uint64_t uLen   = (uPos - uStart) + SEARCH_READAHEAD;
+        if (uStart + uLen > entry->uLength) uLen = entry->uLength - uStart;
+
+        // the previous search's window goes back to sequential read-ahead
+        io_advise_sequential();
+
+        // searches jump around, so don't read ahead past the frames we need
+        madvise((Uint8 *)entry->ptrBuf + uStart, (size_t)uLen, MADV_RANDOM);
+        madvise((Uint8 *)entry->ptrBuf + uStart, (size_t)uLen, MADV_WILLNEED);
+        s_uRandomStart = uStart;
+        s_uRandomLen   = uLen;
+    }
+#else
+    (void)uPos;
+#endif
+}
+
+void draw_frame(const struct vldp_frame_s *frame)
 {
     Sint32 correct_elapsed_ms = 0;
     Sint32 actual_elapsed_ms  = 0;
     unsigned int uStallFrames = 0;
 
     if (!(s_frames_to_skip | s_skip_all)) {
+        // this is the frame we searched to, so remember it for next time
+        if (s_bCacheCapture && frame->fbuf) {
+            s_bCacheCapture = VLDP_FALSE;
+            framecache::store(s_uCacheCaptureFrame, frame->Y, frame->U, frame->V,
+                              frame->width, frame->height, frame->chroma_width,
+                              frame->chroma_height);
+        }
+
         do {
             VLDP_BOOL bFrameNotShownDueToCmd = VLDP_FALSE;
 
@@ -1393,14 +2768,9 @@ void draw_frame(const mpeg2_info_t *info)
             s_extra_delay_ms = 0;
 
             if (actual_elapsed_ms < (correct_elapsed_ms + (Sint32)g_out_info.u2milDivFpks)) {
-                int bPrepared = g_in_info->prepare_frame(
-                        info->display_fbuf->buf[0],
-                        info->display_fbuf->buf[1],
-                        info->display_fbuf->buf[2],
-                        info->sequence->width,
-                        info->sequence->chroma_width,
-                        info->sequence->chroma_width
-                    );
+                // the decoder thread guessed wrong and never decoded this
+                // one, so the last picture stays up in its place
+                int bPrepared = frame->fbuf ? ivldp_prepare_frame(frame) : 1;
                 if (bPrepared) {
 #ifndef VLDP_BENCHMARK
                     while (((Sint32)(g_in_info->uMsTimer - s_timer) < correct_elapsed_ms) &&
@@ -1453,6 +2823,8 @@ void draw_frame(const mpeg2_info_t *info)
                                     s_frames_to_skip = s_frames_to_skip_with_inc =
                                         s_skip_per_frame;
                                 }
+
+                                ivldp_decode_anchor(frame->uOutput, s_skip_per_frame);
                             }
                         } else {
                             g_out_info.current_frame = s_uPendingSkipFrame;
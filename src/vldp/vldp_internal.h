@@ -30,7 +30,11 @@
 #include <mpeg2.h>
 
 // this is which version of the .dat file format we are using
-#define DAT_VERSION 3
+#define DAT_VERSION 4
+
+// the older format (one entry per frame, which is also what the parser
+// produces); files still in it get converted when they are loaded
+#define DAT_VERSION_FRAMES 3
 
 // header for the .DAT files that are generated
 struct dat_header {
@@ -40,10 +44,42 @@ struct dat_header {
     uint64_t length;     // length of the m2v stream
 };
 
+// Follows dat_header in DAT_VERSION 4 files.  Only I frames are indexed: the
+// header is followed by
+//   uint64_t gop_base[(gop_count + DAT_GOP_BLOCK - 1) / DAT_GOP_BLOCK];
+//   uint32_t gop_delta[gop_count]; // position minus its block's gop_base
+//   uint32_t gop_frame[gop_count]; // frame number, ascending
+// so the file can be mapped and used as is.
+#define DAT_GOP_BLOCK 64
+struct dat_index_header {
+    uint32_t header_crc;   // CRC32 of the first bytes of the m2v stream
+    uint32_t total_frames; // frames (or fields) in the m2v stream
+    uint32_t gop_count;    // how many I frames are indexed
+    uint32_t reserved;
+};
+
 struct precache_entry_s {
-    void *ptrBuf;         // buffer that holds precached file
-    uint32_t uLength; // length (in bytes) of the buffer
-    uint32_t uPos;    // our current position within the stream
+    void *ptrBuf;       // buffer that holds precached file
+    uint64_t uLength;   // length (in bytes) of the buffer
+    uint64_t uPos;      // our current position within the stream
+    VLDP_BOOL bMapped;  // whether ptrBuf is a file mapping (else malloc'd)
+};
+
+struct vldp_fbuf_s;
+
+// a picture that the decoder thread has finished with, waiting to be shown
+struct vldp_frame_s {
+    Uint8 *Y;             // planes, these point into fbuf
+    Uint8 *U;
+    Uint8 *V;
+    unsigned int width;
+    unsigned int height;
+    unsigned int chroma_width;
+    unsigned int chroma_height;
+    struct vldp_fbuf_s *fbuf; // decoder frame buffer the picture lives in
+                          // (NULL if libmpeg2 was told to skip it)
+    uint32_t uOutput;     // which frame of the render this is (from 0)
+    VLDP_BOOL bEOF;       // not a picture, the decoder reached the end of the stream
 };
 
 int idle_handler(void *surface);
@@ -63,19 +99,30 @@ void ivldp_respond_req_pause_or_step();
 void ivldp_respond_req_speedchange();
 void ivldp_render();
 void idle_handler_search(int skip);
-VLDP_BOOL ivldp_get_mpeg_frame_offsets(char *mpeg_name);
-VLDP_BOOL ivldp_parse_mpeg_frame_offsets(char *datafilename, uint64_t mpeg_size);
+struct file_index_s;
+VLDP_BOOL ivldp_get_mpeg_frame_offsets(char *mpeg_name, struct file_index_s *idx);
+unsigned int ivldp_load_indexes(const char **filenames, unsigned int uCount);
+VLDP_BOOL ivldp_get_file_info(const char *filename, struct vldp_file_info *info);
+void ivldp_index_init();
+void ivldp_index_shutdown();
+VLDP_BOOL ivldp_parse_mpeg_frame_offsets(char *datafilename, const char *mpeg_name,
+                                         uint64_t mpeg_size, uint32_t header_crc);
 void ivldp_update_progress_indicator(SDL_Surface *indicator, double percentage_completed);
 
+void *io_map_file(const char *cpszFilename, uint64_t *puLength);
 VLDP_BOOL io_open(const char *cpszFilename);
 VLDP_BOOL io_open_precached(uint32_t uIdx);
 unsigned int io_read(void *buf, unsigned int uBytesToRead);
+unsigned int io_read_direct(Uint8 **ppBuf, unsigned int uBytesToRead);
 VLDP_BOOL io_seek(uint64_t uPos);
 void io_close();
 VLDP_BOOL io_is_open();
 uint64_t io_length();
+void io_advise_sequential();
+void io_advise_willneed(uint64_t uPos);
 
-void draw_frame(const mpeg2_info_t *info);
+void draw_frame(const struct vldp_frame_s *frame);
+void ivldp_release_frame(void *ref);
 
 ///////////////////////////////////////
 